@@ -20,6 +20,7 @@ LOCAL_SRC_FILES := \
 	src/gl/arbhelper.c \
 	src/gl/arbparser.c \
 	src/gl/array.c \
+	src/gl/batch2d.c \
 	src/gl/blend.c \
 	src/gl/blit.c \
 	src/gl/buffers.c \
@@ -53,6 +54,7 @@ LOCAL_SRC_FILES := \
 	src/gl/logs.c \
 	src/gl/matrix.c \
 	src/gl/matvec.c \
+	src/gl/nullgles.c \
 	src/gl/oldprogram.c \
 	src/gl/pixel.c \
 	src/gl/planes.c \
@@ -67,11 +69,14 @@ LOCAL_SRC_FILES := \
 	src/gl/shaderconv.c \
 	src/gl/shader_hacks.c \
 	src/gl/stack.c \
+	src/gl/stats.c \
 	src/gl/stencil.c \
 	src/gl/string_utils.c \
 	src/gl/stubs.c \
 	src/gl/texenv.c \
+	src/gl/texasync.c \
 	src/gl/texgen.c \
+	src/gl/texthreads.c \
 	src/gl/texture.c \
 	src/gl/texture_compressed.c \
 	src/gl/texture_params.c \
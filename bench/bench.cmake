@@ -0,0 +1,11 @@
+# Extract a trace archive and replay it with gl4es_bench
+if(NOT BENCH OR NOT TRACE OR NOT TEST_FILENAME)
+    message(FATAL_ERROR "BENCH, TRACE and TEST_FILENAME are required.")
+endif()
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar xf ${TRACE})
+execute_process(COMMAND ${BENCH} ${TEST_FILENAME}.trace RESULT_VARIABLE result)
+file(REMOVE ${TEST_FILENAME}.trace)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "gl4es_bench failed on ${TEST_FILENAME}: ${result}")
+endif()
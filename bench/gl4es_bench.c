@@ -0,0 +1,739 @@
+// gl4es_bench: replay apitrace captures through gl4es on top of the null GLES backend
+// (LIBGL_NULLGLES), and report the CPU cost of gl4es itself.
+//
+// usage: gl4es_bench [-l loops] [-s frames] [-c size] [-L libGL.so] file.trace...
+//        gl4es_bench -p [-l loops] [-L libGL.so]
+
+#include <alloca.h>
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "GL/gl.h"
+#include "gl4esinit.h"
+#include "khash.h"
+#include "trace.h"
+
+#if !defined(__x86_64__) && !defined(__aarch64__)
+#error gl4es_bench only knows how to call GL functions with the x86_64 and aarch64 calling conventions
+#endif
+
+#ifndef GL4ES_BENCH_LIB
+#define GL4ES_BENCH_LIB "libGL.so"
+#endif
+
+// need to match nullgles_counters_t from src/gl/nullgles.h
+typedef struct {
+    unsigned long calls;
+    unsigned long draws;
+    unsigned long vertices;
+    unsigned long texbytes;
+    unsigned long bufbytes;
+    unsigned long programs;
+    unsigned long frames;
+    unsigned long vcache_triangles;
+    unsigned long vcache_misses;
+} null_counters_t;
+
+static void* (*get_proc_address)(const char *name) = NULL;
+static void (*nullgles_getcounters)(null_counters_t *counters) = NULL;
+static void (*get_stats)(gl4es_stats_t *last_frame, gl4es_stats_t *total) = NULL;
+static void (*stats_endframe)() = NULL;
+static GLboolean (*pixel_convert_bench)(const GLvoid *src, GLvoid **dst, GLuint width, GLuint height,
+                   GLenum src_format, GLenum src_type, GLenum dst_format, GLenum dst_type, GLint generic) = NULL;
+
+// ********* Allocations counting *********
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+// gl4es is built with hidden visibility, the replacements have to be visible to libGL
+#define INTERPOSE __attribute__((visibility("default")))
+
+static int counting = 0;
+static unsigned long alloc_count = 0;
+static unsigned long alloc_bytes = 0;
+
+INTERPOSE void *malloc(size_t size) {
+    if(counting) { ++alloc_count; alloc_bytes += size; }
+    return __libc_malloc(size);
+}
+INTERPOSE void *calloc(size_t n, size_t size) {
+    if(counting) { ++alloc_count; alloc_bytes += n*size; }
+    return __libc_calloc(n, size);
+}
+INTERPOSE void *realloc(void *ptr, size_t size) {
+    if(counting) { ++alloc_count; alloc_bytes += size; }
+    return __libc_realloc(ptr, size);
+}
+#define COUNT_ALLOCS(a) counting = a
+#else
+static unsigned long alloc_count = 0;
+static unsigned long alloc_bytes = 0;
+#define COUNT_ALLOCS(a)
+#endif
+
+// ********* Replay *********
+
+// everything is passed in 16 integer and 8 floating point registers / stack slots: the callee
+// only looks at the ones it needs (valid for the x86_64 SysV and aarch64 calling conventions)
+#define MAX_INT 16
+#define MAX_FP  8
+typedef uintptr_t (*dispatch_t)(uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t,
+                                uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t,
+                                double, double, double, double, double, double, double, double);
+
+typedef enum {
+    MAP_NONE = 0,
+    MAP_TEXTURE,
+    MAP_LIST,
+    MAP_BUFFER,
+    MAP_PROGRAM,
+    MAP_FRAMEBUFFER,
+    MAP_RENDERBUFFER,
+    MAP_LOCATION,
+    MAP_LAST
+} map_t;
+
+typedef enum {
+    KIND_CALL = 0,
+    KIND_SWAP,
+    KIND_MEMCPY,
+    KIND_SKIP
+} kind_t;
+
+typedef enum {
+    GEN_NONE = 0,
+    GEN_OUTPUT,     // glGen*(n, names)
+    GEN_RET,        // glCreateProgram / glCreateShader
+    GEN_LISTS,      // glGenLists(range)
+    GEN_LOCATION,   // glGetUniformLocation(program, name)
+    GEN_POINTER,    // glMapBuffer*
+    GEN_USEPROGRAM  // glUseProgram(program)
+} gen_t;
+
+typedef struct {
+    uint64_t    value;
+    uint32_t    count;  // number of GLuint to remap (array), or size of the output buffer
+    uint8_t     fp;     // 1 = float, 2 = double
+    uint8_t     map;
+    uint8_t     array;
+    uint8_t     output;
+} bench_arg_t;
+
+typedef struct {
+    kind_t          kind;
+    gen_t           gen;
+    int             draw;
+    int             gen_arg;
+    void            *func;
+    int             nargs;
+    bench_arg_t     *args;
+    trace_call_t    *call;
+    uint32_t        outsize;
+} bench_call_t;
+
+typedef struct {
+    uint64_t trace;
+    uint64_t actual;
+} mapped_ptr_t;
+
+KHASH_MAP_INIT_INT(names, uint32_t)
+KHASH_MAP_INIT_INT64(locations, int32_t)
+
+typedef struct {
+    bench_call_t    *calls;
+    int             ncalls;
+    int             cap;
+    int             frames;
+    int             draws;
+    int             skipped;
+    int             missing;
+    // replay state
+    khash_t(names)  *maps[MAP_LAST];
+    khash_t(locations) *locations;
+    uint32_t        cur_program;
+    mapped_ptr_t    pointers[32];
+    int             npointers;
+    char            *scratch;
+    size_t          scratch_size;
+} bench_t;
+
+static const char* names_program[] = {"program", "programs", "shader", "shaders", "obj", "programObj", "shaderObj", "containerObj", "attachedObj", NULL};
+
+static map_t map_for_arg(const char *fname, const char *name) {
+    if(!strcmp(name, "texture") || !strcmp(name, "textures"))
+        return MAP_TEXTURE;
+    if(!strcmp(name, "list") || (!strcmp(name, "base") && !strcmp(fname, "glListBase")))
+        return MAP_LIST;
+    if(!strcmp(name, "buffer") || !strcmp(name, "buffers"))
+        return MAP_BUFFER;
+    if(!strcmp(name, "framebuffer") || !strcmp(name, "framebuffers"))
+        return MAP_FRAMEBUFFER;
+    if(!strcmp(name, "renderbuffer") || !strcmp(name, "renderbuffers"))
+        return MAP_RENDERBUFFER;
+    if(!strcmp(name, "location"))
+        return MAP_LOCATION;
+    for (int i=0; names_program[i]; ++i)
+        if(!strcmp(name, names_program[i]))
+            return MAP_PROGRAM;
+    return MAP_NONE;
+}
+
+static int starts_with(const char *s, const char *prefix) {
+    return strncmp(s, prefix, strlen(prefix))==0;
+}
+
+static int ends_with(const char *s, const char *suffix) {
+    size_t l = strlen(s), ls = strlen(suffix);
+    return l>=ls && !strcmp(s+l-ls, suffix);
+}
+
+static int is_draw(const char *name) {
+    return starts_with(name, "glDraw") || starts_with(name, "glMultiDraw") || starts_with(name, "glCallList")
+        || starts_with(name, "glRect") || !strcmp(name, "glEnd") || !strcmp(name, "glBitmap");
+}
+
+// size of the integer elements of an array argument, from the function name
+static int int_size(const char *fname, trace_call_t *call) {
+    char name[100];
+    strncpy(name, fname, sizeof(name)-1);
+    name[sizeof(name)-1] = '\0';
+    // remove extension suffix
+    size_t l = strlen(name);
+    while(l && name[l-1]>='A' && name[l-1]<='Z') name[--l] = '\0';
+    if(!strcmp(name, "glCallLists")) {
+        for (int i=0; i<call->sig->num_args; ++i)
+            if(!strcmp(call->sig->arg_names[i], "type") && call->args[i]) {
+                switch(call->args[i]->i) {
+                    case 0x1400: case 0x1401: return 1;   // GL_BYTE, GL_UNSIGNED_BYTE
+                    case 0x1402: case 0x1403: return 2;   // GL_SHORT, GL_UNSIGNED_SHORT
+                }
+            }
+        return 4;
+    }
+    if(ends_with(name, "ubv") || ends_with(name, "bv") || !strcmp(name, "glEdgeFlagv"))
+        return 1;
+    if(ends_with(name, "usv") || ends_with(name, "sv"))
+        return 2;
+    return 4;
+}
+
+static uint64_t prepare_value(bench_t *b, trace_call_t *call, trace_value_t *v, uint8_t *fp);
+
+static void* prepare_array(bench_t *b, trace_call_t *call, trace_value_t *v) {
+    if(!v->array.len)
+        return NULL;
+    trace_value_t *e = &v->array.values[0];
+    int size;
+    switch(e->type) {
+        case TV_FLOAT: size = 4; break;
+        case TV_DOUBLE: size = 8; break;
+        case TV_STRING: case TV_WSTRING: case TV_BLOB: case TV_ARRAY: case TV_OPAQUE: case TV_NULL: size = sizeof(void*); break;
+        default: size = int_size(call->sig->name, call);
+    }
+    char *data = (char*)calloc(v->array.len, size);
+    for (size_t i=0; i<v->array.len; ++i) {
+        uint8_t fp = 0;
+        uint64_t value = prepare_value(b, call, &v->array.values[i], &fp);
+        if(size==8 && fp==1) {
+            // mix of float and double should not happen
+            double d;
+            float f;
+            memcpy(&f, &value, 4);
+            d = f;
+            memcpy(&value, &d, 8);
+        }
+        memcpy(data+i*size, &value, size);
+    }
+    return data;
+}
+
+static uint64_t prepare_value(bench_t *b, trace_call_t *call, trace_value_t *v, uint8_t *fp) {
+    uint64_t r = 0;
+    switch(v->type) {
+        case TV_TRUE: return 1;
+        case TV_SINT:
+        case TV_ENUM: return (uint64_t)v->i;
+        case TV_UINT:
+        case TV_BITMASK:
+        case TV_OPAQUE: return v->u;
+        case TV_FLOAT: *fp = 1; memcpy(&r, &v->f, 4); return r;
+        case TV_DOUBLE: *fp = 2; memcpy(&r, &v->d, 8); return r;
+        case TV_STRING:
+        case TV_WSTRING:
+        case TV_BLOB: return (uintptr_t)v->blob.data;
+        case TV_ARRAY: return (uintptr_t)prepare_array(b, call, v);
+        case TV_REPR: return prepare_value(b, call, &v->array.values[1], fp);
+        default: return 0;
+    }
+}
+
+static size_t output_size(trace_call_t *call, trace_value_t *v) {
+    const char *name = call->sig->name;
+    if(!strcmp(name, "glReadPixels") || starts_with(name, "glGetTexImage") || starts_with(name, "glGetCompressedTexImage"))
+        return 64<<20;
+    size_t size = 0;
+    if(v) {
+        if(v->type==TV_ARRAY)
+            size = v->array.len*8;
+        else if(v->type==TV_BLOB || v->type==TV_STRING)
+            size = v->blob.len+1;
+    }
+    return (size<4096)?4096:size;
+}
+
+static void add_call(bench_t *b, trace_call_t *call) {
+    if(b->ncalls==b->cap) {
+        b->cap = b->cap?b->cap*2:4096;
+        b->calls = (bench_call_t*)realloc(b->calls, b->cap*sizeof(bench_call_t));
+    }
+    bench_call_t *bc = &b->calls[b->ncalls++];
+    memset(bc, 0, sizeof(bench_call_t));
+    bc->call = call;
+    const char *name = call->sig->name;
+    if(strstr(name, "SwapBuffers")) {
+        bc->kind = KIND_SWAP;
+        ++b->frames;
+        return;
+    }
+    if(!strcmp(name, "memcpy")) {
+        bc->kind = KIND_MEMCPY;
+        return;
+    }
+    if(!starts_with(name, "gl") || starts_with(name, "glX") || ends_with(name, "GREMEDY")) {
+        bc->kind = KIND_SKIP;
+        ++b->skipped;
+        return;
+    }
+    bc->func = get_proc_address(name);
+    if(!bc->func) {
+        bc->kind = KIND_SKIP;
+        ++b->missing;
+        return;
+    }
+    bc->draw = is_draw(name);
+    b->draws += bc->draw;
+    bc->nargs = call->sig->num_args;
+    bc->args = (bench_arg_t*)calloc(bc->nargs, sizeof(bench_arg_t));
+    int nint = 0, nfp = 0;
+    for (int i=0; i<bc->nargs; ++i) {
+        bench_arg_t *a = &bc->args[i];
+        trace_value_t *v = call->args[i];
+        if(!v || call->output[i]) {
+            a->output = 1;
+            a->count = output_size(call, v);
+            bc->outsize += (a->count+15)&~15;
+            ++nint;
+            continue;
+        }
+        a->value = prepare_value(b, call, v, &a->fp);
+        if(a->fp) ++nfp; else ++nint;
+        a->map = map_for_arg(name, call->sig->arg_names[i]);
+        if(v->type==TV_ARRAY && a->map) {
+            a->array = 1;
+            a->count = v->array.len;
+        } else if(v->type!=TV_UINT && v->type!=TV_SINT)
+            a->map = MAP_NONE;  // not an object name (like the GLenum of glActiveTexture(texture))
+    }
+    if(nint>MAX_INT || nfp>MAX_FP) {
+        bc->kind = KIND_SKIP;
+        ++b->skipped;
+        return;
+    }
+    // object names created by this call
+    if(starts_with(name, "glGen") && strcmp(name, "glGenerateMipmap")) {
+        if(!strcmp(name, "glGenLists"))
+            bc->gen = GEN_LISTS;
+        else
+            for (int i=0; i<bc->nargs; ++i)
+                if(bc->args[i].output && map_for_arg(name, call->sig->arg_names[i])) {
+                    bc->gen = GEN_OUTPUT;
+                    bc->gen_arg = i;
+                    bc->args[i].map = map_for_arg(name, call->sig->arg_names[i]);
+                }
+    } else if(starts_with(name, "glCreateProgram") || starts_with(name, "glCreateShader"))
+        bc->gen = GEN_RET;
+    else if(starts_with(name, "glGetUniformLocation"))
+        bc->gen = GEN_LOCATION;
+    else if(starts_with(name, "glMapBuffer") || starts_with(name, "glMapNamedBuffer"))
+        bc->gen = GEN_POINTER;
+    else if(starts_with(name, "glUseProgram"))
+        bc->gen = GEN_USEPROGRAM;
+    if(bc->gen==GEN_RET || bc->gen==GEN_LISTS || bc->gen==GEN_LOCATION || bc->gen==GEN_POINTER)
+        if(!call->ret)
+            bc->gen = GEN_NONE;
+}
+
+static uint32_t map_name(bench_t *b, int map, uint32_t name) {
+    khint_t k = kh_get(names, b->maps[map], name);
+    return (k==kh_end(b->maps[map]))?name:kh_value(b->maps[map], k);
+}
+
+static void set_name(bench_t *b, int map, uint32_t trace, uint32_t actual) {
+    int r;
+    khint_t k = kh_put(names, b->maps[map], trace, &r);
+    kh_value(b->maps[map], k) = actual;
+}
+
+static int64_t location_key(uint32_t program, int32_t location) {
+    return ((int64_t)program<<32)|(uint32_t)location;
+}
+
+static uint64_t map_pointer(bench_t *b, uint64_t ptr) {
+    // most recent mapping below ptr
+    for (int i=b->npointers-1; i>=0; --i)
+        if(b->pointers[i].trace<=ptr)
+            return b->pointers[i].actual+(ptr-b->pointers[i].trace);
+    return 0;
+}
+
+static void replay_call(bench_t *b, bench_call_t *bc) {
+    uintptr_t iargs[MAX_INT] = {0};
+    double fargs[MAX_FP] = {0};
+    int nint = 0, nfp = 0;
+    trace_call_t *call = bc->call;
+
+    if(bc->kind==KIND_MEMCPY) {
+        uint64_t dest = map_pointer(b, call->args[0]?call->args[0]->u:0);
+        trace_value_t *src = call->args[1];
+        if(dest && src && src->type==TV_BLOB)
+            memcpy((void*)(uintptr_t)dest, src->blob.data, src->blob.len);
+        return;
+    }
+    if(bc->outsize>b->scratch_size) {
+        b->scratch_size = bc->outsize;
+        free(b->scratch);
+        b->scratch = (char*)calloc(1, b->scratch_size);
+    }
+    char *out = b->scratch;
+    // names remapped in arrays need a copy, after the output buffers
+    size_t arrays = 0;
+    for (int i=0; i<bc->nargs; ++i)
+        if(bc->args[i].array)
+            arrays += bc->args[i].count*sizeof(uint32_t);
+    uint32_t *remap = (arrays)?(uint32_t*)alloca(arrays):NULL;
+
+    for (int i=0; i<bc->nargs; ++i) {
+        bench_arg_t *a = &bc->args[i];
+        uint64_t value = a->value;
+        if(a->output) {
+            value = (uintptr_t)out;
+            out += (a->count+15)&~15;
+        } else if(a->array) {
+            uint32_t *src = (uint32_t*)(uintptr_t)a->value;
+            for (uint32_t j=0; j<a->count; ++j)
+                remap[j] = map_name(b, a->map, src[j]);
+            value = (uintptr_t)remap;
+            remap += a->count;
+        } else if(a->map==MAP_LOCATION) {
+            if((int32_t)value!=-1) {
+                khint_t k = kh_get(locations, b->locations, location_key(b->cur_program, value));
+                if(k!=kh_end(b->locations))
+                    value = (uint32_t)kh_value(b->locations, k);
+            }
+        } else if(a->map)
+            value = map_name(b, a->map, value);
+        if(a->fp) {
+            if(a->fp==1) {
+                // float goes in the low bits of the register
+                uint64_t bits = (uint32_t)value;
+                memcpy(&fargs[nfp++], &bits, 8);
+            } else
+                memcpy(&fargs[nfp++], &value, 8);
+        } else
+            iargs[nint++] = value;
+    }
+
+    COUNT_ALLOCS(1);
+    uintptr_t ret = ((dispatch_t)bc->func)(iargs[0], iargs[1], iargs[2], iargs[3], iargs[4], iargs[5], iargs[6], iargs[7],
+        iargs[8], iargs[9], iargs[10], iargs[11], iargs[12], iargs[13], iargs[14], iargs[15],
+        fargs[0], fargs[1], fargs[2], fargs[3], fargs[4], fargs[5], fargs[6], fargs[7]);
+    COUNT_ALLOCS(0);
+
+    switch(bc->gen) {
+        case GEN_OUTPUT: {
+            trace_value_t *v = call->args[bc->gen_arg];
+            uint32_t *actual = (uint32_t*)(uintptr_t)iargs[bc->gen_arg];
+            if(v && v->type==TV_ARRAY)
+                for (size_t i=0; i<v->array.len; ++i)
+                    set_name(b, bc->args[bc->gen_arg].map, v->array.values[i].u, actual[i]);
+            break;
+        }
+        case GEN_RET:
+            set_name(b, MAP_PROGRAM, call->ret->u, (uint32_t)ret);
+            break;
+        case GEN_LISTS: {
+            uint32_t range = (uint32_t)bc->args[0].value;
+            for (uint32_t i=0; i<range; ++i)
+                set_name(b, MAP_LIST, call->ret->u+i, (uint32_t)ret+i);
+            break;
+        }
+        case GEN_LOCATION: {
+            int r;
+            uint32_t program = call->args[0]?call->args[0]->u:0;
+            khint_t k = kh_put(locations, b->locations, location_key(program, (int32_t)call->ret->i), &r);
+            kh_value(b->locations, k) = (int32_t)ret;
+            break;
+        }
+        case GEN_POINTER:
+            if(b->npointers==32) {
+                memmove(b->pointers, b->pointers+1, 31*sizeof(mapped_ptr_t));
+                --b->npointers;
+            }
+            b->pointers[b->npointers].trace = call->ret->u;
+            b->pointers[b->npointers++].actual = ret;
+            break;
+        case GEN_USEPROGRAM:
+            b->cur_program = call->args[0]?call->args[0]->u:0;
+            break;
+        default:
+            break;
+    }
+}
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1e9+ts.tv_nsec;
+}
+
+static void bench_trace(const char *filename, int loops, int skip) {
+    trace_t *trace = trace_open(filename);
+    if(!trace) {
+        printf("%s: cannot read trace\n", filename);
+        return;
+    }
+    bench_t b = {0};
+    trace_call_t *call;
+    while((call=trace_next(trace)))
+        add_call(&b, call);
+    for (int i=0; i<MAP_LAST; ++i)
+        b.maps[i] = kh_init(names);
+    b.locations = kh_init(locations);
+    void (*flush)() = (void(*)())get_proc_address("glFlush");
+
+    unsigned long calls = 0, draws = 0, frames = 0;
+    gl4es_stats_t stats0 = {0}, stats1 = {0};
+    null_counters_t gles0 = {0}, gles1 = {0};
+    unsigned long allocs0 = 0, bytes0 = 0;
+    double time = 0, start = 0;
+    int measuring = 0;
+    for (int loop=0; loop<loops; ++loop) {
+        int frame = 0;
+        for (int i=0; i<b.ncalls; ++i) {
+            if(!measuring && loop*b.frames+frame>=skip) {
+                // start measuring
+                measuring = 1;
+                if(get_stats) get_stats(NULL, &stats0);
+                if(nullgles_getcounters) nullgles_getcounters(&gles0);
+                allocs0 = alloc_count;
+                bytes0 = alloc_bytes;
+                start = now_ns();
+            }
+            bench_call_t *bc = &b.calls[i];
+            if(bc->kind==KIND_SKIP)
+                continue;
+            if(bc->kind==KIND_SWAP) {
+                COUNT_ALLOCS(1);
+                flush();
+                if(stats_endframe) stats_endframe();
+                COUNT_ALLOCS(0);
+                ++frame;
+                frames += measuring;
+                continue;
+            }
+            replay_call(&b, bc);
+            calls += measuring;
+            draws += measuring && bc->draw;
+        }
+    }
+    if(measuring) {
+        time = now_ns()-start;
+        if(get_stats) get_stats(NULL, &stats1);
+        if(nullgles_getcounters) nullgles_getcounters(&gles1);
+    }
+    if(!frames) frames = 1;
+
+    printf("%s: %d calls, %d frames, %d draws", filename, b.ncalls, b.frames, b.draws);
+    if(b.skipped || b.missing)
+        printf(" (%d skipped, %d unknown to gl4es)", b.skipped, b.missing);
+    printf("\n");
+    if(!calls) {
+        printf("  nothing measured\n");
+        trace_close(trace);
+        return;
+    }
+    printf("  time          : %.3f ms, %.3f ms/frame (%lu frames, %d loop%s)\n", time*1e-6, time*1e-6/frames, frames, loops, (loops>1)?"s":"");
+    printf("  calls         : %.0f calls/s, %.0f ns/call\n", calls*1e9/time, time/calls);
+    if(draws)
+        printf("  draws         : %lu draws, %.0f ns/draw\n", draws, time/draws);
+#ifdef __GLIBC__
+    printf("  allocations   : %.1f allocs/frame, %.1f KB/frame\n", (double)(alloc_count-allocs0)/frames, (alloc_bytes-bytes0)/1024.0/frames);
+#endif
+    if(nullgles_getcounters)
+        printf("  GLES backend  : %.1f calls/frame, %.1f draws/frame, %.1f vertices/frame, %.1f KB texture/frame\n",
+            (double)(gles1.calls-gles0.calls)/frames, (double)(gles1.draws-gles0.draws)/frames,
+            (double)(gles1.vertices-gles0.vertices)/frames, (gles1.texbytes-gles0.texbytes)/1024.0/frames);
+    if(nullgles_getcounters && gles1.vcache_triangles>gles0.vcache_triangles) {
+        unsigned long tris = gles1.vcache_triangles-gles0.vcache_triangles, misses = gles1.vcache_misses-gles0.vcache_misses;
+        printf("  vertex cache  : FIFO-%s, %.1f triangles/frame, %.1f misses/frame, %.3f misses/triangle\n",
+            getenv("LIBGL_NULLGLES_VCACHE"), (double)tris/frames, (double)misses/frames, (double)misses/tris);
+    }
+    if(get_stats) {
+        #define DIFF(A) (stats1.A-stats0.A)
+        #define PERFRAME(A) (double)DIFF(A)/frames
+        unsigned long long lookups = DIFF(fpe_lookups), misses = DIFF(fpe_programs);
+        printf("  gl4es         : %.1f draws/frame, %.1f lists/frame (%.1f merged), %.1f texture uploads/frame\n",
+            PERFRAME(draws), PERFRAME(renderlists), PERFRAME(merged), PERFRAME(tex_uploads));
+        printf("  conversions   : %.1f KB arrays/frame, %.1f KB pixels/frame\n", PERFRAME(array_bytes)/1024.0, PERFRAME(pixel_bytes)/1024.0);
+        printf("  uniforms      : %.1f uploaded/frame, %.1f skipped/frame\n", PERFRAME(uniforms_uploaded), PERFRAME(uniforms_skipped));
+        printf("  FPE cache     : %llu lookups, %.1f%% hits, %llu new programs\n", lookups, lookups?(100.0*(lookups-misses)/lookups):100.0, misses);
+        #undef PERFRAME
+        #undef DIFF
+    }
+
+    for (int i=0; i<b.ncalls; ++i) {
+        if(b.calls[i].args)
+            for (int j=0; j<b.calls[i].nargs; ++j)
+                if(b.calls[i].call->args[j] && b.calls[i].call->args[j]->type==TV_ARRAY && !b.calls[i].args[j].output)
+                    free((void*)(uintptr_t)b.calls[i].args[j].value);
+        free(b.calls[i].args);
+    }
+    free(b.calls);
+    for (int i=0; i<MAP_LAST; ++i)
+        kh_destroy(names, b.maps[i]);
+    kh_destroy(locations, b.locations);
+    free(b.scratch);
+    trace_close(trace);
+}
+
+// pixel_convert fast paths against the generic remap_pixel path
+typedef struct {
+    const char  *name;
+    GLenum      src_format, src_type;
+    GLenum      dst_format, dst_type;
+    int         src_size, dst_size;
+} pixel_case_t;
+
+static const pixel_case_t pixel_cases[] = {
+    {"BGRA -> RGBA",            GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE, 4, 4},
+    {"RGBA 8888 -> RGBA",       GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, GL_RGBA, GL_UNSIGNED_BYTE, 4, 4},
+    {"BGRA 1555 -> RGBA 5551",  GL_BGRA, GL_UNSIGNED_SHORT_1_5_5_5_REV, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, 2, 2},
+    {"L -> RGBA",               GL_LUMINANCE, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE, 1, 4},
+    {"L -> RGB",                GL_LUMINANCE, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_BYTE, 1, 3},
+    {"RGBA -> LA",              GL_RGBA, GL_UNSIGNED_BYTE, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, 4, 2},
+    {"BGR -> RGB",              GL_BGR, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_BYTE, 3, 3},
+    {"RGBA -> RGB",             GL_RGBA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_BYTE, 4, 3},
+    {"RGB -> RGB 565",          GL_RGB, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 3, 2},
+    {"RGBA -> RGB 565",         GL_RGBA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 4, 2},
+    {"BGRA -> RGB 565",         GL_BGRA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 4, 2},
+    {"RGBA -> RGBA 5551",       GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, 4, 2},
+    {"BGRA -> RGBA 5551",       GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, 4, 2},
+    {"RGBA -> RGBA 4444",       GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, 4, 2},
+    {"BGRA -> RGBA 4444",       GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, 4, 2},
+    {"RGBA 5551 -> RGBA",       GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, GL_RGBA, GL_UNSIGNED_BYTE, 2, 4},
+};
+
+static double time_convert(const pixel_case_t *c, const void *src, void *dst, int size, int loops, int generic) {
+    double start = now_ns();
+    for (int i=0; i<loops; ++i)
+        pixel_convert_bench(src, &dst, size, size, c->src_format, c->src_type, c->dst_format, c->dst_type, generic);
+    return now_ns()-start;
+}
+
+static void bench_pixels(int loops) {
+    if(!pixel_convert_bench) {
+        printf("pixel_convert_bench not available in this gl4es (build it with -DPIXEL_BENCH=ON)\n");
+        return;
+    }
+    const int size = 512;
+    unsigned char *src = malloc(size*size*4);
+    unsigned char *fast = malloc(size*size*4);
+    unsigned char *generic = malloc(size*size*4);
+    srand(1);
+    for (int i=0; i<size*size*4; ++i)
+        src[i] = rand();
+    printf("pixel_convert, %dx%d, %d loop%s: fast path / remap_pixel path\n", size, size, loops, (loops>1)?"s":"");
+    for (int i=0; i<sizeof(pixel_cases)/sizeof(pixel_cases[0]); ++i) {
+        const pixel_case_t *c = &pixel_cases[i];
+        double tf = time_convert(c, src, fast, size, loops, 0);
+        double tg = time_convert(c, src, generic, size, loops, 1);
+        double mp = (double)size*size*loops*1e3;    // Mpixels/s from ns
+        printf("  %-24s: %8.1f / %8.1f Mpixels/s, x%.1f%s\n", c->name, mp/tf, mp/tg, tg/tf,
+            memcmp(fast, generic, size*size*c->dst_size)?" (results differ)":"");
+    }
+    free(src);
+    free(fast);
+    free(generic);
+}
+
+static void usage() {
+    printf("usage: gl4es_bench [-l loops] [-s frames] [-c size] [-L libGL.so] file.trace...\n");
+    printf("       gl4es_bench -p [-l loops] [-L libGL.so]\n");
+    printf("  -p         : benchmark the pixel conversions instead of replaying traces\n");
+    printf("  -l loops   : replay each trace \"loops\" times (default 1)\n");
+    printf("  -s frames  : do not measure the first \"frames\" frames (default 0)\n");
+    printf("  -c size    : simulate a FIFO vertex cache of \"size\" entries on the triangles drawn\n");
+    printf("  -L lib     : gl4es library to use (default %s)\n", GL4ES_BENCH_LIB);
+}
+
+int main(int argc, char **argv) {
+    int loops = 1, skip = 0, pixels = 0;
+    const char *lib = GL4ES_BENCH_LIB;
+    int first = 1;
+    while(first<argc && argv[first][0]=='-') {
+        if(!strcmp(argv[first], "-l") && first+1<argc)
+            loops = atoi(argv[++first]);
+        else if(!strcmp(argv[first], "-s") && first+1<argc)
+            skip = atoi(argv[++first]);
+        else if(!strcmp(argv[first], "-c") && first+1<argc)
+            setenv("LIBGL_NULLGLES_VCACHE", argv[++first], 1);
+        else if(!strcmp(argv[first], "-L") && first+1<argc)
+            lib = argv[++first];
+        else if(!strcmp(argv[first], "-p"))
+            pixels = 1;
+        else {
+            usage();
+            return 1;
+        }
+        ++first;
+    }
+    if((first>=argc && !pixels) || loops<1) {
+        usage();
+        return 1;
+    }
+    // must be set before gl4es initialize
+    setenv("LIBGL_NULLGLES", "1", 0);
+    setenv("LIBGL_NOBANNER", "1", 0);
+    setenv("LIBGL_NOPSA", "1", 0);
+    setenv("LIBGL_SILENTSTUB", "1", 0);
+    void *gl = dlopen(lib, RTLD_NOW|RTLD_LOCAL);
+    if(!gl) {
+        printf("Cannot load %s: %s\n", lib, dlerror());
+        return 1;
+    }
+    get_proc_address = dlsym(gl, "gl4es_GetProcAddress");
+    nullgles_getcounters = dlsym(gl, "nullgles_getcounters");
+    get_stats = dlsym(gl, "gl4es_getStats");
+    stats_endframe = dlsym(gl, "gl4es_statsEndFrame");
+    pixel_convert_bench = dlsym(gl, "pixel_convert_bench");
+    void (*initialize_gl4es)() = dlsym(gl, "initialize_gl4es");
+    if(!get_proc_address) {
+        printf("%s is not gl4es\n", lib);
+        return 1;
+    }
+    // only exported when gl4es is built without init constructor
+    if(initialize_gl4es)
+        initialize_gl4es();
+
+    if(pixels)
+        bench_pixels(loops);
+    for (int i=first; i<argc; ++i)
+        bench_trace(argv[i], loops, skip);
+
+    return 0;
+}
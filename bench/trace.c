@@ -0,0 +1,521 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// apitrace events and call details
+enum {
+    EVENT_ENTER = 0,
+    EVENT_LEAVE
+};
+
+enum {
+    CALL_END = 0,
+    CALL_ARG,
+    CALL_RET,
+    CALL_THREAD,
+    CALL_BACKTRACE,
+    CALL_FLAGS
+};
+
+enum {
+    BACKTRACE_END = 0,
+    BACKTRACE_MODULE,
+    BACKTRACE_FUNCTION,
+    BACKTRACE_FILENAME,
+    BACKTRACE_LINENUMBER,
+    BACKTRACE_OFFSET
+};
+
+struct trace_s {
+    unsigned char   *data;      // whole uncompressed stream
+    size_t          size;
+    size_t          pos;
+    unsigned        version;
+    int             error;
+    // signatures, by id
+    trace_sig_t     **calls;
+    int             ncalls;
+    char            *enums;     // only need to know if a signature was already seen
+    int             nenums;
+    char            *bitmasks;
+    int             nbitmasks;
+    char            **structs;  // number of members, stored as (char*)(intptr_t)
+    int             nstructs;
+    char            *frames;
+    int             nframes;
+    // calls entered but not left yet
+    trace_call_t    **pending;
+    int             npending;
+    int             cappending;
+    unsigned        next_no;
+    // arena for everything returned to the user
+    void            **chunks;
+    int             nchunks;
+    char            *arena;
+    size_t          arena_left;
+};
+
+// ********* Arena *********
+
+static void* alloc(trace_t *t, size_t size) {
+    size = (size+15)&~(size_t)15;
+    if(size>t->arena_left) {
+        size_t chunk = (size>(1<<20))?size:(1<<20);
+        t->arena = (char*)calloc(1, chunk);
+        t->arena_left = chunk;
+        t->chunks = (void**)realloc(t->chunks, (t->nchunks+1)*sizeof(void*));
+        t->chunks[t->nchunks++] = t->arena;
+    }
+    void *ret = t->arena;
+    t->arena += size;
+    t->arena_left -= size;
+    return ret;
+}
+
+// ********* Snappy *********
+
+static int snappy_uncompress(const unsigned char *in, size_t inlen, unsigned char **out, size_t *outlen) {
+    const unsigned char *end = in+inlen;
+    size_t len = 0;
+    int shift = 0;
+    while(in<end) {
+        len |= (size_t)(*in&0x7f)<<shift;
+        shift += 7;
+        if(!(*(in++)&0x80))
+            break;
+    }
+    unsigned char *dst = (unsigned char*)malloc(len?len:1);
+    size_t op = 0;
+    while(in<end) {
+        unsigned char tag = *(in++);
+        size_t l, offset;
+        switch(tag&3) {
+            case 0: // literal
+                l = tag>>2;
+                if(l>=60) {
+                    int n = l-59;
+                    l = 0;
+                    for (int i=0; i<n; ++i)
+                        l |= (size_t)in[i]<<(8*i);
+                    in += n;
+                }
+                ++l;
+                if(op+l>len || in+l>end) { free(dst); return 0; }
+                memcpy(dst+op, in, l);
+                in += l;
+                op += l;
+                continue;
+            case 1:
+                l = 4+((tag>>2)&7);
+                offset = ((size_t)(tag>>5)<<8)|in[0];
+                in += 1;
+                break;
+            case 2:
+                l = 1+(tag>>2);
+                offset = in[0]|((size_t)in[1]<<8);
+                in += 2;
+                break;
+            default:
+                l = 1+(tag>>2);
+                offset = in[0]|((size_t)in[1]<<8)|((size_t)in[2]<<16)|((size_t)in[3]<<24);
+                in += 4;
+                break;
+        }
+        if(!offset || offset>op || op+l>len) { free(dst); return 0; }
+        // overlapping copies are allowed
+        for (size_t i=0; i<l; ++i, ++op)
+            dst[op] = dst[op-offset];
+    }
+    *out = dst;
+    *outlen = op;
+    return 1;
+}
+
+static int load_file(trace_t *t, const char *filename) {
+    FILE *f = fopen(filename, "rb");
+    if(!f)
+        return 0;
+    fseek(f, 0, SEEK_END);
+    long fsize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *raw = (unsigned char*)malloc(fsize);
+    if(fread(raw, 1, fsize, f)!=fsize) {
+        free(raw);
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+    if(fsize<2 || raw[0]!='a' || raw[1]!='t') {
+        printf("%s: not a snappy compressed apitrace file\n", filename);
+        free(raw);
+        return 0;
+    }
+    size_t cap = fsize*4, pos = 2;
+    t->data = (unsigned char*)malloc(cap);
+    t->size = 0;
+    while(pos+4<=fsize) {
+        size_t clen = raw[pos]|(raw[pos+1]<<8)|(raw[pos+2]<<16)|((size_t)raw[pos+3]<<24);
+        pos += 4;
+        unsigned char *chunk;
+        size_t len;
+        if(pos+clen>fsize || !snappy_uncompress(raw+pos, clen, &chunk, &len)) {
+            printf("%s: corrupted snappy chunk\n", filename);
+            break;
+        }
+        pos += clen;
+        if(t->size+len>cap) {
+            while(t->size+len>cap) cap *= 2;
+            t->data = (unsigned char*)realloc(t->data, cap);
+        }
+        memcpy(t->data+t->size, chunk, len);
+        t->size += len;
+        free(chunk);
+    }
+    free(raw);
+    return 1;
+}
+
+// ********* Parser *********
+
+static int read_byte(trace_t *t) {
+    if(t->pos>=t->size) {
+        t->error = 1;
+        return -1;
+    }
+    return t->data[t->pos++];
+}
+
+static uint64_t read_uint(trace_t *t) {
+    uint64_t v = 0;
+    int shift = 0, c;
+    do {
+        c = read_byte(t);
+        if(c<0) return 0;
+        v |= (uint64_t)(c&0x7f)<<shift;
+        shift += 7;
+    } while(c&0x80);
+    return v;
+}
+
+static int64_t read_sint(trace_t *t) {
+    int c = read_byte(t);
+    if(c==TV_SINT)
+        return -(int64_t)read_uint(t);
+    if(c==TV_UINT)
+        return read_uint(t);
+    t->error = 1;
+    return 0;
+}
+
+static char* read_string(trace_t *t) {
+    size_t len = read_uint(t);
+    if(t->pos+len>t->size) {
+        t->error = 1;
+        return NULL;
+    }
+    char *s = (char*)alloc(t, len+1);
+    memcpy(s, t->data+t->pos, len);
+    s[len] = '\0';
+    t->pos += len;
+    return s;
+}
+
+static void skip_string(trace_t *t) {
+    size_t len = read_uint(t);
+    t->pos += len;
+    if(t->pos>t->size)
+        t->error = 1;
+}
+
+// returns 1 if the signature "id" is new, and mark it as seen
+static int new_sig(char **seen, int *size, unsigned id) {
+    if(id>=*size) {
+        int old = *size;
+        *size = id+64;
+        *seen = (char*)realloc(*seen, *size);
+        memset(*seen+old, 0, *size-old);
+    }
+    if((*seen)[id])
+        return 0;
+    (*seen)[id] = 1;
+    return 1;
+}
+
+static void read_value(trace_t *t, trace_value_t *v);
+
+static void read_enum(trace_t *t, trace_value_t *v) {
+    unsigned id = read_uint(t);
+    if(new_sig(&t->enums, &t->nenums, id)) {
+        unsigned n = read_uint(t);
+        for (unsigned i=0; i<n && !t->error; ++i) {
+            skip_string(t);
+            read_sint(t);
+        }
+    }
+    v->type = TV_ENUM;
+    v->i = read_sint(t);
+}
+
+static void read_bitmask(trace_t *t, trace_value_t *v) {
+    unsigned id = read_uint(t);
+    if(new_sig(&t->bitmasks, &t->nbitmasks, id)) {
+        unsigned n = read_uint(t);
+        for (unsigned i=0; i<n && !t->error; ++i) {
+            skip_string(t);
+            read_uint(t);
+        }
+    }
+    v->type = TV_BITMASK;
+    v->u = read_uint(t);
+}
+
+static void read_struct(trace_t *t, trace_value_t *v) {
+    unsigned id = read_uint(t);
+    if(id>=t->nstructs) {
+        int old = t->nstructs;
+        t->nstructs = id+16;
+        t->structs = (char**)realloc(t->structs, t->nstructs*sizeof(char*));
+        memset(t->structs+old, 0, (t->nstructs-old)*sizeof(char*));
+    }
+    if(!t->structs[id]) {
+        skip_string(t);
+        unsigned n = read_uint(t);
+        for (unsigned i=0; i<n; ++i)
+            skip_string(t);
+        t->structs[id] = (char*)(intptr_t)(n+1);
+    }
+    size_t n = (intptr_t)t->structs[id]-1;
+    v->type = TV_STRUCT;
+    v->array.len = n;
+    v->array.values = (trace_value_t*)alloc(t, n*sizeof(trace_value_t));
+    for (size_t i=0; i<n && !t->error; ++i)
+        read_value(t, &v->array.values[i]);
+}
+
+static void read_value(trace_t *t, trace_value_t *v) {
+    int c = read_byte(t);
+    memset(v, 0, sizeof(trace_value_t));
+    switch(c) {
+        case TV_NULL:
+        case TV_FALSE:
+        case TV_TRUE:
+            v->type = c;
+            break;
+        case TV_SINT:
+            v->type = TV_SINT;
+            v->i = -(int64_t)read_uint(t);
+            break;
+        case TV_UINT:
+        case TV_OPAQUE:
+            v->type = c;
+            v->u = read_uint(t);
+            break;
+        case TV_FLOAT:
+            v->type = TV_FLOAT;
+            if(t->pos+4>t->size) { t->error = 1; break; }
+            memcpy(&v->f, t->data+t->pos, 4);
+            t->pos += 4;
+            break;
+        case TV_DOUBLE:
+            v->type = TV_DOUBLE;
+            if(t->pos+8>t->size) { t->error = 1; break; }
+            memcpy(&v->d, t->data+t->pos, 8);
+            t->pos += 8;
+            break;
+        case TV_STRING:
+        case TV_BLOB:
+            v->type = c;
+            v->blob.len = read_uint(t);
+            if(t->pos+v->blob.len>t->size) { t->error = 1; break; }
+            v->blob.data = alloc(t, v->blob.len+1);
+            memcpy(v->blob.data, t->data+t->pos, v->blob.len);
+            t->pos += v->blob.len;
+            break;
+        case TV_WSTRING:
+            v->type = TV_WSTRING;
+            v->blob.len = read_uint(t);
+            v->blob.data = alloc(t, v->blob.len+1);
+            for (size_t i=0; i<v->blob.len; ++i)
+                ((char*)v->blob.data)[i] = (char)read_uint(t);
+            break;
+        case TV_ENUM:
+            read_enum(t, v);
+            break;
+        case TV_BITMASK:
+            read_bitmask(t, v);
+            break;
+        case TV_ARRAY:
+            v->type = TV_ARRAY;
+            v->array.len = read_uint(t);
+            if(v->array.len>t->size-t->pos) { t->error = 1; break; }
+            v->array.values = (trace_value_t*)alloc(t, v->array.len*sizeof(trace_value_t));
+            for (size_t i=0; i<v->array.len && !t->error; ++i)
+                read_value(t, &v->array.values[i]);
+            break;
+        case TV_STRUCT:
+            read_struct(t, v);
+            break;
+        case TV_REPR:
+            v->type = TV_REPR;
+            v->array.len = 2;
+            v->array.values = (trace_value_t*)alloc(t, 2*sizeof(trace_value_t));
+            read_value(t, &v->array.values[0]);
+            read_value(t, &v->array.values[1]);
+            break;
+        default:
+            t->error = 1;
+    }
+}
+
+static void skip_backtrace(trace_t *t) {
+    unsigned n = read_uint(t);
+    for (unsigned i=0; i<n && !t->error; ++i) {
+        unsigned id = read_uint(t);
+        if(new_sig(&t->frames, &t->nframes, id)) {
+            int c;
+            while((c=read_byte(t))>0) {
+                if(c==BACKTRACE_LINENUMBER || c==BACKTRACE_OFFSET)
+                    read_uint(t);
+                else
+                    skip_string(t);
+            }
+        }
+    }
+}
+
+static trace_sig_t* read_call_sig(trace_t *t) {
+    unsigned id = read_uint(t);
+    if(id>=t->ncalls) {
+        int old = t->ncalls;
+        t->ncalls = id+64;
+        t->calls = (trace_sig_t**)realloc(t->calls, t->ncalls*sizeof(trace_sig_t*));
+        memset(t->calls+old, 0, (t->ncalls-old)*sizeof(trace_sig_t*));
+    }
+    if(!t->calls[id]) {
+        trace_sig_t *sig = (trace_sig_t*)alloc(t, sizeof(trace_sig_t));
+        sig->name = read_string(t);
+        sig->num_args = read_uint(t);
+        sig->arg_names = (const char**)alloc(t, sig->num_args*sizeof(char*));
+        for (int i=0; i<sig->num_args; ++i)
+            sig->arg_names[i] = read_string(t);
+        t->calls[id] = sig;
+    }
+    return t->calls[id];
+}
+
+static void read_call_details(trace_t *t, trace_call_t *call, int leave) {
+    int c;
+    while((c=read_byte(t))>0) {
+        switch(c) {
+            case CALL_ARG: {
+                unsigned idx = read_uint(t);
+                trace_value_t *v = (trace_value_t*)alloc(t, sizeof(trace_value_t));
+                read_value(t, v);
+                if(idx<call->sig->num_args) {
+                    if(leave && !call->args[idx])
+                        call->output[idx] = 1;
+                    call->args[idx] = v;
+                }
+                break;
+            }
+            case CALL_RET:
+                call->ret = (trace_value_t*)alloc(t, sizeof(trace_value_t));
+                read_value(t, call->ret);
+                break;
+            case CALL_THREAD:
+            case CALL_FLAGS:
+                read_uint(t);
+                break;
+            case CALL_BACKTRACE:
+                skip_backtrace(t);
+                break;
+            default:
+                t->error = 1;
+                return;
+        }
+    }
+}
+
+trace_t* trace_open(const char *filename) {
+    trace_t *t = (trace_t*)calloc(1, sizeof(trace_t));
+    if(!load_file(t, filename)) {
+        trace_close(t);
+        return NULL;
+    }
+    t->version = read_uint(t);
+    if(t->version<4 || t->version>6) {
+        printf("%s: unsupported trace version %u\n", filename, t->version);
+        trace_close(t);
+        return NULL;
+    }
+    if(t->version>=6) {
+        // properties
+        while(!t->error) {
+            size_t len = read_uint(t);
+            if(!len)
+                break;
+            t->pos += len;
+            skip_string(t);
+        }
+    }
+    return t;
+}
+
+static trace_call_t* pop_pending(trace_t *t, int i) {
+    trace_call_t *call = t->pending[i];
+    memmove(t->pending+i, t->pending+i+1, (t->npending-i-1)*sizeof(trace_call_t*));
+    --t->npending;
+    return call;
+}
+
+trace_call_t* trace_next(trace_t *t) {
+    while(!t->error && t->pos<t->size) {
+        int c = read_byte(t);
+        if(c==EVENT_ENTER) {
+            read_uint(t);   // thread
+            trace_call_t *call = (trace_call_t*)alloc(t, sizeof(trace_call_t));
+            call->sig = read_call_sig(t);
+            call->no = t->next_no++;
+            call->args = (trace_value_t**)alloc(t, call->sig->num_args*sizeof(trace_value_t*));
+            call->output = (char*)alloc(t, call->sig->num_args);
+            read_call_details(t, call, 0);
+            if(t->npending==t->cappending) {
+                t->cappending += 16;
+                t->pending = (trace_call_t**)realloc(t->pending, t->cappending*sizeof(trace_call_t*));
+            }
+            t->pending[t->npending++] = call;
+        } else if(c==EVENT_LEAVE) {
+            unsigned no = read_uint(t);
+            for (int i=0; i<t->npending; ++i)
+                if(t->pending[i]->no==no) {
+                    trace_call_t *call = pop_pending(t, i);
+                    read_call_details(t, call, 1);
+                    return call;
+                }
+            t->error = 1;
+        } else
+            t->error = 1;
+    }
+    // calls that never returned (like an exit in the middle of a call)
+    if(t->npending)
+        return pop_pending(t, 0);
+    return NULL;
+}
+
+void trace_close(trace_t *t) {
+    if(!t)
+        return;
+    for (int i=0; i<t->nchunks; ++i)
+        free(t->chunks[i]);
+    free(t->chunks);
+    free(t->data);
+    free(t->calls);
+    free(t->enums);
+    free(t->bitmasks);
+    free(t->structs);
+    free(t->frames);
+    free(t->pending);
+    free(t);
+}
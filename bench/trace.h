@@ -0,0 +1,68 @@
+#ifndef _GL4ES_BENCH_TRACE_H_
+#define _GL4ES_BENCH_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Minimal reader for apitrace ".trace" files (snappy compressed, format version 5 and 6),
+// enough to replay the GL calls of the traces in "traces/".
+
+typedef enum {
+    TV_NULL = 0,
+    TV_FALSE,
+    TV_TRUE,
+    TV_SINT,
+    TV_UINT,
+    TV_FLOAT,
+    TV_DOUBLE,
+    TV_STRING,
+    TV_BLOB,
+    TV_ENUM,
+    TV_BITMASK,
+    TV_ARRAY,
+    TV_STRUCT,
+    TV_OPAQUE,
+    TV_REPR,
+    TV_WSTRING
+} trace_type_t;
+
+typedef struct trace_value_s {
+    trace_type_t type;
+    union {
+        int64_t     i;          // TV_SINT / TV_ENUM
+        uint64_t    u;          // TV_UINT / TV_BITMASK / TV_OPAQUE
+        float       f;
+        double      d;
+        struct {
+            size_t  len;
+            void    *data;      // TV_STRING / TV_BLOB / TV_WSTRING (as a narrow string)
+        } blob;
+        struct {
+            size_t  len;
+            struct trace_value_s *values;   // TV_ARRAY / TV_STRUCT / TV_REPR (human, machine)
+        } array;
+    };
+} trace_value_t;
+
+typedef struct {
+    const char  *name;
+    int         num_args;
+    const char  **arg_names;
+} trace_sig_t;
+
+typedef struct {
+    unsigned        no;
+    trace_sig_t     *sig;
+    trace_value_t   **args;     // num_args entries, NULL when the argument is not recorded
+    char            *output;    // non zero when the argument was only recorded when the call returned
+    trace_value_t   *ret;
+} trace_call_t;
+
+typedef struct trace_s trace_t;
+
+trace_t* trace_open(const char *filename);
+// returns the next complete call (or NULL at the end). The call stays valid until trace_close.
+trace_call_t* trace_next(trace_t *trace);
+void trace_close(trace_t *trace);
+
+#endif // _GL4ES_BENCH_TRACE_H_
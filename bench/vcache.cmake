@@ -0,0 +1,28 @@
+# Replay a trace with the vertex cache simulator of the null backend (gl4es_bench -c),
+# without and with the vertex cache pass of display lists, and check that the misses drop
+if(NOT BENCH OR NOT TRACE OR NOT TEST_FILENAME)
+    message(FATAL_ERROR "BENCH, TRACE and TEST_FILENAME are required.")
+endif()
+
+# in its own directory, the other tests of the same trace may run at the same time
+set(dir ${CMAKE_CURRENT_BINARY_DIR}/vcache)
+file(MAKE_DIRECTORY ${dir})
+execute_process(COMMAND ${CMAKE_COMMAND} -E tar xf ${TRACE} WORKING_DIRECTORY ${dir})
+foreach(level 0 2)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E env LIBGL_LISTVCACHE=${level} ${BENCH} -c 16 ${dir}/${TEST_FILENAME}.trace
+        RESULT_VARIABLE result OUTPUT_VARIABLE output)
+    if(NOT result EQUAL 0)
+        file(REMOVE ${dir}/${TEST_FILENAME}.trace)
+        message(FATAL_ERROR "gl4es_bench failed on ${TEST_FILENAME} with LIBGL_LISTVCACHE=${level}: ${result}")
+    endif()
+    if(NOT output MATCHES "vertex cache  : [^\n]* ([0-9.]+) misses/triangle")
+        file(REMOVE ${dir}/${TEST_FILENAME}.trace)
+        message(FATAL_ERROR "no vertex cache statistics from gl4es_bench:\n${output}")
+    endif()
+    set(misses${level} ${CMAKE_MATCH_1})
+    message(STATUS "LIBGL_LISTVCACHE=${level}: ${CMAKE_MATCH_1} misses/triangle")
+endforeach()
+file(REMOVE ${dir}/${TEST_FILENAME}.trace)
+if(NOT misses2 LESS misses0)
+    message(FATAL_ERROR "the vertex cache pass doesn't lower the misses: ${misses0} -> ${misses2}")
+endif()
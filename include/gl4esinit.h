@@ -25,6 +25,25 @@ void close_gl4es(void);
 // wrapped GetProcAddress
 void* APIENTRY_GL4ES gl4es_GetProcAddress(const char *name);
 
+// hot-path counters, always collected (LIBGL_STATS only controls the printing)
+typedef struct {
+    unsigned long long frames;              // frames ended (SwapBuffers or gl4es_statsEndFrame)
+    unsigned long long draws;               // draw commands sent to GLES
+    unsigned long long renderlists;         // renderlists built (glBegin/glEnd, display lists...)
+    unsigned long long merged;              // renderlists merged into the previous one
+    unsigned long long fpe_lookups;         // FPE program selections
+    unsigned long long fpe_programs;        // FPE programs that had to be built
+    unsigned long long uniforms_uploaded;   // glUniform* actually sent to GLES
+    unsigned long long uniforms_skipped;    // glUniform* skipped because the value was already there
+    unsigned long long pixel_bytes;         // bytes written by pixel_convert
+    unsigned long long array_bytes;         // bytes written by copy_gl_array*
+    unsigned long long tex_uploads;         // glTexImage2D with data and glTexSubImage2D
+} gl4es_stats_t;
+// get the counters of the last ended frame and / or the totals since init (any can be NULL)
+void gl4es_getStats(gl4es_stats_t *last_frame, gl4es_stats_t *total);
+// end the current frame. Only needed when the SwapBuffers doesn't go through gl4es (like with NOEGL)
+void gl4es_statsEndFrame(void);
+
 #ifdef __cplusplus
 }
 #endif
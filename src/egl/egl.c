@@ -1,6 +1,7 @@
 
 #include "egl.h"
 #include "../gl/loader.h"
+#include "../gl/stats.h"
 #include "../glx/hardext.h"
 
 #ifndef AliasExport
@@ -191,6 +192,7 @@ EGLBoolean gl4es_eglWaitNative(EGLint engine) {
 
 EGLBoolean gl4es_eglSwapBuffers(EGLDisplay dpy, EGLSurface surface) {
     LOAD_EGL(eglSwapBuffers);
+    gl4es_statsEndFrame();
     return egl_eglSwapBuffers(dpy, surface);
 }
 
@@ -5,6 +5,129 @@
 #include "glcase.h"
 #include "light.h"
 #include "state.h"
+#include "stats.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define ARRAY_SIMD
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ARRAY_SIMD
+#endif
+
+#ifdef ARRAY_SIMD
+// SIMD kernels for the most common vertex conversions. They return the number of
+// vertices converted, the caller finishes the job with the generic (scalar) code.
+// Source elements are read 16 (or 8) bytes at a time, so the last vertex is always
+// left to the scalar code, to never read past the end of the array.
+
+// float[width] -> float4 (z = 0, w = 1), width 2..4
+static int simd_float_to_float4(uintptr_t in, GLsizei stride, int width, int n, GLfloat *out) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 mask = _mm_castsi128_ps((width==2)?_mm_set_epi32(0, 0, -1, -1):_mm_set_epi32(0, -1, -1, -1));
+    const __m128 pad = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    if(width==4)
+        for (; i < n-1; ++i, in += stride, out += 4)
+            _mm_storeu_ps(out, _mm_loadu_ps((const float*)in));
+    else
+        for (; i < n-1; ++i, in += stride, out += 4)
+            _mm_storeu_ps(out, _mm_or_ps(_mm_and_ps(_mm_loadu_ps((const float*)in), mask), pad));
+#else
+    for (; i < n-1; ++i, in += stride, out += 4) {
+        float32x4_t v = vld1q_f32((const float*)in);
+        if(width==2) v = vsetq_lane_f32(0.0f, v, 2);
+        if(width<4) v = vsetq_lane_f32(1.0f, v, 3);
+        vst1q_f32(out, v);
+    }
+#endif
+    return i;
+}
+
+// short[width] -> float4 (z = 0, w = 1), width 2..3, not normalized
+static int simd_short_to_float4(uintptr_t in, GLsizei stride, int width, int n, GLfloat *out) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 mask = _mm_castsi128_ps((width==2)?_mm_set_epi32(0, 0, -1, -1):_mm_set_epi32(0, -1, -1, -1));
+    const __m128 pad = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    for (; i < n-1; ++i, in += stride, out += 4) {
+        __m128i v = _mm_loadl_epi64((const __m128i*)in);
+        v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        _mm_storeu_ps(out, _mm_or_ps(_mm_and_ps(_mm_cvtepi32_ps(v), mask), pad));
+    }
+#else
+    for (; i < n-1; ++i, in += stride, out += 4) {
+        float32x4_t v = vcvtq_f32_s32(vmovl_s16(vld1_s16((const int16_t*)in)));
+        if(width==2) v = vsetq_lane_f32(0.0f, v, 2);
+        v = vsetq_lane_f32(1.0f, v, 3);
+        vst1q_f32(out, v);
+    }
+#endif
+    return i;
+}
+
+// ubyte4 -> float4 normalized (times scale), optionally swapping R and B (BGRA source)
+static int simd_ubyte4_to_float4(uintptr_t in, GLsizei stride, int bgra, int n, GLfloat *out, GLfloat scale) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ag = _mm_set1_epi32(0xff00ff00);
+    const __m128i byte = _mm_set1_epi32(0xff);
+    const __m128 vscale = _mm_set1_ps(scale);
+    #define SWAP_RB(v) if(bgra) v = _mm_or_si128(_mm_and_si128(v, ag), _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16), byte), _mm_slli_epi32(_mm_and_si128(v, byte), 16)))
+    #define CONVERT(v) _mm_mul_ps(_mm_cvtepi32_ps(v), vscale)
+    if(stride==4) {
+        // packed source, 4 vertices at a time
+        for (; i+4 <= n; i += 4, in += 16, out += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)in);
+            SWAP_RB(v);
+            __m128i lo = _mm_unpacklo_epi8(v, zero);
+            __m128i hi = _mm_unpackhi_epi8(v, zero);
+            _mm_storeu_ps(out+ 0, CONVERT(_mm_unpacklo_epi16(lo, zero)));
+            _mm_storeu_ps(out+ 4, CONVERT(_mm_unpackhi_epi16(lo, zero)));
+            _mm_storeu_ps(out+ 8, CONVERT(_mm_unpacklo_epi16(hi, zero)));
+            _mm_storeu_ps(out+12, CONVERT(_mm_unpackhi_epi16(hi, zero)));
+        }
+    }
+    for (; i < n; ++i, in += stride, out += 4) {
+        uint32_t p;
+        memcpy(&p, (const void*)in, 4);
+        __m128i v = _mm_cvtsi32_si128(p);
+        SWAP_RB(v);
+        _mm_storeu_ps(out, CONVERT(_mm_unpacklo_epi16(_mm_unpacklo_epi8(v, zero), zero)));
+    }
+#else
+    const uint32x4_t ag = vdupq_n_u32(0xff00ff00);
+    const uint32x4_t byte = vdupq_n_u32(0xff);
+    #define SWAP_RB(v) if(bgra) v = vorrq_u32(vandq_u32(v, ag), vorrq_u32(vandq_u32(vshrq_n_u32(v, 16), byte), vshlq_n_u32(vandq_u32(v, byte), 16)))
+    #define CONVERT(v) vmulq_n_f32(vcvtq_f32_u32(v), scale)
+    if(stride==4) {
+        // packed source, 4 vertices at a time
+        for (; i+4 <= n; i += 4, in += 16, out += 16) {
+            uint32x4_t v = vld1q_u32((const uint32_t*)in);
+            SWAP_RB(v);
+            uint8x16_t b = vreinterpretq_u8_u32(v);
+            uint16x8_t lo = vmovl_u8(vget_low_u8(b));
+            uint16x8_t hi = vmovl_u8(vget_high_u8(b));
+            vst1q_f32(out+ 0, CONVERT(vmovl_u16(vget_low_u16(lo))));
+            vst1q_f32(out+ 4, CONVERT(vmovl_u16(vget_high_u16(lo))));
+            vst1q_f32(out+ 8, CONVERT(vmovl_u16(vget_low_u16(hi))));
+            vst1q_f32(out+12, CONVERT(vmovl_u16(vget_high_u16(hi))));
+        }
+    }
+    for (; i < n; ++i, in += stride, out += 4) {
+        uint32_t p;
+        memcpy(&p, (const void*)in, 4);
+        uint32x4_t v = vdupq_n_u32(p);
+        SWAP_RB(v);
+        vst1q_f32(out, CONVERT(vmovl_u16(vget_low_u16(vmovl_u8(vget_low_u8(vreinterpretq_u8_u32(v)))))));
+    }
+#endif
+    #undef CONVERT
+    #undef SWAP_RB
+    return i;
+}
+#endif // ARRAY_SIMD
 
 GLvoid *copy_gl_array(const GLvoid *src,
                       GLenum from, GLsizei width, GLsizei stride,
@@ -19,6 +142,7 @@ GLvoid *copy_gl_array(const GLvoid *src,
     if(!dst) {
         dst = malloc((count-skip) * to_width * gl_sizeof(to));
     }
+    STATS_ADD(array_bytes, (count-skip) * to_width * gl_sizeof(to));
     GLsizei from_size = gl_sizeof(from) * width;
     if (to_width < width) {
 /*        printf("Warning: copy_gl_array: %i < %i\n", to_width, width);
@@ -88,11 +212,21 @@ GLvoid *copy_gl_array_texcoord(const GLvoid *src,
     static const char *unknown_str = "LIBGL: copy_gl_array -> unknown type: %x\n";
     if(!dst)
         dst = malloc((count-skip) * to_width * gl_sizeof(GL_FLOAT));
+    STATS_ADD(array_bytes, (count-skip) * to_width * gl_sizeof(GL_FLOAT));
     GLsizei from_size = gl_sizeof(from) * width;
     GLsizei to_elem = gl_sizeof(GL_FLOAT);
     uintptr_t in = (uintptr_t)src;
     in += stride*skip;
     GLfloat* out = (GLfloat*)dst;
+#ifdef ARRAY_SIMD
+    if (to_width==4 && width>=2 && ((from==GL_FLOAT) || (from==GL_SHORT && width<4))) {
+        int done = (from==GL_FLOAT)?simd_float_to_float4(in, stride, width, count-skip, out)
+                                   :simd_short_to_float4(in, stride, width, count-skip, out);
+        skip += done;
+        in += stride*done;
+        out += 4*done;
+    }
+#endif
     if (from == GL_FLOAT && to_width >= width) {
         for (int i = skip; i < count; i++) {
             GLfloat* input = (GLfloat*)in;
@@ -142,12 +276,20 @@ GLvoid *copy_gl_array_quickconvert(const GLvoid *src,
         stride = 4 * gl_sizeof(from);
     const char *unknown_str = "LIBGL: copy_gl_array_quickconvert -> unknown type: %x\n";
     GLvoid *dst = (dest)?dest:malloc((count-skip) * 4 * gl_sizeof(GL_FLOAT));
+    STATS_ADD(array_bytes, (count-skip) * 4 * gl_sizeof(GL_FLOAT));
 
     uintptr_t in = (uintptr_t)src;
     in += stride*skip;
     int j;
     
     GLfloat *out = (GLfloat*)dst;
+#ifdef ARRAY_SIMD
+    if (from==GL_UNSIGNED_BYTE) {
+        const GLfloat maxf = 1.0f/gl_max_value(from);
+        simd_ubyte4_to_float4(in, stride, 0, count-skip, out, maxf);
+        return dst;
+    }
+#endif
     GL_TYPE_SWITCH2(input, in, from,
         const GLfloat maxf = 1.0f/gl_max_value(from);
         for (int i = skip; i < count; i++)
@@ -178,6 +320,7 @@ GLvoid *copy_gl_array_convert(const GLvoid *src,
     if(to==from && width==to_width && stride==(to_width * gl_sizeof(to))) {
         if(!dst) dst = malloc((count-skip) * stride);
         memcpy(dst, (char*)src+stride*skip, (count-skip)*stride);
+        STATS_ADD(array_bytes, (count-skip) * stride);
         return dst;
     }
 
@@ -191,6 +334,7 @@ GLvoid *copy_gl_array_convert(const GLvoid *src,
 
     const char *unknown_str = "LIBGL: copy_gl_array_convert -> unknown type: %x\n";
     if(!dst) dst = malloc((count-skip) * to_width * gl_sizeof(to));
+    STATS_ADD(array_bytes, (count-skip) * to_width * gl_sizeof(to));
     if (to_width < width) {
         /*printf("Warning: copy_gl_array: %i < %i\n", to_width, width);
         return NULL;*/
@@ -468,33 +612,23 @@ void *copy_gl_array_bgra(void* dest, const void *ptr, GLint stride, GLsizei widt
 
     if(!dest)
         dest = malloc(4*sizeof(GLfloat)*(count-skip));
+    STATS_ADD(array_bytes, 4*sizeof(GLfloat)*(count-skip));
     GLfloat* dst = dest;
     src += skip*(stride);
 
     static const float d = 1.0f/255.0f;
+#ifdef ARRAY_SIMD
+    simd_ubyte4_to_float4((uintptr_t)src, stride, 1, count-skip, dst, d);
+#else
     for (int i=skip; i<count; i++) {
-        #if defined(__ARM_NEON__) && !defined(__APPLE__)
-        int lsrc = *(int*)src;
-        lsrc = (lsrc&0xff00ff00) | ((lsrc&0x00ff0000)>>16) | ((lsrc&0x000000ff)<<16);
-        asm volatile (
-        "vmov           s12, %1              \n\t"   // because you cannot vmovl.u8 d6, s11
-        "vmovl.u8       q3, d6               \n\t"   // Expand to 16-bit (so unsetuped s13 is expanded in d7)
-        "vmovl.u16      q3, d6               \n\t"   // Expand to 32-bit, ignoring expanded d7
-        "vcvt.f32.u32   q3, q3               \n\t"   // Convert to float
-        "vmul.f32       q3, q3, %y2          \n\t"   // Normalize
-        "vst1.f32       {q3}, [%0]!          \n\t"   // Store, next
-        :"+r"(dst) :"r"(lsrc), "w"(d)
-        : "q3", "memory"
-        );
-        #else
         const GLubyte b = src[0], g = src[1], r = src[2], a = src[3];
         *dst++ = r*d;
         *dst++ = g*d;
         *dst++ = b*d;
         *dst++ = a*d;
-        #endif
         src+=stride;
     }
+#endif
     return dest;
 }
 
@@ -0,0 +1,268 @@
+#include "batch2d.h"
+
+#include "../glx/hardext.h"
+#include "wrap/gl4es.h"
+#include "blend.h"
+#include "gl4es.h"
+#include "glstate.h"
+#include "init.h"
+#include "matrix.h"
+
+#define BATCH2D_MAXBUCKETS  64
+#define BATCH2D_MAXBOXES    1024
+#define BATCH2D_MAXNODES    8       // renderlists in the pending block
+
+static int batch2d_state() {
+    // the buckets only keep the texture of TMU0 and the blend state, the rest is shared by all
+    // the deferred blocks (any other change flushes the pending block, and so the batcher)
+    if(glstate->render_mode==GL_SELECT || glstate->polygon_mode || glstate->enable.depth_test)
+        return 0;
+    if(glstate->glsl->program || glstate->enable.lighting || glstate->enable.color_sum || glstate->enable.fog)
+        return 0;
+    if(glstate->texture.active || (glstate->enable.texture[0] & ~(1<<ENABLED_TEX2D)))
+        return 0;
+    if(glstate->enable.texgen_s[0] || glstate->enable.texgen_t[0] || glstate->enable.texgen_r[0] || glstate->enable.texgen_q[0])
+        return 0;
+    for(int a=1; a<hardext.maxtex; ++a)
+        if(glstate->enable.texture[a])
+            return 0;
+    // orthographic projection: w is the same for every vertex
+    const GLfloat *mvp = getMVPMat();
+    return mvp[3]==0.f && mvp[7]==0.f && mvp[11]==0.f && mvp[15]!=0.f;
+}
+
+static int batch2d_node(renderlist_t *l, const GLfloat *mvp, GLfloat *box) {
+    // 1 if the renderlist only draws triangles (or quads / polygons), box gets its bounding box in NDC
+    if(l->calls.len || l->matrix_op || l->raster_op || l->raster || l->bitmaps || l->pushattribute || l->popattribute)
+        return 0;
+    if(l->render_op || l->fog_op || l->pointparam_op || l->linestipple_op || l->set_texture || l->set_tmu)
+        return 0;
+    if(l->material || l->colormat_face || l->light || l->lightmodel || l->texgen || l->texenv)
+        return 0;
+    if(!l->len)
+        return 1;
+    if(l->instanceCount!=1 || l->polygon_mode || l->iindices || l->ind_lines || l->final_colors || l->vbo_array)
+        return 0;
+    if(l->indices?(l->mode!=GL_TRIANGLES):(rendermode_dimensions(l->mode)<3))
+        return 0;
+    const int vs = l->vert_stride?l->vert_stride/sizeof(GLfloat):4;
+    box[0] = box[1] = 1e30f;
+    box[2] = box[3] = -1e30f;
+    for(int i=0; i<l->len; ++i) {
+        const GLfloat *v = l->vert+i*vs;
+        const GLfloat w = mvp[15]*v[3];
+        if(w<=0.f)
+            return 0;
+        const GLfloat x = (mvp[0]*v[0]+mvp[4]*v[1]+mvp[8]*v[2]+mvp[12]*v[3])/w;
+        const GLfloat y = (mvp[1]*v[0]+mvp[5]*v[1]+mvp[9]*v[2]+mvp[13]*v[3])/w;
+        if(x<box[0]) box[0] = x;
+        if(y<box[1]) box[1] = y;
+        if(x>box[2]) box[2] = x;
+        if(y>box[3]) box[3] = y;
+    }
+    return 1;
+}
+
+static int batch2d_ilen(renderlist_t *l) {
+    if(l->indices)
+        return l->ilen;
+    if(l->len<3)
+        return 0;
+    return indices_getindicesize(l->mode, l->len);
+}
+
+static int batch2d_same(batch2d_bucket_t *bk, GLuint texture) {
+    if(bk->texture!=texture || bk->blend!=glstate->enable.blend)
+        return 0;
+    return !bk->blend || (bk->blendfunc[0]==glstate->blendsfactorrgb && bk->blendfunc[1]==glstate->blenddfactorrgb
+        && bk->blendfunc[2]==glstate->blendsfactoralpha && bk->blendfunc[3]==glstate->blenddfactoralpha);
+}
+
+static int batch2d_overlap(const GLfloat *a, const GLfloat *b) {
+    // blocks that only touch don't share any pixel
+    return a[0]<b[2] && b[0]<a[2] && a[1]<b[3] && b[1]<a[3];
+}
+
+static void batch2d_copy(GLfloat *d, const GLfloat *s, int stride, int len, const GLfloat *def) {
+    // 4 components per vertex in d, s can be strided (in bytes), or NULL to repeat def
+    if(!s) {
+        for(int i=0; i<len; ++i)
+            memcpy(d+i*4, def, 4*sizeof(GLfloat));
+        return;
+    }
+    const int n = stride?stride/sizeof(GLfloat):4;
+    for(int i=0; i<len; ++i)
+        memcpy(d+i*4, s+i*n, 4*sizeof(GLfloat));
+}
+
+static void batch2d_append(renderlist_t *d, renderlist_t *l, int ilen) {
+    // copy the arrays of l at the end of d: vertex, color and texcoord of TMU0, the current values
+    // are used for the missing ones
+    if(d->len+l->len>d->cap) {
+        d->cap = (d->len+l->len)*2;
+        realloc_sublist(d->vert, 4, d->cap);
+        realloc_sublist(d->color, 4, d->cap);
+        realloc_sublist(d->tex[0], 4, d->cap);
+    }
+    if(d->ilen+ilen>d->indice_cap) {
+        d->indice_cap = (d->ilen+ilen)*2;
+        d->indices = (GLushort*)realloc(d->indices, d->indice_cap*sizeof(GLushort));
+    }
+    const int first = d->len;
+    batch2d_copy(d->vert+first*4, l->vert, l->vert_stride, l->len, NULL);
+    batch2d_copy(d->color+first*4, l->color, l->color_stride, l->len, glstate->color);
+    if(d->tex[0])
+        batch2d_copy(d->tex[0]+first*4, l->tex[0], l->tex_stride[0], l->len, glstate->texcoord[0]);
+    GLushort *ind = d->indices+d->ilen;
+    if(l->indices) {
+        for(int i=0; i<ilen; ++i)
+            ind[i] = l->indices[i]+first;
+    } else switch(l->mode) {
+        case GL_TRIANGLES:
+            renderlist_createindices(ilen, ind, first);
+            break;
+        case GL_QUADS:
+            renderlist_quads_triangles(NULL, l->len, ind, first);
+            break;
+        case GL_POLYGON:
+        case GL_TRIANGLE_FAN:
+            renderlist_trianglefan_triangles(NULL, l->len, ind, first);
+            break;
+        case GL_QUAD_STRIP:
+        case GL_TRIANGLE_STRIP:
+            renderlist_trianglestrip_triangles(NULL, l->len, ind, first);
+            break;
+    }
+    d->len += l->len;
+    d->ilen += ilen;
+}
+
+static void batch2d_add(batch2d_t *b, renderlist_t *l, const GLfloat *box) {
+    const int ilen = batch2d_ilen(l);
+    if(!ilen)
+        return;
+    gltexture_t *tex = glstate->texture.bound[0][ENABLED_TEX2D];
+    const GLuint texture = tex?tex->texture:0;
+    // latest bucket with the same state, it can't take the block if a later bucket overlaps it
+    int k = b->len-1;
+    while(k>=0 && !batch2d_same(b->bucket+k, texture))
+        --k;
+    if(k>=0 && b->bucket[k].list->len+l->len>65535)
+        k = -1;
+    for(int i=0; k>=0 && i<b->nbox; ++i)
+        if(b->box_bucket[i]>k && batch2d_overlap(b->box+i*4, box))
+            k = -1;
+    if(k<0) {
+        if(b->len==b->cap) {
+            b->cap += 16;
+            b->bucket = (batch2d_bucket_t*)realloc(b->bucket, b->cap*sizeof(batch2d_bucket_t));
+        }
+        k = b->len++;
+        batch2d_bucket_t *bk = b->bucket+k;
+        bk->texture = texture;
+        bk->blend = glstate->enable.blend;
+        bk->blendfunc[0] = glstate->blendsfactorrgb;
+        bk->blendfunc[1] = glstate->blenddfactorrgb;
+        bk->blendfunc[2] = glstate->blendsfactoralpha;
+        bk->blendfunc[3] = glstate->blenddfactoralpha;
+        renderlist_t *d = bk->list = alloc_renderlist();
+        d->mode = d->mode_init = GL_TRIANGLES;
+        d->mode_dimension = 3;
+        d->stage = STAGE_DRAW;
+        d->vert = alloc_sublist(4, d->cap);
+        d->color = alloc_sublist(4, d->cap);
+        if(IS_TEX2D(glstate->enable.texture[0])) {
+            d->tex[0] = alloc_sublist(4, d->cap);
+            d->maxtex = 1;
+        }
+    }
+    batch2d_append(b->bucket[k].list, l, ilen);
+    if(b->nbox==b->boxcap) {
+        b->boxcap += 64;
+        b->box = (GLfloat*)realloc(b->box, b->boxcap*4*sizeof(GLfloat));
+        b->box_bucket = (int*)realloc(b->box_bucket, b->boxcap*sizeof(int));
+    }
+    memcpy(b->box+b->nbox*4, box, 4*sizeof(GLfloat));
+    b->box_bucket[b->nbox++] = k;
+}
+
+int batch2d_defer() {
+    if(!globals4es.batch2d || glstate->list.compiling || !glstate->list.active || !batch2d_state())
+        return 0;
+    const GLfloat *mvp = getMVPMat();
+    renderlist_t *first = GetFirst(glstate->list.active);
+    GLfloat box[BATCH2D_MAXNODES][4];
+    int n = 0;
+    for(renderlist_t *l=first; l; l=l->next, ++n)
+        if(n==BATCH2D_MAXNODES || !batch2d_node(l, mvp, box[n]))
+            return 0;
+    // take the pending block
+    glstate->list.active = NULL;
+    glstate->list.pending = 0;
+    batch2d_t *b = &glstate->batch2d;
+    if(b->len+n>BATCH2D_MAXBUCKETS || b->nbox+n>BATCH2D_MAXBOXES)
+        batch2d_flush();
+    n = 0;
+    for(renderlist_t *l=first; l; l=l->next, ++n) {
+        if(l->len)
+            batch2d_add(b, l, box[n]);
+        // what draw_renderlist would leave behind
+        if(l->post_color) gl4es_glColor4fv(l->post_colors);
+        if(l->post_normal) gl4es_glNormal3fv(l->post_normals);
+    }
+    free_renderlist(first);
+    // an empty block stays pending, so the state changes that flush it also flush the batcher
+    renderlist_t *p = alloc_renderlist();
+    p->mode = p->mode_init = GL_TRIANGLES;
+    p->mode_dimension = 3;
+    p->stage = STAGE_POSTDRAW;
+    glstate->list.active = p;
+    glstate->list.pending = 1;
+    return 1;
+}
+
+void batch2d_flush() {
+    batch2d_t *b = &glstate->batch2d;
+    if(!b->len)
+        return;
+    const int len = b->len;
+    b->len = 0;     // nothing can be deferred while the state is changed below
+    b->nbox = 0;
+    // state of the application, restored at the end
+    const GLuint active = glstate->texture.active;
+    if(active)
+        gl4es_glActiveTexture(GL_TEXTURE0);
+    gltexture_t *tex = glstate->texture.bound[0][ENABLED_TEX2D];
+    const GLuint texture = tex?tex->texture:0;
+    const GLboolean blend = glstate->enable.blend;
+    const GLenum blendfunc[4] = {glstate->blendsfactorrgb, glstate->blenddfactorrgb, glstate->blendsfactoralpha, glstate->blenddfactoralpha};
+    for(int i=0; i<len; ++i) {
+        batch2d_bucket_t *bk = b->bucket+i;
+        gl4es_glBindTexture(GL_TEXTURE_2D, bk->texture);
+        if(bk->blend) {
+            gl4es_glEnable(GL_BLEND);
+            gl4es_glBlendFuncSeparate(bk->blendfunc[0], bk->blendfunc[1], bk->blendfunc[2], bk->blendfunc[3]);
+        } else
+            gl4es_glDisable(GL_BLEND);
+        draw_renderlist(bk->list);
+        free_renderlist(bk->list);
+        bk->list = NULL;
+    }
+    gl4es_glBindTexture(GL_TEXTURE_2D, texture);
+    gl4es_glBlendFuncSeparate(blendfunc[0], blendfunc[1], blendfunc[2], blendfunc[3]);
+    if(blend)
+        gl4es_glEnable(GL_BLEND);
+    else
+        gl4es_glDisable(GL_BLEND);
+    if(active)
+        gl4es_glActiveTexture(GL_TEXTURE0+active);
+}
+
+void batch2d_free(batch2d_t *b) {
+    for(int i=0; i<b->len; ++i)
+        free_renderlist(b->bucket[i].list);
+    free(b->bucket);
+    free(b->box);
+    free(b->box_bucket);
+    memset(b, 0, sizeof(batch2d_t));
+}
@@ -0,0 +1,35 @@
+#ifndef _GL4ES_BATCH2D_H_
+#define _GL4ES_BATCH2D_H_
+
+#include "list.h"
+
+// Deferred 2D batcher (LIBGL_BATCH2D): with an orthographic projection and no depth test, the
+// pending glBegin/glEnd block is not drawn when the texture or the blend state changes. It is
+// parked in a bucket for its texture and blend state instead, and a later block can join an older
+// bucket if it doesn't overlap anything deferred after that bucket. Everything is drawn, bucket by
+// bucket, at the next flush of the pending block (any other state change, or the swap).
+
+typedef struct {
+    renderlist_t    *list;      // GL_TRIANGLES with 16bits indices
+    GLuint          texture;    // bound on GL_TEXTURE0, GL_TEXTURE_2D
+    GLboolean       blend;
+    GLenum          blendfunc[4];
+} batch2d_bucket_t;
+
+typedef struct {
+    batch2d_bucket_t *bucket;
+    int             len, cap;
+    GLfloat         *box;       // x0, y0, x1, y1 in NDC of each deferred block
+    int             *box_bucket;
+    int             nbox, boxcap;
+} batch2d_t;
+
+// park the pending block in the batcher, returns 0 if it has to be flushed as usual
+int batch2d_defer();
+// draw everything that was deferred
+void batch2d_flush();
+void batch2d_free(batch2d_t *b);
+
+#define FLUSH_BEGINEND_2D if(glstate->list.pending && !batch2d_defer()) gl4es_flush()
+
+#endif // _GL4ES_BATCH2D_H_
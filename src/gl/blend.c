@@ -91,7 +91,7 @@ void APIENTRY_GL4ES gl4es_glBlendFuncSeparate(GLenum sfactorRGB, GLenum dfactorR
         && sfactorAlpha==glstate->blendsfactoralpha && dfactorAlpha==glstate->blenddfactoralpha)
         return; // no change...
 
-    FLUSH_BEGINEND;
+    FLUSH_BEGINEND_2D;
 
     if(globals4es.shaderblend) {
         int srcrgb = fpeBlendFunc(sfactorRGB);
@@ -106,6 +106,7 @@ void APIENTRY_GL4ES gl4es_glBlendFuncSeparate(GLenum sfactorRGB, GLenum dfactorR
         glstate->fpe_state->blenddstrgb = dstrgb;
         glstate->fpe_state->blendsrcalpha = srcalpha;
         glstate->fpe_state->blenddstalpha = dstalpha;
+        glstate->fpe_dirty = 1;
     } else {
     #ifndef PANDORA
         if(gles_glBlendFuncSeparate==NULL) {
@@ -148,6 +149,7 @@ void APIENTRY_GL4ES gl4es_glBlendEquationSeparate(GLenum modeRGB, GLenum modeA)
         }
         glstate->fpe_state->blendeqrgb = rgb;
         glstate->fpe_state->blendeqalpha = alpha;
+        glstate->fpe_dirty = 1;
     } else {
         LOAD_GLES2_OR_OES(glBlendEquationSeparate);
         #ifndef PANDORA
@@ -170,7 +172,7 @@ void APIENTRY_GL4ES gl4es_glBlendFunc(GLenum sfactor, GLenum dfactor) {
         && sfactor==glstate->blendsfactoralpha && dfactor==glstate->blenddfactoralpha)
         return; // already set
 
-    FLUSH_BEGINEND;
+    FLUSH_BEGINEND_2D;
 
     glstate->blendsfactorrgb = sfactor;
     glstate->blenddfactorrgb = dfactor;
@@ -190,6 +192,7 @@ void APIENTRY_GL4ES gl4es_glBlendFunc(GLenum sfactor, GLenum dfactor) {
         glstate->fpe_state->blenddstrgb = dstrgb;
         glstate->fpe_state->blendsrcalpha = srcalpha;
         glstate->fpe_state->blenddstalpha = dstalpha;
+        glstate->fpe_dirty = 1;
     } else {
         LOAD_GLES(glBlendFunc);
         LOAD_GLES2_OR_OES(glBlendFuncSeparate);
@@ -284,6 +287,7 @@ void APIENTRY_GL4ES gl4es_glBlendEquation(GLenum mode) {
         }
         glstate->fpe_state->blendeqrgb = rgb;
         glstate->fpe_state->blendeqalpha = alpha;
+        glstate->fpe_dirty = 1;
     } else {
         LOAD_GLES2_OR_OES(glBlendEquation);
         errorGL();
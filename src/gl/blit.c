@@ -9,6 +9,7 @@
 #include "init.h"
 #include "loader.h"
 #include "logs.h"
+#include "stats.h"
 #ifdef TEXSTREAM
 # ifndef GL_TEXTURE_STREAM_IMG
 # define GL_TEXTURE_STREAM_IMG                                   0x8C0D
@@ -66,6 +67,7 @@ void gl4es_blitTexture_gles1(GLuint texture,
         //TODO: do something with width / height of ViewPort?
         // then draw it
         gles_glDrawTexf(x+dx, y+dy, 0.0f, width, height);
+        STATS_INC(draws);
     } else {
         LOAD_GLES(glVertexPointer);
         LOAD_GLES(glTexCoordPointer);
@@ -121,6 +123,7 @@ void gl4es_blitTexture_gles1(GLuint texture,
         fpe_glDisableClientState(GL_COLOR_ARRAY);
         fpe_glDisableClientState(GL_NORMAL_ARRAY);
         gles_glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+        STATS_INC(draws);
 
         if(customvp)
             popViewport();
@@ -334,6 +337,7 @@ void gl4es_blitTexture_gles2(GLuint texture,
     realize_blitenv(alpha);
 
     gles_glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    STATS_INC(draws);
 }
 
 void gl4es_blitTexture(GLuint texture, 
@@ -738,9 +738,12 @@ void realize_bufferIndex()
 
 void deleteSingleBuffer(GLuint buffer) {
    LOAD_GLES(glDeleteBuffers);
-   if(glstate->bind_buffer.index == buffer) glstate->bind_buffer.index = 0;
-   else if(glstate->bind_buffer.want_index == buffer) glstate->bind_buffer.want_index = 0;
-   else if(glstate->bind_buffer.array == buffer) glstate->bind_buffer.array = 0;
+   // glstate is already gone when the lists of the default state are freed on exit
+   if(glstate) {
+      if(glstate->bind_buffer.index == buffer) glstate->bind_buffer.index = 0;
+      else if(glstate->bind_buffer.want_index == buffer) glstate->bind_buffer.want_index = 0;
+      else if(glstate->bind_buffer.array == buffer) glstate->bind_buffer.array = 0;
+   }
    gles_glDeleteBuffers(1, &buffer);
 }
 
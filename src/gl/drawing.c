@@ -9,6 +9,7 @@
 #include "list.h"
 #include "loader.h"
 #include "render.h"
+#include "stats.h"
 
 //#define DEBUG
 #ifdef DEBUG
@@ -40,7 +41,7 @@ static GLboolean is_cache_compatible(GLsizei count) {
     return GL_TRUE;
 }
 
-GLboolean is_list_compatible(renderlist_t* list) {
+GLboolean is_list_compatible(renderlist_t* list, GLsizei count) {
     #define T2(AA, A, B) \
     if(glstate->vao->AA!=(list->B!=NULL)) return GL_FALSE;
     #define TEST(A,B) T2(vertexattrib[A].enabled, A, B)
@@ -48,6 +49,8 @@ GLboolean is_list_compatible(renderlist_t* list) {
 
     if(list->post_color && !list->color) return GL_FALSE;
     if(list->post_normal && !list->normal) return GL_FALSE;
+    // merged lists use 16bits indices
+    if(list->len+count>60000) return GL_FALSE;
     TEST(ATT_VERTEX, vert)
     TEST(ATT_COLOR, color)
     TEST(ATT_SECONDARY, secondary)
@@ -423,6 +426,7 @@ if(count>500000) return;
         }
 
         // POLYGON mode as LINE is "intercepted" and drawn using list
+        STATS_INC(draws);
         if(instancecount==1 || hardext.esversion==1) {
             if(!iindices && !sindices)
                 gles_glDrawArrays(mode, first, count);
@@ -483,9 +487,11 @@ void APIENTRY_GL4ES gl4es_glDrawRangeElements(GLenum mode, GLuint start, GLuint
 	noerrorShim();
     GLushort *sindices = NULL;
     GLuint *iindices = NULL;
+    // a range too large for GLushort stays in GLuint in the renderlist
+    bool wide = (compiling || intercept) && type==GL_UNSIGNED_INT && hardext.elementuint && (end-start>=65536);
     bool need_free = !(
         (type==GL_UNSIGNED_SHORT) || 
-        (!compiling && !intercept && type==GL_UNSIGNED_INT && hardext.elementuint)
+        (((!compiling && !intercept) || wide) && type==GL_UNSIGNED_INT && hardext.elementuint)
         );
     if(need_free) {
         sindices = copy_gl_array((glstate->vao->elements)?(void*)((char*)glstate->vao->elements->data + (uintptr_t)indices):indices,
@@ -497,18 +503,24 @@ void APIENTRY_GL4ES gl4es_glDrawRangeElements(GLenum mode, GLuint start, GLuint
             sindices = (glstate->vao->elements)?((void*)((char*)glstate->vao->elements->data + (uintptr_t)indices)):(GLvoid*)indices;
     }
 
+    if(wide) {
+        GLuint *tmp = iindices;
+        iindices = (GLuint*)malloc(count*sizeof(GLuint));
+        for (int i=0; i<count; i++) iindices[i] = tmp[i]-start;
+    }
+
     if (compiling) {
-        // TODO, handle uint indices
         renderlist_t *list = glstate->list.active;
 
-        if(!need_free) {
+        if(!need_free && !wide) {
             GLushort *tmp = sindices;
             sindices = (GLushort*)malloc(count*sizeof(GLushort));
             memcpy(sindices, tmp, count*sizeof(GLushort));
         }
-        for (int i=0; i<count; i++) sindices[i]-=start; //TODO: should be optimizable
+        if(sindices)
+            for (int i=0; i<count; i++) sindices[i]-=start; //TODO: should be optimizable
 
-        if(globals4es.mergelist && list->stage>=STAGE_DRAW && is_list_compatible(list) && !list->use_glstate && sindices) {
+        if(globals4es.mergelist && list->stage>=STAGE_DRAW && is_list_compatible(list, end + 1 - start) && !list->use_glstate && sindices) {
             list = NewDrawStage(list, mode);
             if(list->vert) {
                 glstate->list.active = arrays_add_renderlist(list, mode, start, end + 1, sindices, count);
@@ -521,6 +533,7 @@ void APIENTRY_GL4ES gl4es_glDrawRangeElements(GLenum mode, GLuint start, GLuint
 
         glstate->list.active = list = arrays_to_renderlist(list, mode, start, end + 1);
         list->indices = sindices;
+        list->iindices = iindices;
         list->ilen = count;
         list->indice_cap = count;
         //end_renderlist(list);
@@ -530,17 +543,18 @@ void APIENTRY_GL4ES gl4es_glDrawRangeElements(GLenum mode, GLuint start, GLuint
     }
 
     if (intercept) {
-         //TODO handling uint indices
         renderlist_t *list = NULL;
 
-        if(!need_free) {
+        if(!need_free && !wide) {
             GLushort *tmp = sindices;
             sindices = (GLushort*)malloc(count*sizeof(GLushort));
             memcpy(sindices, tmp, count*sizeof(GLushort));
         }
-        for (int i=0; i<count; i++) sindices[i]-=start;
+        if(sindices)
+            for (int i=0; i<count; i++) sindices[i]-=start;
         list = arrays_to_renderlist(list, mode, start, end + 1);
         list->indices = sindices;
+        list->iindices = iindices;
         list->ilen = count;
         list->indice_cap = count;
         list = end_renderlist(list);
@@ -560,7 +574,6 @@ AliasExport(void,glDrawRangeElements,EXT,(GLenum mode,GLuint start,GLuint end,GL
 
 void APIENTRY_GL4ES gl4es_glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices) {
     DBG(printf("glDrawElements(%s, %d, %s, %p), vtx=%p map=%p, pending=%d\n", PrintEnum(mode), count, PrintEnum(type), indices, (glstate->vao->vertex)?glstate->vao->vertex->data:NULL, (glstate->vao->elements)?glstate->vao->elements->data:NULL, glstate->list.pending);)
-    // TODO: split for count > 65535?
     // special check for QUADS and TRIANGLES that need multiple of 4 or 3 vertex...
     count = adjust_vertices(mode, count);
     
@@ -590,9 +603,16 @@ void APIENTRY_GL4ES gl4es_glDrawElements(GLenum mode, GLsizei count, GLenum type
     GLushort *sindices = NULL;
     GLuint *iindices = NULL;
     GLuint old_index = 0;
+    GLsizei min, max;
+    // a range too large for GLushort stays in GLuint in the renderlist
+    bool wide = false;
+    if((compiling || intercept) && type==GL_UNSIGNED_INT && hardext.elementuint) {
+        getminmax_indices_ui((glstate->vao->elements)?((void*)((char*)glstate->vao->elements->data + (uintptr_t)indices)):(GLvoid*)indices, &max, &min, count);
+        wide = (max-min>=65536);
+    }
     bool need_free = !(
         (type==GL_UNSIGNED_SHORT) || 
-        (!compiling && !intercept && type==GL_UNSIGNED_INT && hardext.elementuint)
+        (((!compiling && !intercept) || wide) && type==GL_UNSIGNED_INT && hardext.elementuint)
         );
     if(need_free) {
         sindices = copy_gl_array((glstate->vao->elements)?(void*)((char*)glstate->vao->elements->data + (uintptr_t)indices):indices,
@@ -605,20 +625,26 @@ void APIENTRY_GL4ES gl4es_glDrawElements(GLenum mode, GLsizei count, GLenum type
             sindices = (glstate->vao->elements)?((void*)((char*)glstate->vao->elements->data + (uintptr_t)indices)):(GLvoid*)indices;
     }
 
+    if(wide) {
+        GLuint *tmp = iindices;
+        iindices = (GLuint*)malloc(count*sizeof(GLuint));
+        memcpy(iindices, tmp, count*sizeof(GLuint));
+        normalize_indices_ui(iindices, &max, &min, count);
+    }
+
     if (compiling) {
-        // TODO, handle uint indices
         renderlist_t *list = glstate->list.active;
-        GLsizei min, max;
 
-        if(!need_free) {
+        if(!need_free && !wide) {
             GLushort *tmp = sindices;
             sindices = (GLushort*)malloc(count*sizeof(GLushort));
             memcpy(sindices, tmp, count*sizeof(GLushort));
         }
 
-        normalize_indices_us(sindices, &max, &min, count);
+        if(sindices)
+            normalize_indices_us(sindices, &max, &min, count);
 
-        if(globals4es.mergelist && list->stage>=STAGE_DRAW && is_list_compatible(list) && !list->use_glstate && sindices) {
+        if(globals4es.mergelist && list->stage>=STAGE_DRAW && is_list_compatible(list, max + 1 - min) && !list->use_glstate && sindices) {
             list = NewDrawStage(list, mode);
             glstate->list.active = arrays_add_renderlist(list, mode, min, max + 1, sindices, count);
             NewStage(glstate->list.active, STAGE_POSTDRAW);
@@ -629,6 +655,7 @@ void APIENTRY_GL4ES gl4es_glDrawElements(GLenum mode, GLsizei count, GLenum type
 
         glstate->list.active = list = arrays_to_renderlist(list, mode, min, max + 1);
         list->indices = sindices;
+        list->iindices = iindices;
         list->ilen = count;
         list->indice_cap = count;
         //end_renderlist(list);
@@ -638,18 +665,18 @@ void APIENTRY_GL4ES gl4es_glDrawElements(GLenum mode, GLsizei count, GLenum type
     }
 
     if (intercept) {
-         //TODO handling uint indices
         renderlist_t *list = NULL;
-        GLsizei min, max;
 
-        if(!need_free) {
+        if(!need_free && !wide) {
             GLushort *tmp = sindices;
             sindices = (GLushort*)malloc(count*sizeof(GLushort));
             memcpy(sindices, tmp, count*sizeof(GLushort));
         }
-        normalize_indices_us(sindices, &max, &min, count);
+        if(sindices)
+            normalize_indices_us(sindices, &max, &min, count);
         list = arrays_to_renderlist(list, mode, min, max + 1);
         list->indices = sindices;
+        list->iindices = iindices;
         list->ilen = count;
         list->indice_cap = count;
         list = end_renderlist(list);
@@ -666,6 +693,65 @@ void APIENTRY_GL4ES gl4es_glDrawElements(GLenum mode, GLsizei count, GLenum type
 }
 AliasExport(void,glDrawElements,,(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices));
 
+// indices to draw count vertices from first as GL_QUADS
+static GLushort* quads_indices(GLint first, GLsizei count) {
+    if((first%4)==0) {
+        // the shared canonical ones
+        GLushort *indices = gl4es_quad_indices(first+count);
+        if(indices)
+            return indices+first*3/2;
+    }
+    static GLushort *indices = NULL;
+    static int indcnt = 0;
+    if(indcnt < count) {
+        indcnt = count;
+        if (indices) free(indices);
+        indices = (GLushort*)malloc(sizeof(GLushort)*(indcnt*3/2));
+    }
+    GLushort *p = indices;
+    for (int i=0, j=first; i+3<count; i+=4, j+=4) {
+            *(p++) = j + 0;
+            *(p++) = j + 1;
+            *(p++) = j + 2;
+
+            *(p++) = j + 0;
+            *(p++) = j + 2;
+            *(p++) = j + 3;
+    }
+    return indices;
+}
+
+// same, for when first+count goes past what GLushort can index
+static GLuint* quads_iindices(GLint first, GLsizei count) {
+    static GLuint *indices = NULL;
+    static int indcnt = 0;
+    if(indcnt < count) {
+        indcnt = count;
+        if (indices) free(indices);
+        indices = (GLuint*)malloc(sizeof(GLuint)*(indcnt*3/2));
+    }
+    GLuint *p = indices;
+    for (int i=0, j=first; i+3<count; i+=4, j+=4) {
+            *(p++) = j + 0;
+            *(p++) = j + 1;
+            *(p++) = j + 2;
+
+            *(p++) = j + 0;
+            *(p++) = j + 2;
+            *(p++) = j + 3;
+    }
+    return indices;
+}
+
+static void draw_quads(GLint first, GLsizei count, int instancecount) {
+    GLuint old_index = wantBufferIndex(0);
+    if(first+count>65536 && hardext.elementuint)
+        glDrawElementsCommon(GL_TRIANGLES, 0, count*3/2, first+count, NULL, quads_iindices(first, count), instancecount);
+    else
+        glDrawElementsCommon(GL_TRIANGLES, 0, count*3/2, count, quads_indices(first, count), NULL, instancecount);
+    wantBufferIndex(old_index);
+}
+
 void APIENTRY_GL4ES gl4es_glDrawArrays(GLenum mode, GLint first, GLsizei count) {
     DBG(printf("glDrawArrays(%s, %d, %d), list=%p pending=%d\n", PrintEnum(mode), first, count, glstate->list.active, glstate->list.pending);)
     // special check for QUADS and TRIANGLES that need multiple of 4 or 3 vertex...
@@ -680,13 +766,13 @@ void APIENTRY_GL4ES gl4es_glDrawArrays(GLenum mode, GLint first, GLsizei count)
         return;
     }
 
-    // special case for (very) large GL_QUADS array
-    if ((mode==GL_QUADS) && (count>4*8000)) {
+    // special case for (very) large GL_QUADS array, when 32bits indices are not available
+    if ((mode==GL_QUADS) && (count>4*8000) && !hardext.elementuint) {
         // split the array in manageable slice
         int cnt = 4*8000;
         for (int i=0; i<count; i+=4*8000) {
             if (i+cnt>count) cnt = count-i;
-            gl4es_glDrawArrays(mode, i, cnt);
+            gl4es_glDrawArrays(mode, first+i, cnt);
         }
         return;
     }
@@ -705,7 +791,7 @@ void APIENTRY_GL4ES gl4es_glDrawArrays(GLenum mode, GLint first, GLsizei count)
     if (glstate->list.active) {
         renderlist_t *list = glstate->list.active;
         
-        if(globals4es.mergelist && list->stage>=STAGE_DRAW && is_list_compatible(list) && !list->use_glstate) {
+        if(globals4es.mergelist && list->stage>=STAGE_DRAW && is_list_compatible(list, count) && !list->use_glstate) {
             list = NewDrawStage(list, mode);
             if(list->vert) {
                 glstate->list.active = arrays_add_renderlist(list, mode, first, count+first, NULL, 0);
@@ -733,33 +819,7 @@ void APIENTRY_GL4ES gl4es_glDrawArrays(GLenum mode, GLint first, GLsizei count)
         free_renderlist(list);
     } else {
         if (mode==GL_QUADS) {
-            // TODO: move those static in glstate
-            static GLushort *indices = NULL;
-            static int indcnt = 0;
-            static int indfirst = 0;
-            int realfirst = ((first%4)==0)?0:first;
-            int realcount = count + (first-realfirst);
-            if((indcnt < realcount) || (indfirst!=realfirst)) {
-                if(indcnt < realcount) {
-                    indcnt = realcount;
-                    if (indices) free(indices);
-                    indices = (GLushort*)malloc(sizeof(GLushort)*(indcnt*3/2));
-                }
-                indfirst = realfirst;
-                GLushort *p = indices;
-                for (int i=0, j=indfirst; i+3<indcnt; i+=4, j+=4) {
-                        *(p++) = j + 0;
-                        *(p++) = j + 1;
-                        *(p++) = j + 2;
-
-                        *(p++) = j + 0;
-                        *(p++) = j + 2;
-                        *(p++) = j + 3;
-                }
-            }
-            GLuint old_buffer = wantBufferIndex(0);
-            glDrawElementsCommon(GL_TRIANGLES, 0, count*3/2, count, indices+(first-indfirst)*3/2, NULL, 1);
-            wantBufferIndex(old_buffer);
+            draw_quads(first, count, 1);
             return;
         }
 
@@ -813,7 +873,7 @@ void APIENTRY_GL4ES gl4es_glMultiDrawArrays(GLenum mode, const GLint *firsts, co
         }
 
         if (compiling) {
-            if(globals4es.mergelist && glstate->list.active->stage>=STAGE_DRAW && is_list_compatible(glstate->list.active) && !glstate->list.active->use_glstate) {
+            if(globals4es.mergelist && glstate->list.active->stage>=STAGE_DRAW && is_list_compatible(glstate->list.active, count) && !glstate->list.active->use_glstate) {
                 glstate->list.active = NewDrawStage(glstate->list.active, mode);
                 glstate->list.active = arrays_add_renderlist(glstate->list.active, mode, first, count+first, NULL, 0);
                 NewStage(glstate->list.active, STAGE_POSTDRAW);
@@ -834,7 +894,7 @@ void APIENTRY_GL4ES gl4es_glMultiDrawArrays(GLenum mode, const GLint *firsts, co
             if(list) {
                 NewStage(list, STAGE_DRAW);
             }
-            if(globals4es.mergelist && list->stage>=STAGE_DRAW && is_list_compatible(list) && !list->use_glstate) {
+            if(globals4es.mergelist && list->stage>=STAGE_DRAW && is_list_compatible(list, count) && !list->use_glstate) {
                 list = NewDrawStage(list, mode);
                 list = arrays_add_renderlist(list, mode, first, count+first, NULL, 0);
                 NewStage(list, STAGE_POSTDRAW);
@@ -843,33 +903,7 @@ void APIENTRY_GL4ES gl4es_glMultiDrawArrays(GLenum mode, const GLint *firsts, co
                 list = arrays_to_renderlist(NULL, mode, first, count+first);
         } else {
             if (mode==GL_QUADS) {
-                // TODO: move those static in glstate
-                static GLushort *indices = NULL;
-                static int indcnt = 0;
-                static int indfirst = 0;
-                int realfirst = ((first%4)==0)?0:first;
-                int realcount = count + (first-realfirst);
-                if((indcnt < realcount) || (indfirst!=realfirst)) {
-                    if(indcnt < realcount) {
-                        indcnt = realcount;
-                        if (indices) free(indices);
-                        indices = (GLushort*)malloc(sizeof(GLushort)*(indcnt*3/2));
-                    }
-                    indfirst = realfirst;
-                    GLushort *p = indices;
-                    for (int i=0, j=indfirst; i+3<indcnt; i+=4, j+=4) {
-                            *(p++) = j + 0;
-                            *(p++) = j + 1;
-                            *(p++) = j + 2;
-
-                            *(p++) = j + 0;
-                            *(p++) = j + 2;
-                            *(p++) = j + 3;
-                    }
-                }
-                GLuint old_index = wantBufferIndex(0);
-                glDrawElementsCommon(GL_TRIANGLES, 0, count*3/2, count, indices+(first-indfirst)*3/2, NULL, 1);
-                wantBufferIndex(old_index);
+                draw_quads(first, count, 1);
                 continue;
             }
 
@@ -1319,13 +1353,13 @@ void APIENTRY_GL4ES gl4es_glDrawArraysInstanced(GLenum mode, GLint first, GLsize
         return;
     }
 
-    // special case for (very) large GL_QUADS array
-    if ((mode==GL_QUADS) && (count>4*8000)) {
+    // special case for (very) large GL_QUADS array, when 32bits indices are not available
+    if ((mode==GL_QUADS) && (count>4*8000) && !hardext.elementuint) {
         // split the array in manageable slice
         int cnt = 4*8000;
         for (int i=0; i<count; i+=4*8000) {
             if (i+cnt>count) cnt = count-i;
-            gl4es_glDrawArrays(mode, i, cnt);
+            gl4es_glDrawArraysInstanced(mode, first+i, cnt, primcount);
         }
         return;
     }
@@ -1367,33 +1401,7 @@ void APIENTRY_GL4ES gl4es_glDrawArraysInstanced(GLenum mode, GLint first, GLsize
         free_renderlist(list);
     } else {
         if (mode==GL_QUADS) {
-            // TODO: move those static in glstate
-            static GLushort *indices = NULL;
-            static int indcnt = 0;
-            static int indfirst = 0;
-            int realfirst = ((first%4)==0)?0:first;
-            int realcount = count + (first-realfirst);
-            if((indcnt < realcount) || (indfirst!=realfirst)) {
-                if(indcnt < realcount) {
-                    indcnt = realcount;
-                    if (indices) free(indices);
-                    indices = (GLushort*)malloc(sizeof(GLushort)*(indcnt*3/2));
-                }
-                indfirst = realfirst;
-                GLushort *p = indices;
-                for (int i=0, j=indfirst; i+3<indcnt; i+=4, j+=4) {
-                        *(p++) = j + 0;
-                        *(p++) = j + 1;
-                        *(p++) = j + 2;
-
-                        *(p++) = j + 0;
-                        *(p++) = j + 2;
-                        *(p++) = j + 3;
-                }
-            }
-            GLuint old_buffer = wantBufferIndex(0);
-            glDrawElementsCommon(GL_TRIANGLES, 0, count*3/2, count, indices+(first-indfirst)*3/2, NULL, primcount);
-            wantBufferIndex(old_buffer);
+            draw_quads(first, count, primcount);
             return;
         }
 
@@ -3,6 +3,7 @@
 #include "debug.h"
 #include "enum_info.h"
 #include "fpe_shader.h"
+#include "gl4es.h"
 #include "glcase.h"
 #include "init.h"
 #include "loader.h"
@@ -10,6 +11,7 @@
 #include "matvec.h"
 #include "program.h"
 #include "shaderconv.h"
+#include "stats.h"
 
 #include "fpe.h"
 
@@ -358,7 +360,7 @@ void APIENTRY_GL4ES fpe_oldprogram(fpe_state_t* state) {
     }
     gl4es_glAttachShader(glstate->fpe->prog, glstate->fpe->frag);
     // Ok, and now link the program
-    gl4es_glLinkProgram(glstate->fpe->prog);
+    gl4es_linkProgram(glstate->fpe->prog, 0);
     gl4es_glGetProgramiv(glstate->fpe->prog, GL_LINK_STATUS, &status);
     if(status!=GL_TRUE) {
         char buff[1000];
@@ -376,14 +378,24 @@ void APIENTRY_GL4ES fpe_oldprogram(fpe_state_t* state) {
 
 // ********* Shader stuffs handling *********
 void APIENTRY_GL4ES fpe_program(int ispoint) {
-    glstate->fpe_state->point = ispoint;
-    fpe_state_t state;
-    fpe_ReleventState(&state, glstate->fpe_state, 1);
-    if(glstate->fpe==NULL || memcmp(&glstate->fpe->state, &state, sizeof(fpe_state_t))) {
-        // get cached fpe (or new one)
-        glstate->fpe = fpe_GetCache(glstate->fpe_cache, &state, 1);
-    }   
+    if(glstate->fpe_state->point != ispoint) {
+        glstate->fpe_state->point = ispoint;
+        glstate->fpe_dirty = 1;
+    }
+    // the setters of fpe_state flag it dirty, so nothing to derive if it didn't change
+    if(glstate->fpe==NULL || glstate->fpe_dirty) {
+        fpe_state_t state;
+        fpe_ReleventState(&state, glstate->fpe_state, 1);
+        if(glstate->fpe==NULL || memcmp(&glstate->fpe->state, &state, sizeof(fpe_state_t))) {
+            // get cached fpe (or new one)
+            glstate->fpe = fpe_GetCache(glstate->fpe_cache, &state, 1);
+        }
+        glstate->fpe_dirty = 0;
+    }
+    STATS_INC(fpe_lookups);
     if(glstate->fpe->glprogram==NULL) {
+        STATS_INC(fpe_programs);
+        fpe_state_t state = glstate->fpe->state;
         glstate->fpe->prog = gl4es_glCreateProgram();
         DBG(int from_psa = 1;)
         if(fpe_GetProgramPSA(glstate->fpe->prog, &state)==0) {
@@ -422,7 +434,7 @@ void APIENTRY_GL4ES fpe_program(int ispoint) {
                 // program is already created
                 gl4es_glAttachShader(glstate->fpe->prog, glstate->fpe->vert);
                 gl4es_glAttachShader(glstate->fpe->prog, glstate->fpe->frag);
-                gl4es_glLinkProgram(glstate->fpe->prog);
+                gl4es_linkProgram(glstate->fpe->prog, 0);
                 gl4es_glGetProgramiv(glstate->fpe->prog, GL_LINK_STATUS, &status);
                 if(status!=GL_TRUE) {
                     char buff[1000];
@@ -449,12 +461,86 @@ void APIENTRY_GL4ES fpe_program(int ispoint) {
     }
 }
 
+// At the end of a frame, load a few FPE programs of the PSA that are not used yet, so the
+// states seen in previous runs don't stall the first frame that needs them
+void fpe_Prelink() {
+    if(!globals4es.fpeprelink || !glstate || !glstate->fpe_cache)
+        return;
+    fpe_state_t state;
+    int budget = globals4es.fpeprelink;
+    while(budget && fpe_NextPSA(&glstate->fpe_prelink, &state)) {
+        fpe_fpe_t *fpe = fpe_GetCache(glstate->fpe_cache, &state, 1);
+        if(fpe->glprogram)
+            continue;
+        --budget;
+        fpe->prog = gl4es_glCreateProgram();
+        if(fpe_GetProgramPSA(fpe->prog, &state)==0) {
+            // will be built from scratch by fpe_program if ever needed
+            gl4es_glDeleteProgram(fpe->prog);
+            fpe->prog = 0;
+            continue;
+        }
+        khint_t k_program;
+        khash_t(programlist) *programs = glstate->glsl->programs;
+        k_program = kh_get(programlist, programs, fpe->prog);
+        if (k_program != kh_end(programs))
+            fpe->glprogram = kh_value(programs, k_program);
+        DBG(printf("Prelinked FPE shader : %d(%p)\n", fpe->prog, fpe->glprogram);)
+    }
+}
+
+// the customized program fpe->prog is linked: find it, and adjust its uniforms to point to father cache
+static void fpe_CustomLinked(fpe_fpe_t *fpe, program_t* glprogram)
+{
+    // now find the program
+    khint_t k_program;
+    {
+        khash_t(programlist) *programs = glstate->glsl->programs;
+        k_program = kh_get(programlist, programs, fpe->prog);
+        if (k_program != kh_end(programs))
+            fpe->glprogram = kh_value(programs, k_program);
+    }
+    // adjust the uniforms to point to father cache...
+    {
+        khash_t(uniformlist) *father_uniforms = glprogram->uniform;
+        khash_t(uniformlist) *uniforms = fpe->glprogram->uniform;
+        uniform_t *m, *n;
+        khint_t k;
+        program_t *son = fpe->glprogram;
+        free(son->synced);
+        son->synced = (uniform_t**)malloc(kh_size(uniforms)*sizeof(uniform_t*));
+        son->synced_size = 0;
+        son->synced_gen = 0;
+        kh_foreach(uniforms, k, m,
+            if(!m->builtin) {
+                n = findUniform(father_uniforms, m->name);
+                if(n) {
+                    m->parent_offs = n->cache_offs;
+                    m->parent_size = n->cache_size;
+                    son->synced[son->synced_size++] = m;
+                }
+            }
+        )
+    }
+}
+
 program_t* APIENTRY_GL4ES fpe_CustomShader(program_t* glprogram, fpe_state_t* state)
 {
     // state is not empty and glprogram already has some cache (it may be empty, but kh'thingy is initialized)
     // TODO: what if program is composed of more then 1 vertex or fragment shader?
     fpe_fpe_t *fpe = fpe_GetCache((fpe_cache_t*)glprogram->fpe_cache, state, 0);
+    STATS_INC(fpe_lookups);
     if(fpe->glprogram==NULL) {
+        STATS_INC(fpe_programs);
+        // the customized program may be in the PSA
+        if(glprogram->psa_glsl[0]) {
+            fpe->prog = gl4es_glCreateProgram();
+            if(fpe_GetGLSLProgramPSA(fpe->prog, glprogram->psa_glsl, state)) {
+                fpe_CustomLinked(fpe, glprogram);
+                DBG(printf("loading FPE Custom Program from PSA : %d(%p)\n", fpe->prog, fpe->glprogram);)
+                return fpe->glprogram;
+            }
+        }
         GLint status;
         fpe->vert = gl4es_glCreateShader(GL_VERTEX_SHADER);
         gl4es_glShaderSource(fpe->vert, 1, fpe_CustomVertexShader(glprogram->last_vert->source, state, 0), NULL);
@@ -476,7 +562,8 @@ program_t* APIENTRY_GL4ES fpe_CustomShader(program_t* glprogram, fpe_state_t* st
             printf("LIBGL: FPE Custom Fragment shader compile failed: %s\n", buff);
             return glprogram;   // fallback to non-customized custom program..
         }
-        fpe->prog = gl4es_glCreateProgram();
+        if(!fpe->prog)
+            fpe->prog = gl4es_glCreateProgram();
         gl4es_glAttachShader(fpe->prog, fpe->vert);
         gl4es_glAttachShader(fpe->prog, fpe->frag);
         // re-run the BindAttribLocation if any
@@ -487,7 +574,7 @@ program_t* APIENTRY_GL4ES fpe_CustomShader(program_t* glprogram, fpe_state_t* st
                 gles_glBindAttribLocation(fpe->prog, al->index, al->name);
             );
         }
-        gl4es_glLinkProgram(fpe->prog);
+        gl4es_linkProgram(fpe->prog, 0);
         gl4es_glGetProgramiv(fpe->prog, GL_LINK_STATUS, &status);
         if(status!=GL_TRUE) {
             char buff[1000];
@@ -495,30 +582,8 @@ program_t* APIENTRY_GL4ES fpe_CustomShader(program_t* glprogram, fpe_state_t* st
             printf("LIBGL: FPE Custom Program link failed: %s\n", buff);
             return glprogram;   // fallback to non-customized custom program..
         }
-        // now find the program
-        khint_t k_program;
-        {
-            khash_t(programlist) *programs = glstate->glsl->programs;
-            k_program = kh_get(programlist, programs, fpe->prog);
-            if (k_program != kh_end(programs))
-                fpe->glprogram = kh_value(programs, k_program);
-        }
-        // adjust the uniforms to point to father cache...
-        {
-            khash_t(uniformlist) *father_uniforms = glprogram->uniform;
-            khash_t(uniformlist) *uniforms = fpe->glprogram->uniform;
-            uniform_t *m, *n;
-            khint_t k;
-            kh_foreach(uniforms, k, m,
-                if(!m->builtin) {
-                    n = findUniform(father_uniforms, m->name);
-                    if(n) {
-                        m->parent_offs = n->cache_offs;
-                        m->parent_size = n->cache_size;
-                    }
-                }
-            )
-        }
+        fpe_AddGLSLProgramPSA(fpe->prog, glprogram->psa_glsl, state);
+        fpe_CustomLinked(fpe, glprogram);
         // all done
         DBG(printf("creating FPE Custom Program : %d(%p)\n", fpe->prog, fpe->glprogram);)
     }
@@ -531,7 +596,9 @@ program_t* APIENTRY_GL4ES fpe_CustomShader_DefaultVertex(program_t* glprogram, f
     // state is not empty and glprogram already has some cache (it may be empty, but kh'thingy is initialized)
     // TODO: what if program is composed of more then 1 vertex or fragment shader?
     fpe_fpe_t *fpe = fpe_GetCache((fpe_cache_t*)glprogram->fpe_cache, state_vertex, 0);
+    STATS_INC(fpe_lookups);
     if(fpe->glprogram==NULL) {
+        STATS_INC(fpe_programs);
         GLint status;
         fpe->vert = gl4es_glCreateShader(GL_VERTEX_SHADER);
         gl4es_glShaderSource(fpe->vert, 1, fpe_VertexShader(glprogram->default_need, state_vertex), NULL);
@@ -564,7 +631,7 @@ program_t* APIENTRY_GL4ES fpe_CustomShader_DefaultVertex(program_t* glprogram, f
                 gles_glBindAttribLocation(fpe->prog, al->index, al->name);
             );
         }
-        gl4es_glLinkProgram(fpe->prog);
+        gl4es_linkProgram(fpe->prog, 0);
         gl4es_glGetProgramiv(fpe->prog, GL_LINK_STATUS, &status);
         if(status!=GL_TRUE) {
             char buff[1000];
@@ -572,30 +639,7 @@ program_t* APIENTRY_GL4ES fpe_CustomShader_DefaultVertex(program_t* glprogram, f
             printf("LIBGL: FPE Custom Program with Default Vertex link failed: %s\n", buff);
             return glprogram;   // fallback to non-customized custom program..
         }
-        // now find the program
-        khint_t k_program;
-        {
-            khash_t(programlist) *programs = glstate->glsl->programs;
-            k_program = kh_get(programlist, programs, fpe->prog);
-            if (k_program != kh_end(programs))
-                fpe->glprogram = kh_value(programs, k_program);
-        }
-        // adjust the uniforms to point to father cache...
-        {
-            khash_t(uniformlist) *father_uniforms = glprogram->uniform;
-            khash_t(uniformlist) *uniforms = fpe->glprogram->uniform;
-            uniform_t *m, *n;
-            khint_t k;
-            kh_foreach(uniforms, k, m,
-                if(!m->builtin) {
-                    n = findUniform(father_uniforms, m->name);
-                    if(n) {
-                        m->parent_offs = n->cache_offs;
-                        m->parent_size = n->cache_size;
-                    }
-                }
-            )
-        }
+        fpe_CustomLinked(fpe, glprogram);
         // all done
         DBG(printf("creating FPE Custom Program : %d(%p)\n", fpe->prog, fpe->glprogram);)
     }
@@ -604,14 +648,14 @@ program_t* APIENTRY_GL4ES fpe_CustomShader_DefaultVertex(program_t* glprogram, f
 }
 
 void APIENTRY_GL4ES fpe_SyncUniforms(uniformcache_t *cache, program_t* glprogram) {
-    //TODO: Optimize this...
-    khash_t(uniformlist) *uniforms = glprogram->uniform;
-    uniform_t *m;
-    khint_t k;
+    // only the uniforms whose value changed in the father cache since the last sync
+    if(glprogram->synced_gen==cache->gen)
+        return;
     DBG(int cnt = 0;)
     // don't use m->size, as each element has it's own uniform...
-    kh_foreach(uniforms, k, m,
-        if(m->parent_size) {
+    for (int i=0; i<glprogram->synced_size; ++i) {
+        uniform_t *m = glprogram->synced[i];
+        if(uniformcache_changed(cache, m->parent_offs, uniformsize(m->type), glprogram->synced_gen)) {
             DBG(++cnt;)
             switch(m->type) {
                 case GL_FLOAT:
@@ -645,7 +689,8 @@ void APIENTRY_GL4ES fpe_SyncUniforms(uniformcache_t *cache, program_t* glprogram
                     printf("LIBGL: Warning, sync uniform on father/son program with unknown uniform type %s\n", PrintEnum(m->type));
             }
         }
-    );
+    }
+    glprogram->synced_gen = cache->gen;
     DBG(printf("Uniform sync'd with %d and father (%d uniforms)\n", glprogram->id, cnt);)
 }
 // ********* Fixed Pipeling function wrapper *********
@@ -806,12 +851,32 @@ void APIENTRY_GL4ES fpe_glNormal3f(GLfloat nx, GLfloat ny, GLfloat nz) {
     noerrorShim();
 }
 
+// copy the indices of a streamed draw in the stream index ring, rebased. Return the offset to draw with
+static GLvoid* stream_drawindices(GLenum type, const GLvoid* indices, GLsizei count, scratch_t* scratch) {
+    LOAD_GLES(glBufferSubData);
+    int size = count*((type==GL_UNSIGNED_INT)?4:2);
+    void* tmp = NULL;
+    if(scratch->rebase) {
+        tmp = malloc(size);
+        if(type==GL_UNSIGNED_INT)
+            for(int i=0; i<count; ++i)
+                ((GLuint*)tmp)[i] = ((const GLuint*)indices)[i] - scratch->rebase;
+        else
+            for(int i=0; i<count; ++i)
+                ((GLushort*)tmp)[i] = ((const GLushort*)indices)[i] - scratch->rebase;
+    }
+    GLintptr offset = gl4es_stream_indices(size);
+    gles_glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, size, tmp?tmp:indices);
+    free(tmp);
+    return (GLvoid*)offset;
+}
+
 void APIENTRY_GL4ES fpe_glDrawArrays(GLenum mode, GLint first, GLsizei count) {
     DBG(printf("fpe_glDrawArrays(%s, %d, %d), program=%d, instanceID=%u\n", PrintEnum(mode), first, count, glstate->glsl->program, glstate->instanceID);)
     scratch_t scratch = {0};
     realize_glenv(mode==GL_POINTS, first, count, 0, NULL, &scratch);
     LOAD_GLES(glDrawArrays);
-    gles_glDrawArrays(mode, first, count);
+    gles_glDrawArrays(mode, first-scratch.rebase, count);
     free_scratch(&scratch);
 }
 
@@ -821,11 +886,21 @@ void APIENTRY_GL4ES fpe_glDrawElements(GLenum mode, GLsizei count, GLenum type,
     realize_glenv(mode==GL_POINTS, 0, count, type, indices, &scratch);
     LOAD_GLES(glDrawElements);
     int use_vbo = 0;
-    if(glstate->vao->elements && glstate->vao->elements->real_buffer && indices>=glstate->vao->elements->data && indices<=((void*)((char*)glstate->vao->elements->data+glstate->vao->elements->size))) {
+    if(scratch.streamed && scratch.rebase) {
+        use_vbo = 1;
+        indices = stream_drawindices(type, indices, count, &scratch);
+    } else if(glstate->vao->elements && glstate->vao->elements->real_buffer && indices>=glstate->vao->elements->data && indices<=((void*)((char*)glstate->vao->elements->data+glstate->vao->elements->size))) {
         use_vbo = 1;
         bindBuffer(GL_ELEMENT_ARRAY_BUFFER, glstate->vao->elements->real_buffer);
         indices = (GLvoid*)((uintptr_t)indices - (uintptr_t)(glstate->vao->elements->data));
         DBG(printf("Using VBO %d for indices\n", glstate->vao->elements->real_buffer);)
+    } else if(type==GL_UNSIGNED_SHORT && glstate->quad_indices_buffer && (const GLushort*)indices>=glstate->quad_indices && (const GLushort*)indices<glstate->quad_indices+glstate->quad_indices_len*3/2) {
+        use_vbo = 1;
+        bindBuffer(GL_ELEMENT_ARRAY_BUFFER, glstate->quad_indices_buffer);
+        indices = (GLvoid*)((uintptr_t)indices - (uintptr_t)(glstate->quad_indices));
+    } else if(scratch.streamed) {
+        use_vbo = 1;
+        indices = stream_drawindices(type, indices, count, &scratch);
     }
     realize_bufferIndex();
     gles_glDrawElements(mode, count, type, indices);
@@ -879,7 +954,7 @@ void APIENTRY_GL4ES fpe_glDrawArraysInstanced(GLenum mode, GLint first, GLsizei
                 }
             }
         }
-        gles_glDrawArrays(mode, first, count);
+        gles_glDrawArrays(mode, first-scratch.rebase, count);
     }
     free_scratch(&scratch);
 }
@@ -893,10 +968,20 @@ void APIENTRY_GL4ES fpe_glDrawElementsInstanced(GLenum mode, GLsizei count, GLen
     int use_vbo = 0;
     void* inds;
     GLfloat tmp[4] = {0.0f, 0.0f, 0.0f, 1.0f};
-    if(glstate->vao->elements && glstate->vao->elements->real_buffer && indices>=glstate->vao->elements->data && indices<=((void*)((char*)glstate->vao->elements->data+glstate->vao->elements->size))) {
+    if(scratch.streamed && scratch.rebase) {
+        use_vbo = 1;
+        inds = stream_drawindices(type, indices, count, &scratch);
+    } else if(glstate->vao->elements && glstate->vao->elements->real_buffer && indices>=glstate->vao->elements->data && indices<=((void*)((char*)glstate->vao->elements->data+glstate->vao->elements->size))) {
         use_vbo = 1;
         bindBuffer(GL_ELEMENT_ARRAY_BUFFER, glstate->vao->elements->real_buffer);
         inds = (void*)((uintptr_t)indices - (uintptr_t)(glstate->vao->elements->data));
+    } else if(type==GL_UNSIGNED_SHORT && glstate->quad_indices_buffer && (const GLushort*)indices>=glstate->quad_indices && (const GLushort*)indices<glstate->quad_indices+glstate->quad_indices_len*3/2) {
+        use_vbo = 1;
+        bindBuffer(GL_ELEMENT_ARRAY_BUFFER, glstate->quad_indices_buffer);
+        inds = (void*)((uintptr_t)indices - (uintptr_t)(glstate->quad_indices));
+    } else if(scratch.streamed) {
+        use_vbo = 1;
+        inds = stream_drawindices(type, indices, count, &scratch);
     } else {
         inds = (void*)indices;
         bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -967,9 +1052,11 @@ void APIENTRY_GL4ES fpe_glMaterialfv(GLenum face, GLenum pname, const GLfloat *p
 void APIENTRY_GL4ES fpe_glMaterialf(GLenum face, GLenum pname, const GLfloat param) {
     if(face==GL_FRONT_AND_BACK || face==GL_FRONT) {
         glstate->fpe_state->cm_front_nullexp=(param<=0.0)?0:1;
+        glstate->fpe_dirty = 1;
     }
     if(face==GL_FRONT_AND_BACK || face==GL_BACK) {
         glstate->fpe_state->cm_back_nullexp=(param<=0.0)?0:1;
+        glstate->fpe_dirty = 1;
     }
     noerrorShim();
 }
@@ -977,6 +1064,7 @@ void APIENTRY_GL4ES fpe_glMaterialf(GLenum face, GLenum pname, const GLfloat par
 void APIENTRY_GL4ES fpe_glFogfv(GLenum pname, const GLfloat* params) {
     noerrorShim();
     if(pname==GL_FOG_MODE) {
+        glstate->fpe_dirty = 1;
         int p = *params;
         switch(p) {
             case GL_EXP: glstate->fpe_state->fogmode = FPE_FOG_EXP; break;
@@ -985,6 +1073,7 @@ void APIENTRY_GL4ES fpe_glFogfv(GLenum pname, const GLfloat* params) {
             default: errorShim(GL_INVALID_ENUM);
         }
     } else if (pname==GL_FOG_COORDINATE_SOURCE) {
+        glstate->fpe_dirty = 1;
         int p = *params;
         switch(p) {
             case GL_FRAGMENT_DEPTH: glstate->fpe_state->fogsource = FPE_FOG_SRC_DEPTH; break;
@@ -992,6 +1081,7 @@ void APIENTRY_GL4ES fpe_glFogfv(GLenum pname, const GLfloat* params) {
             default: errorShim(GL_INVALID_ENUM);
         }
     } else if (pname==GL_FOG_DISTANCE_MODE_NV) {
+        glstate->fpe_dirty = 1;
         int p = *params;
         switch(p) {
             case GL_EYE_PLANE_ABSOLUTE_NV: glstate->fpe_state->fogdist = FPE_FOG_DIST_PLANE_ABS; break;
@@ -1043,6 +1133,88 @@ int fpe_gettexture(int TMU) {
     return target;
 }
 
+// upload the client arrays used by the draw in the stream ring VBO (LIBGL_STREAMVBO)
+// overlapping arrays (interleaved) share the same chunk, and the first vertex used is rebased to 0
+static void stream_glenv(program_t *glprogram, int first, int count, GLenum type, const void* indices, scratch_t* scratch, GLintptr* offsets) {
+    LOAD_GLES(glBufferSubData);
+    uintptr_t start[MAX_VATTRIB], end[MAX_VATTRIB], astart[MAX_VATTRIB];
+    int group[MAX_VATTRIB];
+    int n = 0;
+    for(int i=0; i<hardext.maxvattrib; i++) {
+        group[i] = -1;
+        if(!glprogram->va_size[i])
+            continue;
+        vertexattrib_t *w = &glstate->vao->vertexattrib[i];
+        if(!w->enabled || w->divisor || (!w->buffer && !w->pointer) || w->size==GL_BGRA)
+            continue;   // BGRA is converted in a scratch array anyway
+        if(w->real_buffer || w->type==GL_DOUBLE)
+            return;     // a real VBO cannot be rebased
+        group[i] = n++;
+    }
+    if(!n)
+        return;
+    int imin, imax;
+    if(type==0) {
+        imin = first; imax = first+count;
+    } else {
+        if(count*((type==GL_UNSIGNED_INT)?4:2) > globals4es.streamvbo*256*1024)
+            return; // indices will not fit in the index ring
+        if(type==GL_UNSIGNED_INT)
+            getminmax_indices_ui(indices, &imax, &imin, count);
+        else
+            getminmax_indices_us(indices, &imax, &imin, count);
+        ++imax;
+    }
+    n = 0;
+    for(int i=0; i<hardext.maxvattrib; i++) {
+        if(group[i]==-1)
+            continue;
+        vertexattrib_t *w = &glstate->vao->vertexattrib[i];
+        int elem = gl_sizeof(w->type)*w->size;
+        int stride = (w->stride)?w->stride:elem;
+        uintptr_t p = (uintptr_t)w->pointer + ((w->buffer)?(uintptr_t)w->buffer->data:0);
+        astart[i] = start[n] = p + imin*stride;
+        end[n] = p + (imax-1)*stride + elem;
+        group[i] = n++;
+    }
+    // merge overlapping spans
+    int a = 0;
+    while(a<n) {
+        int b;
+        for(b=a+1; b<n; ++b)
+            if(start[b]<end[a] && end[b]>start[a])
+                break;
+        if(b==n) {
+            ++a;
+            continue;
+        }
+        if(start[b]<start[a]) start[a] = start[b];
+        if(end[b]>end[a]) end[a] = end[b];
+        --n;
+        for(int i=0; i<hardext.maxvattrib; i++)
+            if(group[i]==b) group[i] = a;
+            else if(group[i]==n) group[i] = b;
+        start[b] = start[n];
+        end[b] = end[n];
+        a = 0;  // grown span may now overlap a previous one
+    }
+    GLintptr pos[MAX_VATTRIB];
+    GLsizeiptr total = 0;
+    for(int g=0; g<n; ++g) {
+        pos[g] = total;
+        total += (end[g]-start[g]+15)&~15;
+    }
+    GLintptr base = gl4es_stream_vertex(total);
+    if(base<0)
+        return;
+    for(int g=0; g<n; ++g)
+        gles_glBufferSubData(GL_ARRAY_BUFFER, base+pos[g], end[g]-start[g], (void*)start[g]);
+    for(int i=0; i<hardext.maxvattrib; i++)
+        offsets[i] = (group[i]==-1)?-1:(base+pos[group[i]]+(astart[i]-start[group[i]]));
+    scratch->streamed = 1;
+    scratch->rebase = imin;
+}
+
 void realize_glenv(int ispoint, int first, int count, GLenum type, const void* indices, scratch_t* scratch) {
     // the handling of GL_BGRA size of GL_DOUBLE using 1 scratch in not ideal, and a waste when dealing with Buffers
     // TODO: have the scratch buffer part of the VBO, and tag it dirty when buffer is changed (or always dirty for VBO 0)
@@ -1056,10 +1228,10 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
     // update texture state for fpe only
     if(glstate->fpe_bound_changed && !glstate->glsl->program) {
         for(int i=0; i<glstate->fpe_bound_changed; i++) {
-            glstate->fpe_state->texture[i].texformat = 0;
-            glstate->fpe_state->texture[i].texadjust = 0;
+            int texformat = 0;
+            int texadjust = 0;
             // disable texture unit, in that case (binded texture iconsts not valid)
-            glstate->fpe_state->texture[i].textype = 0;
+            int textype = 0;
             int texunit = fpe_gettexture(i);
             gltexture_t* tex = (texunit==-1)?NULL:glstate->texture.bound[i][texunit];
             if(tex && tex->valid) {
@@ -1075,10 +1247,18 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
                     else if(texunit==ENABLED_TEX3D) fmt = FPE_TEX_3D;
                     else fmt = FPE_TEX_2D;
                 }
-                glstate->fpe_state->texture[i].texformat = tex->fpe_format;
-                glstate->fpe_state->texture[i].texadjust = tex->adjust;
-                if(texunit==ENABLED_TEXTURE_RECTANGLE) glstate->fpe_state->texture[i].texadjust = 1;
-                glstate->fpe_state->texture[i].textype = fmt;
+                texformat = tex->fpe_format;
+                texadjust = tex->adjust;
+                if(texunit==ENABLED_TEXTURE_RECTANGLE) texadjust = 1;
+                textype = fmt;
+            }
+            // binding another texture of the same kind doesn't change the program
+            fpe_texture_t *t = &glstate->fpe_state->texture[i];
+            if(t->texformat!=texformat || t->texadjust!=texadjust || t->textype!=textype) {
+                t->texformat = texformat;
+                t->texadjust = texadjust;
+                t->textype = textype;
+                glstate->fpe_dirty = 1;
             }
         }
         glstate->fpe_bound_changed = 0;
@@ -1161,23 +1341,30 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
         }
     }
     // setup fixed pipeline builtin matrix uniform if needed
+    // (only when the matrices changed since the last time they were sent to this program)
     if(glprogram->has_builtin_matrix)
     {
-        if(glprogram->builtin_matrix[MAT_MVP]!=-1 || glprogram->builtin_matrix[MAT_MVP_I]!=-1
+        builtin_matgen_t *gen = &glprogram->builtin_matgen;
+        const uint64_t mvgen = glstate->modelview_matrix->gen;
+        const uint64_t pgen = glstate->projection_matrix->gen;
+        if((glprogram->builtin_matrix[MAT_MVP]!=-1 || glprogram->builtin_matrix[MAT_MVP_I]!=-1
             || glprogram->builtin_matrix[MAT_MVP_T]!=-1 || glprogram->builtin_matrix[MAT_MVP_IT]!=-1)
+            && (gen->mvp[0]!=pgen || gen->mvp[1]!=mvgen))
         {
+            gen->mvp[0] = pgen;
+            gen->mvp[1] = mvgen;
             GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MVP], 1, GL_FALSE, getMVPMat());
             GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MVP_T], 1, GL_TRUE, getMVPMat());
             if(glprogram->builtin_matrix[MAT_MVP_I]!=-1 || glprogram->builtin_matrix[MAT_MVP_IT]!=-1) {
-                GLfloat invmat[16];
-                matrix_inverse(getMVPMat(), invmat);
-                GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MVP_I], 1, GL_FALSE, invmat);
-                GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MVP_IT], 1, GL_TRUE, invmat);
+                GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MVP_I], 1, GL_FALSE, getInvMVPMat());
+                GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MVP_IT], 1, GL_TRUE, getInvMVPMat());
             }
         }
-        if(glprogram->builtin_matrix[MAT_MV]!=-1 || glprogram->builtin_matrix[MAT_MV_I]!=-1
+        if((glprogram->builtin_matrix[MAT_MV]!=-1 || glprogram->builtin_matrix[MAT_MV_I]!=-1
             || glprogram->builtin_matrix[MAT_MV_T]!=-1 || glprogram->builtin_matrix[MAT_MV_IT]!=-1)
+            && gen->mv!=mvgen)
         {
+            gen->mv = mvgen;
             GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MV], 1, GL_FALSE, getMVMat());
             GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MV_T], 1, GL_TRUE, getMVMat());
             if(glprogram->builtin_matrix[MAT_MV_I]!=-1 || glprogram->builtin_matrix[MAT_MV_IT]!=-1) {
@@ -1185,14 +1372,15 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
                 GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MV_IT], 1, GL_TRUE, getInvMVMat());
             }
         }
-        if(glprogram->builtin_matrix[MAT_P]!=-1 || glprogram->builtin_matrix[MAT_P_I]!=-1
+        if((glprogram->builtin_matrix[MAT_P]!=-1 || glprogram->builtin_matrix[MAT_P_I]!=-1
             || glprogram->builtin_matrix[MAT_P_T]!=-1 || glprogram->builtin_matrix[MAT_P_IT]!=-1)
+            && gen->p!=pgen)
         {
+            gen->p = pgen;
             GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_P], 1, GL_FALSE, getPMat());
             GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_P_T], 1, GL_TRUE, getPMat());
             if(glprogram->builtin_matrix[MAT_P_I]!=-1 || glprogram->builtin_matrix[MAT_P_IT]!=-1) {
-                GLfloat invmat[16];
-                matrix_inverse(getPMat(), invmat);
+                GLfloat *invmat = getInvMat(glstate->projection_matrix);
                 GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_P_I], 1, GL_FALSE, invmat);
                 GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_P_IT], 1, GL_TRUE, invmat);
             }
@@ -1205,8 +1393,9 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
                 float tmp = 1.0f;
                 GoUniformfv(glprogram, glprogram->builtin_normalrescale, 1, 1, &tmp);
             }
-            if(glprogram->builtin_matrix[MAT_N]!=-1)
+            if(glprogram->builtin_matrix[MAT_N]!=-1 && gen->n!=mvgen)
             {
+                gen->n = mvgen;
                 GoUniformMatrix3fv(glprogram, glprogram->builtin_matrix[MAT_N], 1, GL_FALSE, getNormalMat());
             }
             if((glprogram->builtin_normalrescale!=-1 && glstate->fpe_state->rescaling))
@@ -1220,14 +1409,15 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
         }
         //Texture matrices
         for (int i=0; i<MAX_TEX; i++) {
-            if(glprogram->builtin_matrix[MAT_T0+i*4]!=-1 || glprogram->builtin_matrix[MAT_T0_I+i*4]!=-1
+            if((glprogram->builtin_matrix[MAT_T0+i*4]!=-1 || glprogram->builtin_matrix[MAT_T0_I+i*4]!=-1
                 || glprogram->builtin_matrix[MAT_T0_T+i*4]!=-1 || glprogram->builtin_matrix[MAT_T0_IT+i*4]!=-1)
+                && gen->t[i]!=glstate->texture_matrix[i]->gen)
             {
+                gen->t[i] = glstate->texture_matrix[i]->gen;
                 GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_T0+i*4], 1, GL_FALSE, getTexMat(i));
                 GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_T0_T+i*4], 1, GL_TRUE, getTexMat(i));
                 if(glprogram->builtin_matrix[MAT_T0_I+i*4]!=-1 || glprogram->builtin_matrix[MAT_T0_IT+i*4]!=-1) {
-                    GLfloat invmat[16];
-                    matrix_inverse(getTexMat(i), invmat);
+                    GLfloat *invmat = getInvMat(glstate->texture_matrix[i]);
                     GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_T0_I+i*4], 1, GL_FALSE, invmat);
                     GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_T0_IT+i*4], 1, GL_TRUE, invmat);
                 }
@@ -1427,6 +1617,11 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
         GO(Cube)
         #undef GO
     }
+    // stream client arrays if needed
+    GLintptr streamed[MAX_VATTRIB];
+    // (indices have to be client side, not an offset in a bound index buffer)
+    if(globals4es.streamvbo && count && (type==0 || ((type==GL_UNSIGNED_SHORT || type==GL_UNSIGNED_INT) && !glstate->bind_buffer.want_index)))
+        stream_glenv(glprogram, first, count, type, indices, scratch, streamed);
     // set VertexAttrib if needed
     for(int i=0; i<hardext.maxvattrib; i++) 
     if(glprogram->va_size[i])   // only check used VA...
@@ -1475,7 +1670,7 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
                         v->normalized = 0;
                         v->integer = 0;
                         v->pointer = scratch->scratch[scratch->size++] = copy_gl_pointer_color_bgra(ptr, w->stride, 4, imin, imax);
-                        v->pointer = (char*)v->pointer - imin*4*sizeof(GLfloat);   // adjust for min...
+                        v->pointer = (char*)v->pointer - (imin-scratch->rebase)*4*sizeof(GLfloat);   // adjust for min...
                         v->stride = 0;
                         v->buffer = NULL;
                         v->real_buffer = 0;
@@ -1487,6 +1682,15 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
                             warn=0;
                         }
                     }
+                } else if(scratch->streamed && streamed[i]!=-1) {
+                    v->size = w->size;
+                    v->type = w->type;
+                    v->normalized = w->normalized;
+                    v->integer = w->integer;
+                    v->stride = w->stride;
+                    v->real_buffer = glstate->stream_vertex;
+                    v->real_pointer = v->pointer = (void*)streamed[i];
+                    v->buffer = NULL;
                 } else {
                     v->size = w->size;
                     v->type = w->type;
@@ -1608,6 +1812,7 @@ void builtin_Init(program_t *glprogram) {
     // initialise emulated builtin matrix uniform to -1
     for (int i=0; i<MAT_MAX; i++)
         glprogram->builtin_matrix[i] = -1;
+    memset(&glprogram->builtin_matgen, 0, sizeof(builtin_matgen_t));
     for (int i=0; i<MAX_LIGHT; i++) {
         glprogram->builtin_lights[i].ambient = -1;
         glprogram->builtin_lights[i].diffuse = -1;
@@ -234,6 +234,8 @@ typedef struct kh_fpecachelist_s kh_fpecachelist_t;
 typedef struct scratch_s {
     void*       scratch[16];
     int         size;
+    int         streamed;   // vertex arrays are in the stream ring VBO
+    int         rebase;     // first vertex streamed, to be removed from first / indices
 } scratch_t;
 void free_scratch(scratch_t* scratch);
 
@@ -281,5 +283,7 @@ int builtin_CheckVertexAttrib(program_t *glprogram, char* name, GLint id);
 
 void realize_glenv(int ispoint, int first, int count, GLenum type, const void* indices, scratch_t* scratch);
 void realize_blitenv(int alpha);
+// load some of the FPE programs of the PSA ahead of time (LIBGL_FPEPRELINK), called at the end of a frame
+void fpe_Prelink();
 
 #endif // _GL4ES_FPE_H_
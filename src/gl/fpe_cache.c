@@ -35,9 +35,20 @@ static const char PSA_SIGN[] = "GL4ES PrecompiledShaderArchive";
 
 static kh_inline khint_t _hash_fpe(fpe_state_t *p)
 {
-    const char* s = (const char*)p;
-    khint_t h = (khint_t)*s;
-    for (int i=1 ; i<sizeof(fpe_state_t); ++i) h = (h << 5) - h + (khint_t)*(++s);
+    // 32bits at a time (murmur3 mixing), the state is packed so it may not be aligned
+    const unsigned char* s = (const unsigned char*)p;
+    uint32_t h = 0, w;
+    int i;
+    for (i=0; i+4<=sizeof(fpe_state_t); i+=4) {
+        memcpy(&w, s+i, 4);
+        w *= 0xcc9e2d51u; w = (w<<15)|(w>>17); w *= 0x1b873593u;
+        h ^= w; h = (h<<13)|(h>>19); h = h*5 + 0xe6546b64u;
+    }
+    for (w=0; i<sizeof(fpe_state_t); ++i)
+        w = (w<<8) | s[i];
+    w *= 0xcc9e2d51u; w = (w<<15)|(w>>17); w *= 0x1b873593u;
+    h ^= w;
+    h ^= h>>16; h *= 0x85ebca6bu; h ^= h>>13; h *= 0xc2b2ae35u; h ^= h>>16;
     return h;
 }
 
@@ -88,144 +99,356 @@ fpe_fpe_t *fpe_GetCache(fpe_cache_t *cur, fpe_state_t *state, int fixed) {
     }
 }
 
-typedef struct psa_s {
+// Precompiled Shader Archive
+//  v1 (legacy): header, then all programs, rewritten entirely when the process exits
+//  v2: header, then a list of chunks. Each chunk is an index of programs (state, format, size
+//      and offset of the binary) followed by the binaries. The file is mapped, so only the
+//      indexes are read at startup, and a binary is read only when its program is used.
+//      New programs are appended as a new chunk, and the file is compacted in one chunk when
+//      there are too many of them.
+
+static const char PSA2_SIGN[] = "GL4ES PrecompiledShaderArchive2";
+#define PSA_MAXCHUNKS   64      // compact the archive when it has more chunks than this
+
+typedef struct psa_header_s {
+    char        sign[sizeof(PSA2_SIGN)];
+    int         version;
+    int         sz_entry;   // size of psa_entry_t, any change of layout invalidates the archive
+} psa_header_t;
+
+typedef struct psa_chunk_s {
+    int         count;      // number of programs
+    int         size;       // size of the chunk in bytes, header included
+} psa_chunk_t;
+
+// FPE programs are identified by their state only, GLSL programs by the hash of their sources and
+// attrib locations, and by their fpe_state_t customization (all 0 for the program itself)
+typedef struct psa_key_s {
     fpe_state_t state;
+    uint32_t    glsl[3];    // program hash, vertex shader hash, fragment shader hash (0 for FPE programs)
+} psa_key_t;
+
+typedef struct psa_entry_s {
+    psa_key_t   key;
+    GLenum      format;
+    int         size;
+    int         offset;     // of the binary, from the start of the chunk
+} psa_entry_t;
+
+#define PSA_ALIGN(a)    (((a)+3)&~3)
+
+typedef struct psa_s {
+    const psa_key_t *key;
     GLenum      format;
     int         size;
-    void*       prog;
+    const void* prog;
+    int         owned;      // key and prog are not in the mapped file
 } psa_t;
 
-KHASH_MAP_INIT_FPE(psalist, psa_t *);
+static kh_inline khint_t _hash_psa(const psa_key_t *p)
+{
+    khint_t h = _hash_fpe((fpe_state_t*)&p->state);
+    for (int i=0; i<3; ++i) h = (h << 5) - h + p->glsl[i];
+    return h;
+}
+typedef const psa_key_t *kh_psa_t;
+#define kh_psa_hash_func(key) _hash_psa(key)
+#define kh_psa_hash_equal(a, b) (memcmp(a, b, sizeof(psa_key_t)) == 0)
+KHASH_INIT(psalist, kh_psa_t, psa_t *, 1, kh_psa_hash_func, kh_psa_hash_equal);
+// the shaders of the GLSL programs in the archive
+KHASH_SET_INIT_INT(psashaders);
+
+typedef enum {
+    PSA_FILE_NEW = 0,       // no usable file, create it when the first program is added
+    PSA_FILE_APPEND,        // valid v2 file, new programs are appended
+    PSA_FILE_REWRITE,       // legacy or damaged file, rewritten when the PSA is saved
+    PSA_FILE_NONE           // valid file that could not be loaded, left untouched
+} psa_file_t;
 
-// Precompiled Shader Archive
 typedef struct gl4es_psa_s {
     int             size;
-    int             dirty;
+    int             chunks;     // chunks in the file
+    int             dead;       // programs in the file that have been replaced
+    psa_file_t      file;
+    void*           map;
+    size_t          map_size;
+    psa_t*          loaded;     // the programs of the mapped file
     kh_psalist_t*   cache;    
+    kh_psashaders_t* shaders;
 } gl4es_psa_t;
 
 static gl4es_psa_t *psa = NULL;
 static char *psa_name = NULL;
 
-void fpe_readPSA()
+static void psa_add(psa_t *p)
 {
-    if(!psa || !psa_name)
-        return;
-    FILE *f = fopen(psa_name, "rb");
-    if(!f)
-        return;
-    char tmp[sizeof(PSA_SIGN)];
-    if(fread(tmp, sizeof(PSA_SIGN), 1, f)!=1) {
-        fclose(f);
-        return; //to short
+    int ret;
+    khint_t k = kh_put(psalist, psa->cache, p->key, &ret);
+    if(!ret) {
+        psa_t *p2 = kh_value(psa->cache, k);
+        // the key points to the one of the old program
+        kh_key(psa->cache, k) = p->key;
+        if(p2->owned) {
+            free((void*)p2->prog);
+            free(p2);
+        }
+        ++psa->dead;
     }
-    if(strcmp(tmp, PSA_SIGN)!=0) {
-        fclose(f);
-        return; // bad signature
+    kh_value(psa->cache, k) = p;
+    psa->size = kh_size(psa->cache);
+    if(p->key->glsl[0]) {
+        kh_put(psashaders, psa->shaders, p->key->glsl[1], &ret);
+        kh_put(psashaders, psa->shaders, p->key->glsl[2], &ret);
+    }
+}
+
+static psa_t* psa_new(const psa_key_t *key)
+{
+    psa_t *p = (psa_t*)calloc(1, sizeof(psa_t)+sizeof(psa_key_t));
+    psa_key_t *s = (psa_key_t*)(p+1);
+    memcpy(s, key, sizeof(psa_key_t));
+    p->key = s;
+    p->owned = 1;
+    return p;
+}
+
+static void psa_fpekey(psa_key_t *key, const fpe_state_t *state)
+{
+    memset(key, 0, sizeof(psa_key_t));
+    if(state)
+        memcpy(&key->state, state, sizeof(fpe_state_t));
+}
+
+#if defined(_WIN32) || defined(AMIGAOS4)
+static void* psa_map(FILE *f, size_t size)
+{
+    // no mmap here, read the whole file at once
+    void *p = malloc(size);
+    if(p && fread(p, size, 1, f)!=1) {
+        free(p);
+        p = NULL;
     }
+    return p;
+}
+static void psa_unmap(void *p, size_t size)
+{
+    free(p);
+}
+#else
+#include <sys/mman.h>
+static void* psa_map(FILE *f, size_t size)
+{
+    void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+    return (p==MAP_FAILED)?NULL:p;
+}
+static void psa_unmap(void *p, size_t size)
+{
+    munmap(p, size);
+}
+#endif
+
+// legacy archive: everything is read now, and the file will be converted when saved
+static void fpe_readPSA1(FILE *f)
+{
     int version = 0;
-    if(fread(&version, sizeof(version), 1, f)!=1) {
-        fclose(f);
+    if(fread(&version, sizeof(version), 1, f)!=1)
         return;
-    }
-    if(version!=CACHE_VERSION) {
-        fclose(f);
+    if(version!=CACHE_VERSION)
         return; // unsupported version
-    }
     int sz_fpe = 0;
-    if(fread(&sz_fpe, sizeof(sz_fpe), 1, f)!=1) {
-        fclose(f);
+    if(fread(&sz_fpe, sizeof(sz_fpe), 1, f)!=1)
         return;
-    }
-    if(sz_fpe!=sizeof(fpe_state_t)) {
-        fclose(f);
+    if(sz_fpe!=sizeof(fpe_state_t))
         return; // maybe try to adapt instead?
-    }
     int n = 0;
-    if(fread(&n, sizeof(n), 1, f)!=1) {
-        fclose(f);
+    if(fread(&n, sizeof(n), 1, f)!=1)
         return;
-    }
+    psa->file = PSA_FILE_REWRITE;
     for (int i=0; i<n; ++i) {
-        psa_t *p = (psa_t*)calloc(1, sizeof(psa_t));
-        if(fread(&p->state, sizeof(p->state), 1, f)!=1) {
-            free(p);
-            fclose(f);
+        fpe_state_t state;
+        psa_key_t key;
+        GLenum format;
+        int size;
+        if(fread(&state, sizeof(state), 1, f)!=1)
             return;
-        }
-        if(fread(&p->format, sizeof(p->format), 1, f)!=1) {
-            free(p);
-            fclose(f);
+        if(fread(&format, sizeof(format), 1, f)!=1)
             return;
-        }
-        if(fread(&p->size, sizeof(p->size), 1, f)!=1) {
-            free(p);
-            fclose(f);
+        if(fread(&size, sizeof(size), 1, f)!=1 || size<=0)
             return;
-        }
-        p->prog = malloc(p->size);
-        if(fread(p->prog, p->size, 1, f)!=1) {
-            free(p->prog);
-            free(p);
-            fclose(f);
+        void *prog = malloc(size);
+        if(fread(prog, size, 1, f)!=1) {
+            free(prog);
             return;
         }
-        int ret;
-        khint_t k = kh_put(psalist, psa->cache, &p->state, &ret);
-        kh_value(psa->cache, k) = p;
-        psa->size = kh_size(psa->cache);
+        psa_fpekey(&key, &state);
+        psa_t *p = psa_new(&key);
+        p->format = format;
+        p->size = size;
+        p->prog = prog;
+        psa_add(p);
     }
-    fclose(f);
-    SHUT_LOGD("Loaded a PSA with %d Precompiled Programs\n", psa->size);
 }
 
-void fpe_writePSA()
+void fpe_readPSA()
 {
     if(!psa || !psa_name)
         return;
-    if(!psa->dirty)
-        return; // no need
-    FILE *f = fopen(psa_name, "wb");
+    FILE *f = fopen(psa_name, "rb");
     if(!f)
         return;
-    if(fwrite(PSA_SIGN, sizeof(PSA_SIGN), 1, f)!=1) {
+    psa_header_t header;
+    if(fread(&header, sizeof(header), 1, f)!=1) {
         fclose(f);
         return; //to short
     }
-    int version = CACHE_VERSION;
-    if(fwrite(&version, sizeof(version), 1, f)!=1) {
+    if(memcmp(header.sign, PSA2_SIGN, sizeof(PSA2_SIGN))!=0) {
+        if(memcmp(header.sign, PSA_SIGN, sizeof(PSA_SIGN))==0) {
+            fseek(f, sizeof(PSA_SIGN), SEEK_SET);
+            fpe_readPSA1(f);
+            SHUT_LOGD("Loaded a legacy PSA with %d Precompiled Programs\n", psa->size);
+        }
         fclose(f);
-        return;
+        return; // bad signature
     }
-    int sz_fpe = sizeof(fpe_state_t);
-    if(fwrite(&sz_fpe, sizeof(sz_fpe), 1, f)!=1) {
+    if(header.version!=CACHE_VERSION || header.sz_entry!=sizeof(psa_entry_t)) {
         fclose(f);
+        return; // unsupported version, will be replaced
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *map = (size>0)?(char*)psa_map(f, size):NULL;
+    fclose(f);
+    if(!map) {
+        // don't overwrite an archive that is probably fine
+        psa->file = PSA_FILE_NONE;
         return;
     }
-    if(fwrite(&psa->size, sizeof(psa->size), 1, f)!=1) {
-        fclose(f);
+    psa->map = map;
+    psa->map_size = size;
+    // first pass on the chunks to validate them and count the programs
+    size_t pos = sizeof(psa_header_t);
+    int n = 0;
+    while(pos+sizeof(psa_chunk_t)<=psa->map_size) {
+        const psa_chunk_t *chunk = (const psa_chunk_t*)(map+pos);
+        // check the count against the size by division, the product could overflow on 32-bit targets
+        if(chunk->count<0 || chunk->size<(int)sizeof(psa_chunk_t) || (chunk->size&3)
+         || (size_t)chunk->size>psa->map_size-pos
+         || (size_t)chunk->count>(chunk->size-sizeof(psa_chunk_t))/sizeof(psa_entry_t))
+            break;
+        const psa_entry_t *entry = (const psa_entry_t*)(chunk+1);
+        int i;
+        for (i=0; i<chunk->count; ++i)
+            if(entry[i].size<=0 || entry[i].offset<0 || entry[i].offset>chunk->size-entry[i].size)
+                break;
+        if(i!=chunk->count)
+            break;
+        n += chunk->count;
+        ++psa->chunks;
+        pos += chunk->size;
+    }
+    // a damaged end (like an interrupted append) means the file has to be rewritten
+    psa->file = (pos==psa->map_size)?PSA_FILE_APPEND:PSA_FILE_REWRITE;
+    const size_t valid = pos;
+    psa->loaded = (psa_t*)calloc(n?n:1, sizeof(psa_t));
+    psa_t *p = psa->loaded;
+    pos = sizeof(psa_header_t);
+    while(pos<valid) {
+        const psa_chunk_t *chunk = (const psa_chunk_t*)(map+pos);
+        const psa_entry_t *entry = (const psa_entry_t*)(chunk+1);
+        for (int i=0; i<chunk->count; ++i, ++p) {
+            p->key = &entry[i].key;
+            p->format = entry[i].format;
+            p->size = entry[i].size;
+            p->prog = (const char*)chunk + entry[i].offset;
+            psa_add(p);
+        }
+        pos += chunk->size;
+    }
+    SHUT_LOGD("Loaded a PSA with %d Precompiled Programs\n", psa->size);
+}
+
+// write a chunk with the n programs of list
+static int psa_writechunk(FILE *f, psa_t **list, int n)
+{
+    psa_chunk_t chunk;
+    chunk.count = n;
+    chunk.size = sizeof(psa_chunk_t) + n*sizeof(psa_entry_t);
+    for (int i=0; i<n; ++i)
+        chunk.size += PSA_ALIGN(list[i]->size);
+    char *buff = (char*)calloc(1, chunk.size);
+    if(!buff)
+        return 0;
+    memcpy(buff, &chunk, sizeof(chunk));
+    psa_entry_t *entry = (psa_entry_t*)(buff+sizeof(psa_chunk_t));
+    int offset = sizeof(psa_chunk_t) + n*sizeof(psa_entry_t);
+    for (int i=0; i<n; ++i) {
+        memcpy(&entry[i].key, list[i]->key, sizeof(psa_key_t));
+        entry[i].format = list[i]->format;
+        entry[i].size = list[i]->size;
+        entry[i].offset = offset;
+        memcpy(buff+offset, list[i]->prog, list[i]->size);
+        offset += PSA_ALIGN(list[i]->size);
+    }
+    // in one write, so an interrupted append can be detected
+    int ret = (fwrite(buff, chunk.size, 1, f)==1);
+    free(buff);
+    return ret;
+}
+
+static int psa_writeheader(FILE *f)
+{
+    psa_header_t header;
+    memset(&header, 0, sizeof(header));
+    strcpy(header.sign, PSA2_SIGN);
+    header.version = CACHE_VERSION;
+    header.sz_entry = sizeof(psa_entry_t);
+    return (fwrite(&header, sizeof(header), 1, f)==1);
+}
+
+void fpe_writePSA()
+{
+    if(!psa || !psa_name || psa->file==PSA_FILE_NONE)
+        return;
+    // programs are saved when they are added, only a rewrite can be needed here
+    if(psa->file!=PSA_FILE_REWRITE && psa->chunks<=PSA_MAXCHUNKS && !psa->dead)
+        return; // no need
+    if(!psa->size)
+        return;
+    // write a compacted archive in a new file, and replace the old one (that may still be mapped)
+    char *tmpname = (char*)malloc(strlen(psa_name)+5);
+    strcpy(tmpname, psa_name);
+    strcat(tmpname, ".tmp");
+    FILE *f = fopen(tmpname, "wb");
+    if(!f) {
+        free(tmpname);
         return;
     }
+    psa_t **list = (psa_t**)malloc(psa->size*sizeof(psa_t*));
+    int n = 0;
     psa_t *p;
     kh_foreach_value(psa->cache, p, 
-        if(fwrite(&p->state, sizeof(p->state), 1, f)!=1) {
-            fclose(f);
-            return;
-        }
-        if(fwrite(&p->format, sizeof(p->format), 1, f)!=1) {
-            fclose(f);
-            return;
-        }
-        if(fwrite(&p->size, sizeof(p->size), 1, f)!=1) {
-            fclose(f);
-            return;
-        }
-        if(fwrite(p->prog, p->size, 1, f)!=1) {
-            fclose(f);
-            return;
-        }
+        list[n++] = p;
     );
-    fclose(f);
+    int ok = psa_writeheader(f) && psa_writechunk(f, list, n);
+    free(list);
+    if(fclose(f))
+        ok = 0;
+#if defined(_WIN32) || defined(AMIGAOS4)
+    // rename doesn't replace an existing file there
+    if(ok)
+        remove(psa_name);
+#endif
+    if(ok)
+        ok = (rename(tmpname, psa_name)==0);
+    if(!ok)
+        remove(tmpname);
+    free(tmpname);
+    if(!ok)
+        return;
+    psa->file = PSA_FILE_APPEND;
+    psa->chunks = 1;
+    psa->dead = 0;
     SHUT_LOGD("Saved a PSA with %d Precompiled Programs\n", psa->size);
 }
 
@@ -235,6 +458,7 @@ void fpe_InitPSA(const char* name)
         return; // already inited
     psa = (gl4es_psa_t*)calloc(1, sizeof(gl4es_psa_t));
     psa->cache = kh_init(psalist);
+    psa->shaders = kh_init(psashaders);
     psa_name = strdup(name);
 }
 
@@ -245,10 +469,16 @@ void fpe_FreePSA()
     
     psa_t *m;
     kh_foreach_value(psa->cache, m, 
-        free(m->prog);
-        free(m);
+        if(m->owned) {
+            free((void*)m->prog);
+            free(m);
+        }
     )
     kh_destroy(psalist, psa->cache);
+    kh_destroy(psashaders, psa->shaders);
+    free(psa->loaded);
+    if(psa->map)
+        psa_unmap(psa->map, psa->map_size);
 
     free(psa);
     psa = NULL;
@@ -256,6 +486,52 @@ void fpe_FreePSA()
     psa_name = NULL;
 }
 
+static int psa_getprogram(GLuint program, const psa_key_t *key)
+{
+    khint_t k = kh_get(psalist, psa->cache, key);
+    if(k==kh_end(psa->cache))
+        return 0; // not here
+    psa_t *p = kh_value(psa->cache, k);
+    // try to load...
+    return gl4es_useProgramBinary(program, p->size, p->format, p->prog);
+}
+
+static void psa_addprogram(GLuint program, const psa_key_t *key)
+{
+    psa_t *p = psa_new(key);
+    void *prog = NULL;
+    int l = gl4es_getProgramBinary(program, &p->size, &p->format, &prog);
+    if(l==0) { // there was an error...
+        free(prog);
+        free(p);
+        return;
+    }
+    p->prog = prog;
+    // add program
+    psa_add(p);
+    // and save it now, at the end of the archive
+    if(psa->file==PSA_FILE_REWRITE || psa->file==PSA_FILE_NONE || !psa_name)
+        return;
+    FILE *f = fopen(psa_name, (psa->file==PSA_FILE_NEW)?"wb":"ab");
+    if(!f)
+        return;
+    int ok = 1;
+    if(psa->file==PSA_FILE_NEW) {
+        ok = psa_writeheader(f);
+        psa->chunks = 0;
+        psa->dead = 0;
+    }
+    if(ok)
+        ok = psa_writechunk(f, &p, 1);
+    if(fclose(f))
+        ok = 0;
+    if(ok) {
+        psa->file = PSA_FILE_APPEND;
+        ++psa->chunks;
+    } else
+        psa->file = PSA_FILE_REWRITE;
+}
+
 int fpe_GetProgramPSA(GLuint program, fpe_state_t* state)
 {
     if(!psa)
@@ -263,12 +539,9 @@ int fpe_GetProgramPSA(GLuint program, fpe_state_t* state)
     // if state contains custom vertex of fragment shader, then ignore
     if(state->vertex_prg_enable || state->fragment_prg_enable)
         return 0;
-    khint_t k = kh_get(psalist, psa->cache, state);
-    if(k==kh_end(psa->cache))
-        return 0; // not here
-    psa_t *p = kh_value(psa->cache, k);
-    // try to load...
-    return gl4es_useProgramBinary(program, p->size, p->format, p->prog);
+    psa_key_t key;
+    psa_fpekey(&key, state);
+    return psa_getprogram(program, &key);
 }
 
 void fpe_AddProgramPSA(GLuint program, fpe_state_t* state)
@@ -278,26 +551,64 @@ void fpe_AddProgramPSA(GLuint program, fpe_state_t* state)
     // if state contains custom vertex of fragment shader, then ignore
     if(state->vertex_prg_enable || state->fragment_prg_enable)
         return;
-    psa->dirty = 1;
-    psa_t *p = (psa_t*)calloc(1, sizeof(psa_t));
-    memcpy(&p->state, state, sizeof(p->state));
+    psa_key_t key;
+    psa_fpekey(&key, state);
+    psa_addprogram(program, &key);
+}
 
-    int l = gl4es_getProgramBinary(program, &p->size, &p->format, &p->prog);
-    if(l==0) { // there was an error...
-        free(p->prog);
-        free(p);
-        return;
-    }
-    // add program
-    int ret;
-    khint_t k = kh_put(psalist, psa->cache, &p->state, &ret);
-    if(!ret) {
-        psa_t *p2 = kh_value(psa->cache, k);
-        free(p2->prog);
-        p2->prog = NULL;
-        free(p2);
+int fpe_NextPSA(int *iter, fpe_state_t* state)
+{
+    if(!psa)
+        return 0;
+    // walk the archive by hash bucket, only the plain FPE programs can be built ahead of time
+    for (khint_t k=*iter; k<kh_end(psa->cache); ++k) {
+        if(!kh_exist(psa->cache, k))
+            continue;
+        const psa_key_t *key = kh_key(psa->cache, k);
+        if(key->glsl[0] || key->state.vertex_prg_enable || key->state.fragment_prg_enable)
+            continue;
+        memcpy(state, &key->state, sizeof(fpe_state_t));
+        *iter = k+1;
+        return 1;
     }
-    kh_value(psa->cache, k) = p;
-    // all done
-    psa->size = kh_size(psa->cache);
-}
\ No newline at end of file
+    *iter = kh_end(psa->cache);
+    return 0;
+}
+
+uint32_t fpe_HashPSA(const void* data, int size, uint32_t hash)
+{
+    // FNV-1a
+    const unsigned char* p = (const unsigned char*)data;
+    if(!hash)
+        hash = 2166136261u;
+    for (int i=0; i<size; ++i)
+        hash = (hash ^ p[i]) * 16777619u;
+    return hash?hash:1;
+}
+
+int fpe_HasShaderPSA(uint32_t hash)
+{
+    if(!psa || !hash)
+        return 0;
+    return kh_get(psashaders, psa->shaders, hash)!=kh_end(psa->shaders);
+}
+
+int fpe_GetGLSLProgramPSA(GLuint program, const uint32_t* glsl, fpe_state_t* state)
+{
+    if(!psa || !glsl[0])
+        return 0;
+    psa_key_t key;
+    psa_fpekey(&key, state);
+    memcpy(key.glsl, glsl, sizeof(key.glsl));
+    return psa_getprogram(program, &key);
+}
+
+void fpe_AddGLSLProgramPSA(GLuint program, const uint32_t* glsl, fpe_state_t* state)
+{
+    if(!psa || !glsl[0])
+        return;
+    psa_key_t key;
+    psa_fpekey(&key, state);
+    memcpy(key.glsl, glsl, sizeof(key.glsl));
+    psa_addprogram(program, &key);
+}
@@ -44,6 +44,14 @@ void fpe_readPSA();
 void fpe_writePSA();
 int fpe_GetProgramPSA(GLuint program, fpe_state_t* state);
 void fpe_AddProgramPSA(GLuint program, fpe_state_t* state);
+// iterate the FPE programs of the archive, *iter starts at 0. Returns 0 at the end
+int fpe_NextPSA(int *iter, fpe_state_t* state);
+// GLSL programs: glsl is the hash of the program, of its vertex shader and of its fragment shader
+// state is the fpe customization of the program (NULL for the program itself)
+uint32_t fpe_HashPSA(const void* data, int size, uint32_t hash);
+int fpe_HasShaderPSA(uint32_t hash);
+int fpe_GetGLSLProgramPSA(GLuint program, const uint32_t* glsl, fpe_state_t* state);
+void fpe_AddGLSLProgramPSA(GLuint program, const uint32_t* glsl, fpe_state_t* state);
 
 #ifdef DO_NOT_FORGET_TO_UNDEF_fpe_state_t 
 #undef fpe_state_t
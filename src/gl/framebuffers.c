@@ -8,6 +8,7 @@
 #include "glstate.h"
 #include "init.h"
 #include "loader.h"
+#include "texasync.h"
 
 //#define DEBUG
 #ifdef DEBUG
@@ -458,6 +459,7 @@ void APIENTRY_GL4ES gl4es_glFramebufferTexture2D(GLenum target, GLenum attachmen
             LOGE("texture for FBO not found, name=%u\n", texture);
         } else {
             texture = tex->glname;
+            texasync_sync(tex);
             tex->fbtex_ratio = (globals4es.fbtexscale > 0.0f) ? globals4es.fbtexscale : 0.0f;
 
             // check if texture was shrunk or if fb texture is being scaled...
@@ -1091,6 +1093,7 @@ void APIENTRY_GL4ES gl4es_glGenerateMipmap(GLenum target) {
     const GLuint rtarget = map_tex_target(target);
     realize_bound(glstate->texture.active, target);
     gltexture_t *bound = gl4es_getCurrentTexture(target);
+    texasync_sync(bound);
     if(globals4es.forcenpot && hardext.npot==1) {
         if(bound->npot) {
             noerrorShim();
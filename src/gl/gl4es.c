@@ -16,6 +16,7 @@
 #include "init.h"
 #include "loader.h"
 #include "matrix.h"
+#include "stats.h"
 #include "buffers.h"
 #ifdef _WIN32
 #ifdef _WINBASE_
@@ -272,6 +273,7 @@ void APIENTRY_GL4ES gl4es_glEnd(void) {
             renderlist_t *mylist = glstate->list.active;
             withColor = (mylist->color!=NULL);
             glstate->list.active = NULL;
+            batch2d_flush();    // the deferred blocks were issued first
             mylist = end_renderlist(mylist);
             draw_renderlist(mylist);
             free_renderlist(mylist);
@@ -848,6 +850,8 @@ void APIENTRY_GL4ES gl4es_glEndList(void) {
 	// Free the previous list if it exist...
         free_renderlist(kh_value(lists, k));
         renderlist_t* l = kh_value(lists, k) = GetFirst(glstate->list.active);
+        if(globals4es.listopt)
+            glstate->list.active = optimize_renderlist(l);
         // set name
         while(l) {
             l->name = list;
@@ -881,50 +885,64 @@ void APIENTRY_GL4ES gl4es_glCallList(GLuint list) {
 }
 AliasExport(void,glCallList,,(GLuint list));
 
-void APIENTRY_GL4ES glPushCall(void *call) {
-    if (glstate->list.active) {
-		NewStage(glstate->list.active, STAGE_GLCALL);
-        rlPushCall(glstate->list.active, call);
-    }
+void* APIENTRY_GL4ES glAllocCall(int size) {
+    // only called while compiling a list (see PUSH_IF_COMPILING)
+    NewStage(glstate->list.active, STAGE_GLCALL);
+    return rlAllocCall(glstate->list.active, size);
 }
 
-void APIENTRY_GL4ES gl4es_glCallLists(GLsizei n, GLenum type, const GLvoid *lists) {
-    #define call(name, type) \
-        case name: gl4es_glCallList(((type *)lists)[i] + glstate->list.base); break
-
+static GLuint calllists_name(GLenum type, const GLvoid *lists, GLsizei i) {
     // seriously wtf
-    #define call_bytes(name, stride)                             \
-        case name:                                               \
-            l = (GLubyte *)lists;                                \
-            list = 0;                                            \
-            for (j = 0; j < stride; j++) {                       \
-                list += *(l + (i * stride + j)) << (stride - j); \
-            }                                                    \
-            gl4es_glCallList(list + glstate->list.base);                  \
-            break
+    #define call_bytes(stride)                                      \
+        {                                                           \
+            const GLubyte *l = (const GLubyte *)lists;              \
+            GLuint list = 0;                                        \
+            for (int j = 0; j < stride; j++)                        \
+                list += *(l + (i * stride + j)) << (stride - j);    \
+            return list + glstate->list.base;                       \
+        }
+    switch (type) {
+        case GL_BYTE: return ((const GLbyte *)lists)[i] + glstate->list.base;
+        case GL_UNSIGNED_BYTE: return ((const GLubyte *)lists)[i] + glstate->list.base;
+        case GL_SHORT: return ((const GLshort *)lists)[i] + glstate->list.base;
+        case GL_UNSIGNED_SHORT: return ((const GLushort *)lists)[i] + glstate->list.base;
+        case GL_INT: return ((const GLint *)lists)[i] + glstate->list.base;
+        case GL_UNSIGNED_INT: return ((const GLuint *)lists)[i] + glstate->list.base;
+        case GL_FLOAT: return ((const GLfloat *)lists)[i] + glstate->list.base;
+        case GL_2_BYTES: call_bytes(2);
+        case GL_3_BYTES: call_bytes(3);
+        case GL_4_BYTES: call_bytes(4);
+    }
+    #undef call_bytes
+    return 0;
+}
 
+#define CALLLISTS_BATCH 256
+void APIENTRY_GL4ES gl4es_glCallLists(GLsizei n, GLenum type, const GLvoid *lists) {
     if (glstate->raster.bm_drawing) bitmap_flush();
     FLUSH_BEGINEND;
-    unsigned int j;
-    GLsizei i;
-    GLuint list;
-    GLubyte *l;
-    for (i = 0; i < n; i++) {
-        switch (type) {
-            call(GL_BYTE, GLbyte);
-            call(GL_UNSIGNED_BYTE, GLubyte);
-            call(GL_SHORT, GLshort);
-            call(GL_UNSIGNED_SHORT, GLushort);
-            call(GL_INT, GLint);
-            call(GL_UNSIGNED_INT, GLuint);
-            call(GL_FLOAT, GLfloat);
-            call_bytes(GL_2_BYTES, 2);
-            call_bytes(GL_3_BYTES, 3);
-            call_bytes(GL_4_BYTES, 4);
+    // text is drawn with one list per glyph: runs of simple lists are merged and drawn at once
+    renderlist_t *rl[CALLLISTS_BATCH];
+    GLuint names[CALLLISTS_BATCH];
+    GLsizei i = 0;
+    while (i < n) {
+        int k = 0;
+        while (k < CALLLISTS_BATCH && i+k < n) {
+            names[k] = calllists_name(type, lists, i+k);
+            rl[k] = gl4es_glGetList(names[k]);
+            ++k;
+        }
+        int j = 0;
+        while (j < k) {
+            int done = batch_calllists(rl+j, k-j);
+            if (done)
+                j += done;
+            else
+                gl4es_glCallList(names[j++]);
         }
+        i += k;
     }
-    #undef call
-    #undef call_bytes
+    noerrorShim();
 }
 AliasExport(void,glCallLists,,(GLsizei n, GLenum type, const GLvoid *lists));
 
@@ -1008,6 +1026,7 @@ void gl4es_flush() {
     if (mylist) {
         glstate->list.active = NULL;
         glstate->list.pending = 0;
+        batch2d_flush();    // the deferred blocks were issued first
         mylist = end_renderlist(mylist);
         draw_renderlist(mylist);
         free_renderlist(mylist);
@@ -1210,6 +1229,81 @@ void gl4es_use_scratch_indices(int use) {
     bindBuffer(GL_ELEMENT_ARRAY_BUFFER, use?glstate->scratch_indices:0);
 }
 
+// reserve size bytes in a ring VBO, orphaning the storage only when it wraps
+static GLintptr stream_reserve(GLenum target, GLuint *buffer, GLintptr *pos, GLsizeiptr cap, GLsizeiptr size) {
+    LOAD_GLES(glBufferData);
+    LOAD_GLES(glGenBuffers);
+    if(size>cap)
+        return -1;
+    int orphan = 0;
+    if(!*buffer) {
+        gles_glGenBuffers(1, buffer);
+        orphan = 1;
+    }
+    bindBuffer(target, *buffer);
+    if(orphan || *pos+size>cap) {
+        gles_glBufferData(target, cap, NULL, GL_STREAM_DRAW);
+        *pos = 0;
+    }
+    GLintptr ret = *pos;
+    *pos = (*pos+size+15)&~15;
+    return ret;
+}
+
+GLintptr gl4es_stream_vertex(GLsizeiptr size) {
+    return stream_reserve(GL_ARRAY_BUFFER, &glstate->stream_vertex, &glstate->stream_vertex_pos, globals4es.streamvbo*1024*1024, size);
+}
+
+GLintptr gl4es_stream_indices(GLsizeiptr size) {
+    return stream_reserve(GL_ELEMENT_ARRAY_BUFFER, &glstate->stream_indices, &glstate->stream_indices_pos, globals4es.streamvbo*256*1024, size);
+}
+
+#define MAX_QUAD_INDICES 65536
+// GL_QUADS drawn as GL_TRIANGLES: 0,1,2, 0,2,3, 4,5,6, 4,6,7...
+// Grow only, shared by all the non-indexed quads, and mirrored in an index VBO when possible
+// (fpe_glDrawElements use the VBO when it gets a pointer inside glstate->quad_indices)
+// return NULL if count vertices cannot be indexed with GLushort
+GLushort* gl4es_quad_indices(int count) {
+    if(count<=glstate->quad_indices_len)
+        return glstate->quad_indices;
+    if(count>MAX_QUAD_INDICES)
+        return NULL;
+    int len = glstate->quad_indices_len?glstate->quad_indices_len:256;
+    while(len<count) len<<=1;
+    GLushort *p = glstate->quad_indices = (GLushort*)realloc(glstate->quad_indices, len*3/2*sizeof(GLushort));
+    for (int i=0; i<len; i+=4) {
+        *(p++) = i + 0;
+        *(p++) = i + 1;
+        *(p++) = i + 2;
+
+        *(p++) = i + 0;
+        *(p++) = i + 2;
+        *(p++) = i + 3;
+    }
+    glstate->quad_indices_len = len;
+    if(hardext.esversion>1 && globals4es.usevbo) {
+        LOAD_GLES(glBufferData);
+        LOAD_GLES(glGenBuffers);
+        if(!glstate->quad_indices_buffer)
+            gles_glGenBuffers(1, &glstate->quad_indices_buffer);
+        GLuint old_index = glstate->bind_buffer.want_index;
+        bindBuffer(GL_ELEMENT_ARRAY_BUFFER, glstate->quad_indices_buffer);
+        gles_glBufferData(GL_ELEMENT_ARRAY_BUFFER, len*3/2*sizeof(GLushort), glstate->quad_indices, GL_STATIC_DRAW);
+        wantBufferIndex(old_index);
+    }
+    return glstate->quad_indices;
+}
+
+// return the shared quad indices if indices are the canonical ones (so they can come from the VBO)
+const GLushort* gl4es_match_quad_indices(const GLushort* indices, int ilen) {
+    if(ilen<6 || indices[1]!=1 || indices[2]!=2 || indices[4]!=2 || indices[5]!=3 || indices[0] || indices[3] || ilen%6)
+        return indices;
+    const GLushort* quads = gl4es_quad_indices(ilen*2/3);
+    if(quads && !memcmp(quads, indices, ilen*sizeof(GLushort)))
+        return quads;
+    return indices;
+}
+
 #if defined(AMIGAOS4) || (defined(NOX11) && defined(NOEGL))
 #ifdef AMIGAOS4
 void amiga_pre_swap()
@@ -1274,6 +1368,7 @@ NonAliasExportDecl(void,gl4es_post_swap,())
 #endif
 {
 		show_fps();
+    gl4es_statsEndFrame();
 
     // If drawing in fbo, rebind it...
     if (globals4es.usefbo) {
@@ -123,6 +123,10 @@ static inline void noerrorShimNoPurge() {
 void gl4es_scratch(int alloc);
 void gl4es_scratch_vertex(int alloc);
 void gl4es_scratch_indices(int alloc);
+GLintptr gl4es_stream_vertex(GLsizeiptr size);
+GLintptr gl4es_stream_indices(GLsizeiptr size);
+GLushort* gl4es_quad_indices(int count);
+const GLushort* gl4es_match_quad_indices(const GLushort* indices, int ilen);
 void gl4es_use_scratch_vertex(int use);
 void gl4es_use_scratch_indices(int use);
 
@@ -159,6 +163,6 @@ void APIENTRY_GL4ES glVertex3f(GLfloat x, GLfloat y, GLfloat z);
 GLenum APIENTRY_GL4ES glGetError(void);
 
 // custom functions
-void APIENTRY_GL4ES glPushCall(void *call);
+void* APIENTRY_GL4ES glAllocCall(int size);
 
 #endif // _GL4ES_GL4ES_H_
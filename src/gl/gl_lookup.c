@@ -15,6 +15,10 @@
 
 #include "../glx/hardext.h"
 
+#if !defined(_WIN32) && !defined(AMIGAOS4)
+#include <pthread.h>
+#endif
+
 //#define DEBUG
 #ifdef DEBUG
 #define DBG(a) a
@@ -34,8 +38,76 @@ void gl4es_Stub(void *x, ...) {
 void APIENTRY_GL4ES gl4es_Stub(void *x) {}
 #endif
 
-void* APIENTRY_GL4ES gl4es_GetProcAddress(const char *name) {
-    DBG(printf("glGetProcAddress(\"%s\")", name);)
+// The list of functions below is not walked with strcmp on each call: it's recorded once
+// in a table sorted by name, and gl4es_GetProcAddress does a binary search in it.
+// Entries can be conditional (LOOKUP_IF), the condition is checked at lookup time, and
+// when a name is listed more than once, the first valid entry in list order wins.
+
+typedef enum {
+    LOOKUP_ALWAYS = 0,
+    LOOKUP_FBO,
+    LOOKUP_BLENDCOLOR,
+    LOOKUP_BLENDEQ,
+    LOOKUP_BLENDFUNC,
+    LOOKUP_ES2,
+    LOOKUP_QUERIES,
+} lookup_cond_t;
+
+static int lookup_check(lookup_cond_t cond) {
+    switch(cond) {
+        case LOOKUP_FBO:        return hardext.fbo;
+        case LOOKUP_BLENDCOLOR: return globals4es.blendcolor || hardext.blendcolor;
+        case LOOKUP_BLENDEQ:    return hardext.blendeq;
+        case LOOKUP_BLENDFUNC:  return hardext.blendfunc;
+        case LOOKUP_ES2:        return hardext.esversion>1;
+        case LOOKUP_QUERIES:    return globals4es.queries;
+        default:                return 1;
+    }
+}
+
+typedef struct {
+    const char  *name;
+    void        *func;
+    int         order;  // position in the list
+    short       cond;   // lookup_cond_t
+    short       stub;
+} lookup_entry_t;
+
+static lookup_entry_t *lookup_table = NULL;    // only set once sorted
+static lookup_entry_t *lookup_build = NULL;
+static int lookup_size = 0;
+static int lookup_cap = 0;
+static lookup_cond_t lookup_cur = LOOKUP_ALWAYS;
+
+static void lookup_add(const char *name, void *func, int stub) {
+    if(lookup_size==lookup_cap) {
+        lookup_cap += 512;
+        lookup_build = (lookup_entry_t*)realloc(lookup_build, lookup_cap*sizeof(lookup_entry_t));
+    }
+    lookup_entry_t *e = &lookup_build[lookup_size];
+    e->name = name;
+    e->func = func;
+    e->order = lookup_size++;
+    e->cond = lookup_cur;
+    e->stub = stub;
+}
+
+static int lookup_cmp(const void *a, const void *b) {
+    const lookup_entry_t *ea = (const lookup_entry_t*)a;
+    const lookup_entry_t *eb = (const lookup_entry_t*)b;
+    int r = strcmp(ea->name, eb->name);
+    return r?r:(ea->order - eb->order);
+}
+
+// record mode for the gl_lookup.h macros
+#undef MAP
+#define MAP(func_name, func) lookup_add(func_name, (void *)func, 0);
+#undef STUB
+#define STUB(func_name) lookup_add(#func_name, (void *)STUB_FCT, 1);
+#define LOOKUP_IF(cond) lookup_cur = LOOKUP_ ## cond;
+#define LOOKUP_ENDIF lookup_cur = LOOKUP_ALWAYS;
+
+static void lookup_fill() {
     // generated gles wrappers
     #include "glesfuncs.inc"
 
@@ -101,7 +173,7 @@ void* APIENTRY_GL4ES gl4es_GetProcAddress(const char *name) {
     _EXT(glIsVertexArray);
     
     // GL_ARB_frameBuffer_ext
-    if(hardext.fbo) {
+    LOOKUP_IF(FBO)
         _EX(glFramebufferTexture1D);
         _EX(glFramebufferTexture3D);
         _EX(glFramebufferTextureLayer);
@@ -164,7 +236,7 @@ void* APIENTRY_GL4ES gl4es_GetProcAddress(const char *name) {
 
         // draw_buffer_2 (partial)
         _EXT(glColorMaskIndexed)
-    }
+    LOOKUP_ENDIF
     
     // GL_EXT_vertex_array
     _EXT(glArrayElement);
@@ -276,30 +348,30 @@ void* APIENTRY_GL4ES gl4es_GetProcAddress(const char *name) {
     _EX(glArrayElement);
     _EX(glBegin);
     _EX(glBitmap);
-    if(globals4es.blendcolor || hardext.blendcolor) {
+    LOOKUP_IF(BLENDCOLOR)
         _EX(glBlendColor);
         _EXT(glBlendColor);
         _ARB(glBlendColor);
-    }
+    LOOKUP_ENDIF
     _EXT(glBlendEquation);
     _ARB(glBlendEquation);
     _EXT(glBlendFunc);
     _ARB(glBlendFunc);
 
-    if(hardext.blendeq) {
+    LOOKUP_IF(BLENDEQ)
         _EXT(glBlendEquationSeparate);
         _ARB(glBlendEquationSeparate);
         _EX(glBlendEquationSeparatei);
         _EXT(glBlendEquationSeparatei);
         _ARB(glBlendEquationSeparatei);
-    }
-    if(hardext.blendfunc) {
+    LOOKUP_ENDIF
+    LOOKUP_IF(BLENDFUNC)
         _EXT(glBlendFuncSeparate);
         _ARB(glBlendFuncSeparate);
         _EX(glBlendFuncSeparatei);
         _EXT(glBlendFuncSeparatei);
         _ARB(glBlendFuncSeparatei);
-    }
+    LOOKUP_ENDIF
     _EX(glStencilMaskSeparate);
     _EXT(glStencilMaskSeparate);
     _EX(glCallList);
@@ -473,14 +545,14 @@ void* APIENTRY_GL4ES gl4es_GetProcAddress(const char *name) {
     _EX(glPointParameteriv);
     
     _EX(glFogCoordPointer);
-    if(hardext.esversion>1) {
+    LOOKUP_IF(ES2)
         // EXT_fog_coord supported
         _EXT(glFogCoordd);
         _EXT(glFogCoorddv);
         _EXT(glFogCoordf);
         _EXT(glFogCoordfv);
         _EXT(glFogCoordPointer);
-    }
+    LOOKUP_ENDIF
     /*STUB(glEdgeFlagPointerEXT);
     STUB(glIndexPointerEXT);*/
     STUB(glClearIndex);
@@ -705,7 +777,7 @@ void* APIENTRY_GL4ES gl4es_GetProcAddress(const char *name) {
     _EXT(glMatrixMultTransposef);
     _EXT(glMatrixMultTransposed);
 
-    if(globals4es.queries) {
+    LOOKUP_IF(QUERIES)
         _EX(glGenQueries);
         _EX(glIsQuery);
         _EX(glDeleteQueries);
@@ -727,7 +799,7 @@ void* APIENTRY_GL4ES gl4es_GetProcAddress(const char *name) {
         _ARB(glGetQueryObjectiv);
         _ARB(glGetQueryObjectuiv);
         _ARB(glQueryCounter);
-    }
+    LOOKUP_ENDIF
 
     // GL_ARB_multisample
     _ARB(glSampleCoverage);
@@ -1007,7 +1079,7 @@ void* APIENTRY_GL4ES gl4es_GetProcAddress(const char *name) {
     _EXT(glClampColor);
 
     //GL_ARB_vertex_program
-    if(hardext.esversion>1) {
+    LOOKUP_IF(ES2)
         _EX(glProgramStringARB);
         _EX(glBindProgramARB);
         _EX(glDeleteProgramsARB);
@@ -1031,7 +1103,7 @@ void* APIENTRY_GL4ES gl4es_GetProcAddress(const char *name) {
         // GL_EXT_program_parameters
         _EX(glProgramEnvParameters4fvEXT)
         _EX(glProgramLocalParameters4fvEXT)
-    }
+    LOOKUP_ENDIF
 
     // GL 3.0
 
@@ -1054,6 +1126,44 @@ void* APIENTRY_GL4ES gl4es_GetProcAddress(const char *name) {
     // IPointer
     //_EX(glVertexAttribIPointer);
 
+
+    qsort(lookup_build, lookup_size, sizeof(lookup_entry_t), lookup_cmp);
+    lookup_table = lookup_build;
+}
+
+#if !defined(_WIN32) && !defined(AMIGAOS4)
+// GetProcAddress can be called from several threads, the table is built only once
+static pthread_once_t lookup_once = PTHREAD_ONCE_INIT;
+#define LOOKUP_INIT pthread_once(&lookup_once, lookup_fill)
+#else
+#define LOOKUP_INIT if(!lookup_table) lookup_fill()
+#endif
+
+void* APIENTRY_GL4ES gl4es_GetProcAddress(const char *name) {
+    DBG(printf("glGetProcAddress(\"%s\")", name);)
+    LOOKUP_INIT;
+    // lower bound of name
+    int lo = 0, hi = lookup_size;
+    while(lo<hi) {
+        int mid = (lo+hi)/2;
+        if(strcmp(lookup_table[mid].name, name)<0)
+            lo = mid+1;
+        else
+            hi = mid;
+    }
+    for(; lo<lookup_size && !strcmp(lookup_table[lo].name, name); ++lo) {
+        lookup_entry_t *e = &lookup_table[lo];
+        if(!lookup_check(e->cond))
+            continue;
+        if(e->stub) {
+            DBG(printf("=> STUB\n");)
+            if(!globals4es.silentstub) LOGD("GL4ES stub: %s\n", name);
+        } else {
+            DBG(printf("%p\n", e->func);)
+        }
+        return e->func;
+    }
+
     DBG(printf("NULL\n");)
     if (!globals4es.silentstub) LOGD("GL4ES GetProcAddress: %s not found.\n", name);
     return NULL;
@@ -8,6 +8,7 @@
 #include "init.h"
 #include "loader.h"
 #include "oldprogram.h"
+#include "texasync.h"
 
 glstate_t *glstate = NULL;
 
@@ -46,6 +47,7 @@ static void free_texture(gltexture_t *tex)
     LOAD_GLES(glDeleteTextures);
     if(!tex || !gles_glDeleteTextures)
         return;
+    texasync_discard(tex);
     if(tex->glname)
         gles_glDeleteTextures(1, &tex->glname);
     if(tex->data)
@@ -207,6 +209,7 @@ void* NewGLState(void* shared_glstate, int es2only) {
     // fpe
     if(hardext.esversion>1) {
         glstate->fpe_state = (fpe_state_t*)calloc(1, sizeof(fpe_state_t));
+        glstate->fpe_dirty = 1;
         glstate->glsl->es2 = es2only;
         fpe_Init(glstate);
     }
@@ -349,6 +352,7 @@ void* NewGLState(void* shared_glstate, int es2only) {
     // fpe
     if(hardext.esversion>1) {
         glstate->fpe_state = (fpe_state_t*)calloc(1, sizeof(fpe_state_t));
+        glstate->fpe_dirty = 1;
         glstate->glsl->es2 = es2only;
         if(!shared_glstate)
             fpe_Init(glstate);
@@ -512,6 +516,11 @@ void DeleteGLState(void* oldstate) {
     #undef freemap
     // free active list
     if(!state->shared_cnt && state->list.active) free_renderlist(state->list.active);
+    while(state->list.pool) {
+        renderlist_t *next = state->list.pool->next;
+        free(state->list.pool);
+        state->list.pool = next;
+    }
 
     // free matrix stack
     #define free_matrix(A)                  \
@@ -544,6 +553,9 @@ void DeleteGLState(void* oldstate) {
     // scratch buffer
     if(state->scratch)
         free(state->scratch);
+    // quad indices (the VBO goes with the GLES context)
+    if(state->quad_indices)
+        free(state->quad_indices);
     // merger buffers
     if(state->merger_master)
         free(state->merger_master);
@@ -552,6 +564,7 @@ void DeleteGLState(void* oldstate) {
     for(int a=0; a<MAX_TEX-2; ++a)
         if(state->merger_tex[a])
             free(state->merger_tex[a]);
+    batch2d_free(&state->batch2d);
     // mainfbo
     if(!state->shared_cnt) {
         if(state->fbo.mainfbo_fbo)
@@ -2,6 +2,7 @@
 #define _GL4ES_GLSTATE_H_
 
 #include "oldprogram.h"
+#include "batch2d.h"
 #include "fog.h"
 #include "fpe.h"
 #include "light.h"
@@ -29,6 +30,8 @@ struct glstate_s {
     int                 mvp_matrix_dirty;
     GLfloat             inv_mv_matrix[16];
     int                 inv_mv_matrix_dirty;
+    GLfloat             inv_mvp_matrix[16];
+    uint64_t            inv_mvp_gen[2];     // generations of the projection and modelview matrices
     GLfloat             normal_matrix[9];
     int                 normal_matrix_dirty;
     matrixstack_t       *modelview_matrix;
@@ -78,8 +81,10 @@ struct glstate_s {
     glsl_t              *glsl;              //shared
     fpe_state_t         *fpe_state;
     fpe_fpe_t           *fpe;
+    int                 fpe_dirty;          // fpe_state changed since the last fpe_program
     fpestatus_t         fpe_client;
     fpe_cache_t         *fpe_cache;
+    int                 fpe_prelink;        // position of the PSA walk of fpe_Prelink
     gleshard_t          *gleshard;          //shared
     glesblit_t          *blit;
     fbo_t               fbo;
@@ -101,11 +106,22 @@ struct glstate_s {
     int                 merger_indice_cap;
     GLushort*           merger_indices;
     int                 merger_used;
+    // deferred 2D batcher (LIBGL_BATCH2D)
+    batch2d_t           batch2d;
     // scratch VBO
     GLuint              scratch_vertex;
     GLsizei             scratch_vertex_size;
     GLuint              scratch_indices;
     GLsizei             scratch_indices_size;
+    // streaming ring VBO (LIBGL_STREAMVBO)
+    GLuint              stream_vertex;
+    GLintptr            stream_vertex_pos;
+    GLuint              stream_indices;
+    GLintptr            stream_indices_pos;
+    // canonical GL_QUADS indices
+    GLushort*           quad_indices;
+    int                 quad_indices_len;   // in vertices
+    GLuint              quad_indices_buffer;
     // Implementation read
     GLenum              readf; // implementation Read Format
     GLenum              readt; // implementation Read Type
@@ -16,6 +16,10 @@
 #include "logs.h"
 #include "fpe_cache.h"
 #include "init.h"
+#include "nullgles.h"
+#include "stats.h"
+#include "texasync.h"
+#include "texthreads.h"
 #include "envvars.h"
 #if defined(__EMSCRIPTEN__) || defined(__APPLE__)
 #define NO_INIT_CONSTRUCTOR
@@ -159,6 +163,15 @@ void initialize_gl4es() {
     }
     env(LIBGL_BLITFB0, globals4es.blitfb0, "Blit to FB 0 force a SwapBuffer");
     env(LIBGL_FPS, globals4es.showfps, "fps counter enabled");
+    globals4es.stats = ReturnEnvVarInt("LIBGL_STATS");
+    if(globals4es.stats>0) {
+        if(globals4es.stats==1) {
+            SHUT_LOGD("Printing hot-path counters every frame\n");
+        } else {
+            SHUT_LOGD("Printing hot-path counters every %d frames\n", globals4es.stats);
+        }
+    } else
+        globals4es.stats = 0;
 #if defined(USE_FBIO) || defined(PYRA)
     env(LIBGL_VSYNC, globals4es.vsync, "vsync enabled");
 #endif
@@ -226,8 +239,14 @@ void initialize_gl4es() {
 #endif
     }
 
+    globals4es.nullgles = ReturnEnvVarInt("LIBGL_NULLGLES");
+    if(globals4es.nullgles) {
+        SHUT_LOGD("Using the null GLES backend (no rendering)%s\n", (globals4es.nullgles>1)?", logging all calls":"");
+        nullgles_init(globals4es.nullgles);
+    }
 #if !defined(__EMSCRIPTEN__) && !defined(__APPLE__)
-    load_libs();
+    else
+        load_libs();
 #endif
 
 #if (defined(NOEGL) && !defined(ANDROID) && !defined(__APPLE__)) || defined(__EMSCRIPTEN__)
@@ -345,6 +364,14 @@ void initialize_gl4es() {
         break;
     }
 
+    globals4es.texthreads=ReturnEnvVarInt("LIBGL_TEXTHREADS");
+    if(globals4es.texthreads>1)
+        texthreads_init(globals4es.texthreads);
+    else
+        globals4es.texthreads=0;
+    env(LIBGL_TEXASYNC, globals4es.texasync, "Asynchronous texture uploads");
+    texasync_init();
+
     env(LIBGL_TEXDUMP, globals4es.texdump, "Texture dump enabled");
     env(LIBGL_ALPHAHACK, globals4es.alphahack, "Alpha Hack enabled");
 
@@ -461,6 +488,18 @@ void initialize_gl4es() {
         }
       }
 
+    globals4es.listopt = ReturnEnvVarIntDef("LIBGL_LISTOPT",1);
+    if(!globals4es.listopt)
+        SHUT_LOGD("Display lists are kept as recorded\n");
+    globals4es.listvcache = ReturnEnvVarIntDef("LIBGL_LISTVCACHE",1);
+    switch(globals4es.listvcache) {
+        case 0: SHUT_LOGD("No vertex cache optimization of display lists\n"); break;
+        case 2: SHUT_LOGD("Display lists triangles reordered for the vertex cache\n"); break;
+    }
+    if(globals4es.mergelist) {
+        env(LIBGL_BATCH2D, globals4es.batch2d, "2D glBegin/glEnd blocks are batched across texture and blend changes");
+    }
+
     if(GetEnvVarBool("LIBGL_AVOID16BITS", &globals4es.avoid16bits, (hardext.vendor&VEND_IMGTEC)?0:1)) {
       if(globals4es.avoid16bits) {
         SHUT_LOGD("Avoid 16bits textures\n");
@@ -548,6 +587,28 @@ void initialize_gl4es() {
               globals4es.usevbo=1;
               break;
         }
+        if(globals4es.usevbo) {
+            globals4es.vbointerleave = ReturnEnvVarInt("LIBGL_VBOINTERLEAVE");
+            if(globals4es.vbointerleave)
+                SHUT_LOGD("glList VBO will use interleaved attributes\n");
+            globals4es.vbocompact = ReturnEnvVarIntDef("LIBGL_VBOCOMPACT",1);
+            switch(globals4es.vbocompact) {
+              case 0:
+                SHUT_LOGD("glList VBO will keep float attributes\n");
+                break;
+              case 2:
+                SHUT_LOGD("glList VBO will use compact attributes, including short normals\n");
+                break;
+              default:
+                globals4es.vbocompact = 1;
+                break;
+            }
+            globals4es.streamvbo = ReturnEnvVarInt("LIBGL_STREAMVBO");
+            if(globals4es.streamvbo<0) globals4es.streamvbo = 0;
+            if(globals4es.streamvbo>256) globals4es.streamvbo = 256;
+            if(globals4es.streamvbo)
+                SHUT_LOGD("Client arrays will be streamed in a %dMB ring VBO\n", globals4es.streamvbo);
+        }
       }
 
     globals4es.fbomakecurrent = 0;
@@ -707,6 +768,13 @@ void initialize_gl4es() {
         }
     } else 
       SHUT_LOGD("Not using PSA (prgbin_n=%d, notexarray=%d)\n", hardext.prgbin_n, globals4es.notexarray);
+    if(globals4es.nopsa==0) {
+        globals4es.fpeprelink = ReturnEnvVarInt("LIBGL_FPEPRELINK");
+        if(globals4es.fpeprelink>0) {
+            SHUT_LOGD("Loading up to %d FPE programs of the PSA at each end of frame\n", globals4es.fpeprelink);
+        } else
+            globals4es.fpeprelink = 0;
+    }
 
     env(LIBGL_SKIPTEXCOPIES, globals4es.skiptexcopies, "Texture Copies will be skipped");
     if(GetEnvVarFloat("LIBGL_FB_TEX_SCALE",&globals4es.fbtexscale,0.0f)) {
@@ -738,6 +806,12 @@ void close_gl4es() {
     FreeFBVisual();
     #endif
     gl_close();
+    if(globals4es.nullgles)
+        nullgles_print_stats();
+    if(globals4es.stats)
+        stats_print_total();
+    texasync_shutdown();
+    texthreads_shutdown();
     fpe_writePSA();
     fpe_FreePSA();
         #if defined(GL4ES_COMPILE_FOR_USE_IN_SHARED_LIB) && defined(AMIGAOS4)
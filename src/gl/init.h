@@ -8,6 +8,9 @@
 typedef struct _globals4es {
  int nobanner;
  int mergelist;
+ int listopt;          // optimize display lists at glEndList
+ int listvcache;       // 1: merge identical vertices of display lists, 2: also reorder triangles for the vertex cache
+ int batch2d;          // defer glBegin/glEnd blocks across texture / blend changes in 2D
  int xrefresh;
  int stacktrace;
  int usefb;
@@ -51,6 +54,9 @@ typedef struct _globals4es {
  int es;
  int gl;
  int usevbo;
+ int vbointerleave;    // interleave the attributes of glList VBO
+ int vbocompact;       // use smaller attribute formats in glList VBO
+ int streamvbo;        // size in MB of the ring VBO used to stream client arrays (0: disabled)
  int comments;
  int forcenpot;
  int fbomakecurrent;    // hack to bind/unbind FBO when doing glXMakeCurrent
@@ -77,6 +83,11 @@ typedef struct _globals4es {
  int skiptexcopies;
  int shaderblend;
  int deepbind;
+ int nullgles;          // null GLES backend (1 = count calls, 2 = also log them)
+ int stats;             // print the hot-path counters every N frames
+ int texthreads;        // threads used for the big texture conversions
+ int texasync;          // texture conversions done in background, upload deferred to the draw
+ int fpeprelink;        // FPE programs of the PSA loaded ahead of time at each end of frame
  float fbtexscale;
  #ifndef NO_GBM
  char drmcard[50];
@@ -20,6 +20,7 @@ void APIENTRY_GL4ES gl4es_glLightModelf(GLenum pname, GLfloat param) {
         case GL_LIGHT_MODEL_TWO_SIDE:
             errorGL();
             glstate->light.two_side = param;
+            glstate->fpe_dirty = 1;
             if(glstate->fpe_state)
                 glstate->fpe_state->twosided = param;
 			break;
@@ -34,6 +35,7 @@ void APIENTRY_GL4ES gl4es_glLightModelf(GLenum pname, GLfloat param) {
                     return;
                 }
                 glstate->light.separate_specular=value;
+                glstate->fpe_dirty = 1;
                 if(glstate->fpe_state)
                     glstate->fpe_state->light_separate=value;
             }
@@ -46,6 +48,7 @@ void APIENTRY_GL4ES gl4es_glLightModelf(GLenum pname, GLfloat param) {
                     return;
                 }
                 glstate->light.local_viewer=value;
+                glstate->fpe_dirty = 1;
                 if(glstate->fpe_state)
                     glstate->fpe_state->light_localviewer=value;
             }
@@ -92,6 +95,7 @@ void APIENTRY_GL4ES gl4es_glLightModelfv(GLenum pname, const GLfloat* params) {
             }
             errorGL();
             glstate->light.two_side = params[0];
+            glstate->fpe_dirty = 1;
             if(glstate->fpe_state)
                 glstate->fpe_state->twosided = params[0];
         break;
@@ -106,6 +110,7 @@ void APIENTRY_GL4ES gl4es_glLightModelfv(GLenum pname, const GLfloat* params) {
                     return;
                 }
                 glstate->light.separate_specular=value;
+                glstate->fpe_dirty = 1;
                 if(glstate->fpe_state)
                     glstate->fpe_state->light_separate=value;
             }
@@ -118,6 +123,7 @@ void APIENTRY_GL4ES gl4es_glLightModelfv(GLenum pname, const GLfloat* params) {
                     return;
                 }
                 glstate->light.local_viewer=value;
+                glstate->fpe_dirty = 1;
                 if(glstate->fpe_state)
                     glstate->fpe_state->light_localviewer=value;
             }
@@ -170,6 +176,7 @@ void APIENTRY_GL4ES gl4es_glLightfv(GLenum light, GLenum pname, const GLfloat* p
                 return;
             memcpy(glstate->light.lights[nl].position, tmp, 4*sizeof(GLfloat));
             if(glstate->fpe_state) {
+                glstate->fpe_dirty = 1;
                 int dir = (tmp[3]!=0.f);
                 if (dir) {
                     glstate->fpe_state->light_direction |= (1<<nl);
@@ -202,6 +209,7 @@ void APIENTRY_GL4ES gl4es_glLightfv(GLenum light, GLenum pname, const GLfloat* p
                 return;
             glstate->light.lights[nl].spotCutoff = params[0];
             if(glstate->fpe_state) {
+                glstate->fpe_dirty = 1;
                 int dir = (params[0]!=180.f);
                 if (dir) {
                     glstate->fpe_state->light_cutoff180 |= (1<<nl);
@@ -313,11 +321,13 @@ void APIENTRY_GL4ES gl4es_glMaterialfv(GLenum face, GLenum pname, const GLfloat
             }
             if(face==GL_FRONT_AND_BACK || face==GL_FRONT) {
                 glstate->material.front.shininess = *params;
+                glstate->fpe_dirty = 1;
                 if(glstate->fpe_state)
                     glstate->fpe_state->cm_front_nullexp=(*params<=0.0)?0:1;
             }
             if(face==GL_FRONT_AND_BACK || face==GL_BACK) {
                 glstate->material.back.shininess = *params;
+                glstate->fpe_dirty = 1;
                 if(glstate->fpe_state)
                     glstate->fpe_state->cm_back_nullexp=(*params<=0.0)?0:1;
             }
@@ -415,6 +425,7 @@ void APIENTRY_GL4ES gl4es_glColorMaterial(GLenum face, GLenum mode) {
     if(face==GL_FRONT_AND_BACK || face==GL_BACK)
         glstate->material.back.colormat = mode;
     if(glstate->fpe_state) {
+        glstate->fpe_dirty = 1;
         int value = FPE_CM_AMBIENTDIFFUSE;
         switch(mode) {
             case GL_EMISSION: value = FPE_CM_EMISSION; break;
@@ -70,7 +70,8 @@ void bind_stipple_tex() {
     gl4es_glBindTexture(GL_TEXTURE_2D, glstate->linestipple.texture);
 }
 
-GLfloat *gen_stipple_tex_coords(GLfloat *vert, GLushort *sindices, modeinit_t *modes, int stride, int length, GLfloat* noalloctex) {
+GLfloat *gen_stipple_tex_coords(GLfloat *vert, GLushort *sindices, GLuint *iindices, modeinit_t *modes, int stride, int length, GLfloat* noalloctex) {
+    #define IND(a) (sindices?sindices[a]:iindices[a])
     DBG(printf("Generate stripple tex (stride=%d, noalloctex=%p) length=%d:", stride, noalloctex, length);)
     // generate our texture coords
     GLfloat *tex = noalloctex?noalloctex:(GLfloat *)malloc(modes[length-1].ilen * 4 * sizeof(GLfloat));
@@ -97,11 +98,11 @@ GLfloat *gen_stipple_tex_coords(GLfloat *vert, GLushort *sindices, modeinit_t *m
             continue;
         if(mode==GL_LINES || length>1)  // always line when multiple lines were merged
             for (; i < modes[k].ilen; i+=2) {
-                if(sindices)
-                    vertPos = vert+stride*sindices[i];
+                if(sindices || iindices)
+                    vertPos = vert+stride*IND(i);
                 vector_matrix(vertPos, mvp, v);
-                if(sindices)
-                    vertPos = vert+stride*sindices[i+1];
+                if(sindices || iindices)
+                    vertPos = vert+stride*IND(i+1);
                 else
                     vertPos+=stride;
                 // need to take "w" component into account...
@@ -120,12 +121,12 @@ GLfloat *gen_stipple_tex_coords(GLfloat *vert, GLushort *sindices, modeinit_t *m
                 oldlen = len;
                 len += sqrtf((x2-x1)*(x2-x1) + (y2-y1)*(y2-y1)) / (glstate->linestipple.factor * 16.f);
                 DBG(printf("%f->%f (%f,%f -> %f,%f)\t", oldlen, len, x1, y1, x2, y2);)
-                if(sindices)
-                    texPos = tex+texstride*sindices[i+0];   // it gets written 2*, but that should be ok, it's the same value
+                if(sindices || iindices)
+                    texPos = tex+texstride*IND(i+0);   // it gets written 2*, but that should be ok, it's the same value
                 memset(texPos, 0, 4*sizeof(GLfloat));
                 texPos[0] = oldlen; texPos[3] = 1.0f;
-                if(sindices)
-                    texPos = tex+texstride*sindices[i+1];
+                if(sindices || iindices)
+                    texPos = tex+texstride*IND(i+1);
                 else
                     texPos+=texstride;
                 memset(texPos, 0, 4*sizeof(GLfloat));
@@ -134,8 +135,8 @@ GLfloat *gen_stipple_tex_coords(GLfloat *vert, GLushort *sindices, modeinit_t *m
             }
         else { // GL_LINE_STRIP and GL_LINE_LOOPS works the same here 
                 // (well, last segment, the "loop" one, will look strange, but I will not add a vertex for that)
-            if(sindices)
-                vertPos = vert+stride*sindices[i];
+            if(sindices || iindices)
+                vertPos = vert+stride*IND(i);
             vector_matrix(vertPos, mvp, v);
             x2=(v[0]/v[3])*w; y2=(v[1]/v[3])*h;
             vertPos+=stride;
@@ -146,15 +147,15 @@ GLfloat *gen_stipple_tex_coords(GLfloat *vert, GLushort *sindices, modeinit_t *m
             ++i;
             for (; i < modes[k].ilen; i++) {
                 x1 = x2; y1 = y2;
-                if(sindices)
-                    vertPos = vert+stride*sindices[i];
+                if(sindices || iindices)
+                    vertPos = vert+stride*IND(i);
                 vector_matrix(vertPos, mvp, v);
                 vertPos+=stride;
                 x2=(v[0]/v[3])*w; y2=(v[1]/v[3])*h;
                 len += sqrtf((x2-x1)*(x2-x1) + (y2-y1)*(y2-y1)) / (glstate->linestipple.factor * 16.f);
                 DBG(printf("->%f\t", len);)
-                if(sindices)
-                    texPos = tex+texstride*sindices[i];
+                if(sindices || iindices)
+                    texPos = tex+texstride*IND(i);
                 memset(texPos, 0, 4*sizeof(GLfloat));
                 texPos[0] = len; texPos[3] = 1.0f;
                 texPos+=texstride;
@@ -162,5 +163,6 @@ GLfloat *gen_stipple_tex_coords(GLfloat *vert, GLushort *sindices, modeinit_t *m
         }
     }
     DBG(printf("\n");)
+    #undef IND
     return tex;
 }
@@ -1,12 +1,16 @@
 #include "list.h"
 
+#include <math.h>
+
 #include "../glx/hardext.h"
 #include "const.h"
 #include "gl4es.h"
 #include "glstate.h"
 #include "init.h"
 #include "loader.h"
+#include "matvec.h"
 #include "buffers.h"
+#include "stats.h"
 
 // KH Map implementation
 KHASH_MAP_IMPL_INT(material, rendermaterial_t *);
@@ -16,9 +20,16 @@ KHASH_MAP_IMPL_INT(texenv, rendertexenv_t *);
 KHASH_MAP_IMPL_INT(gllisthead, renderlist_t*);
 
 renderlist_t *alloc_renderlist() {
-
-    renderlist_t *list = (renderlist_t *)malloc(sizeof(renderlist_t));
+    renderlist_t *list;
+    if(glstate->list.pool) {
+        list = glstate->list.pool;
+        glstate->list.pool = list->next;
+        if(--glstate->list.pool_len < glstate->list.pool_low)
+            glstate->list.pool_low = glstate->list.pool_len;
+    } else
+        list = (renderlist_t *)malloc(sizeof(renderlist_t));
     memset(list, 0, sizeof(renderlist_t));
+    STATS_INC(renderlists);
     list->cap = DEFAULT_RENDER_LIST_CAPACITY;
     list->matrix_val[0] = list->matrix_val[5] = list->matrix_val[10] = 
                           list->matrix_val[15] = 1.0f;
@@ -112,9 +123,10 @@ bool islistscompatible_renderlist(renderlist_t *a, renderlist_t *b) {
         if (a_mode != b_mode)
             return false;
     }
-    if(a->use_vbo_array==2 || b->use_vbo_array==2)
+    // glBegin lists are flagged use_vbo_array==2 without a VBO, they can still be merged
+    if(a->vbo_array || b->vbo_array)
         return false;
-    if(a->use_vbo_indices==2 || b->use_vbo_indices==2)
+    if(a->vbo_indices || b->vbo_indices)
         return false;
     if(!a->open || !b->open)
         return false;
@@ -159,6 +171,8 @@ bool islistscompatible_renderlist(renderlist_t *a, renderlist_t *b) {
         return false;
     if ((a->ilen+b->ilen)>60000)
         return false;
+    if (a->iindices || b->iindices)
+        return false;
     
     return true;
 }
@@ -237,37 +251,53 @@ void renderlist_quads_triangles(GLushort *ind, int len, GLushort *indices, int c
     }
 }
 #undef vind
-#define vind(a) ((ind)?ind[(a)]:(a))
+#define vind(a) ((ind)?ind[(a)]:((iind)?iind[(a)]:(a)))
 void renderlist_quads2triangles(renderlist_t *a) {
     GLushort *ind = a->indices;
-    int len = (ind)? a->ilen:a->len;
+    GLuint *iind = a->iindices;
+    int len = (ind || iind)? a->ilen:a->len;
     // len must be a multiple of 4 !
     len &= ~3;  // discard extra vertex...
     int ilen = len*3/2;
-    if(a->use_glstate) {
-        if(ind) {//need to copy first...
-            ind = (GLushort*)malloc(len*sizeof(GLushort));
-            memcpy(ind, glstate->merger_indices, len*sizeof(GLushort));
-            a->shared_indices = NULL;   // should not be needed
-        }
+    // vertices past 65535 cannot be reached with GLushort
+    int wide = iind || (a->len>65536 && hardext.elementuint);
+    if(a->use_glstate && ind) {
+        //need to copy first...
+        ind = (GLushort*)malloc(len*sizeof(GLushort));
+        memcpy(ind, glstate->merger_indices, len*sizeof(GLushort));
+        a->shared_indices = NULL;   // should not be needed
+    }
+    if(wide) {
+        a->indices = NULL;
+        a->iindices = (GLuint*)malloc(ilen*sizeof(GLuint));
+    } else if(a->use_glstate) {
         resize_merger_indices(ilen);
         a->indices = glstate->merger_indices;
     } else
         a->indices = (GLushort*)malloc(ilen*sizeof(GLushort));
 
-    for (int i=0, j=0; i+3<len; i+=4, j+=6) {
-        a->indices[j+0] = vind(i+0);
-        a->indices[j+1] = vind(i+1);
-        a->indices[j+2] = vind(i+2);
-
-        a->indices[j+3] = vind(i+0);
-        a->indices[j+4] = vind(i+2);
-        a->indices[j+5] = vind(i+3);
+    #define GO(D) \
+    for (int i=0, j=0; i+3<len; i+=4, j+=6) {   \
+        D[j+0] = vind(i+0);                     \
+        D[j+1] = vind(i+1);                     \
+        D[j+2] = vind(i+2);                     \
+                                                \
+        D[j+3] = vind(i+0);                     \
+        D[j+4] = vind(i+2);                     \
+        D[j+5] = vind(i+3);                     \
+    }
+    if(wide) {
+        GO(a->iindices)
+    } else {
+        GO(a->indices)
     }
+    #undef GO
     a->ilen = ilen;
-    if (ind) {
+    a->indice_cap = ilen;
+    if (ind || iind) {
         if (!a->shared_indices || ((*a->shared_indices)--)==0)  {
             free(ind); 
+            free(iind);
             free(a->shared_indices);
         }
         a->shared_indices = NULL; // unshared list
@@ -328,7 +358,7 @@ void list_add_modeinit(renderlist_t* list, GLenum mode) {
         list->mode_inits = (modeinit_t*)realloc(list->mode_inits, list->mode_init_cap*sizeof(modeinit_t));
     }
     list->mode_inits[list->mode_init_len].mode_init = mode;
-    list->mode_inits[list->mode_init_len++].ilen = list->indices?list->ilen:(list->cur_istart?list->cur_istart:list->len);
+    list->mode_inits[list->mode_init_len++].ilen = (list->indices || list->iindices)?list->ilen:(list->cur_istart?list->cur_istart:list->len);
 }
 
 void unshared_renderlist(renderlist_t *a, int cap) {
@@ -511,6 +541,7 @@ void doadd_renderlist(renderlist_t* a, GLenum mode, GLushort* indices, int count
 
 void append_renderlist(renderlist_t *a, renderlist_t *b) {
     // append all draw elements of b in a
+    STATS_INC(merged);
     // check the final indice size of a and b
     int ilen_a = a->ilen;
     int ilen_b = b->ilen;
@@ -626,11 +657,6 @@ renderlist_t* append_calllist(renderlist_t *list, renderlist_t *a)
             // copy the many list arrays
             if (list->calls.len > 0) {
                 ++(*list->shared_calls);
-                /*
-                list->calls.calls = (packed_call_t**)malloc(sizeof(packed_call_t*)*a->calls.cap);
-                for (int i = 0; i < list->calls.len; i++) {
-                    list->calls.calls[i] = glCopyPackedCall(a->calls.calls[i]);
-                }*/
             }
             if(list->len) {
                 ++(*list->shared_arrays);
@@ -654,6 +680,10 @@ renderlist_t* append_calllist(renderlist_t *list, renderlist_t *a)
             PROCESS(texgen, rendertexgen_t, m->pname | ((m->coord-GL_S)<<16));
             PROCESS(texenv, rendertexenv_t, m->pname | ((m->target)<<16));
             #undef PROCESS
+            if (list->mode_inits) {
+                list->mode_inits = (modeinit_t*)malloc(list->mode_init_cap*sizeof(modeinit_t));
+                memcpy(list->mode_inits, a->mode_inits, list->mode_init_len*sizeof(modeinit_t));
+            }
             if (list->lightmodel) {
                 list->lightmodel = (GLfloat*)malloc(4*sizeof(GLfloat));
                 memcpy(list->lightmodel, a->lightmodel, 4*sizeof(GLfloat));
@@ -684,10 +714,7 @@ void free_renderlist(renderlist_t *list) {
             free(list->mode_inits);
         if ((list->calls.len > 0) && (!list->shared_calls || ((*list->shared_calls)--)==0)) {
             if(list->shared_calls) free(list->shared_calls);
-            for (int i = 0; i < list->calls.len; i++) {
-                free(list->calls.calls[i]);
-            }
-            free(list->calls.calls);
+            free(list->calls.data);
         }
         int a;
         if(!list->use_glstate) {
@@ -705,9 +732,15 @@ void free_renderlist(renderlist_t *list) {
                 if (list->shared_indices) free(list->shared_indices);
                 if (list->indices)
                     free(list->indices);
+                if (list->iindices)
+                    free(list->iindices);
             }
-        } else
+        } else {
+            // 32bits indices are never in the merger buffers
+            if (list->iindices)
+                free(list->iindices);
             glstate->merger_used = 0;
+        }
 
         if (list->material) {
             rendermaterial_t *m;
@@ -762,14 +795,36 @@ void free_renderlist(renderlist_t *list) {
             free(list->final_colors);
         if(list->vbo_array)
             deleteSingleBuffer(list->vbo_array);
+        if(list->vbo_format)
+            free(list->vbo_format);
         if(list->vbo_indices)
             deleteSingleBuffer(list->vbo_indices);
 
         next = list->next;
-        free(list);
+        // keep the renderlist_t around, immediate mode allocates a lot of them each frame
+        if(glstate) {
+            list->next = glstate->list.pool;
+            glstate->list.pool = list;
+            ++glstate->list.pool_len;
+        } else
+            free(list);
     } while ((list = next));
 }
 
+void trim_renderlist_pool() {
+    // free the renderlist_t that stayed unused since the last call (called once per frame)
+    if(!glstate)
+        return;
+    int n = glstate->list.pool_low;
+    while(n-- && glstate->list.pool) {
+        renderlist_t *list = glstate->list.pool;
+        glstate->list.pool = list->next;
+        --glstate->list.pool_len;
+        free(list);
+    }
+    glstate->list.pool_low = glstate->list.pool_len;
+}
+
 void resize_renderlist(renderlist_t *list) {
     if (list->use_glstate) {
         if (list->len >= glstate->merger_cap) {
@@ -810,8 +865,26 @@ void resize_merger_indices(int cap) {
 }
 
 void resize_indices_renderlist(renderlist_t *list, int n) {
+    if (list->iindices) {
+        if(list->ilen+n<list->indice_cap)
+            return;
+        list->indice_cap = ((list->indice_cap+n+511)>>9)<<9;
+        list->iindices = (GLuint*)realloc(list->iindices, list->indice_cap*sizeof(GLuint));
+        return;
+    }
     if (!list->indices || list->shared_indices)
         return;
+    if (list->len>65536 && hardext.elementuint) {
+        // the list just grew past what GLushort can index, switch to GLuint
+        list->indice_cap = ((list->ilen+n+511)>>9)<<9;
+        list->iindices = (GLuint*)malloc(list->indice_cap*sizeof(GLuint));
+        for (int i=0; i<list->ilen; i++)
+            list->iindices[i] = list->indices[i];
+        if (!list->use_glstate)
+            free(list->indices);
+        list->indices = NULL;
+        return;
+    }
     if (list->use_glstate) {
         resize_merger_indices(list->ilen+n);
         list->indices = glstate->merger_indices;
@@ -851,7 +924,7 @@ renderlist_t* end_renderlist(renderlist_t *list) {
     
     switch (list->mode) {
         case GL_QUADS:
-			if (((list->indices) && (list->ilen==4)) || ((list->indices==NULL) && (list->len==4))) {
+			if (((list->indices || list->iindices) && (list->ilen==4)) || ((list->indices==NULL && list->iindices==NULL) && (list->len==4))) {
 				list->mode = GL_TRIANGLE_FAN;
 			} else {
                 renderlist_quads2triangles(list);
@@ -864,6 +937,8 @@ renderlist_t* end_renderlist(renderlist_t *list) {
             list->mode = GL_TRIANGLE_STRIP;
             break;
     }
+    if(list->name && globals4es.listvcache)
+        vcache_renderlist(list);
     if(list->prev && isempty_renderlist(list)) {
         renderlist_t *p = list;
         list = list->prev;
@@ -969,3 +1044,742 @@ renderlist_t* recycle_renderlist(renderlist_t *list, GLenum mode) {
 
     return list;
 }
+
+// glEndList optimizer: state already in effect is dropped, then renderlists that became compatible are merged
+#define OPT_MAXCAP      32
+#define OPT_MAXTEX      16
+#define OPT_NBMAT       5
+typedef struct {
+    packed_call_t *color, *normal, *linewidth, *pointsize;  // last call of those setters
+    int         ncap;
+    GLenum      cap[OPT_MAXCAP];
+    GLboolean   capon[OPT_MAXCAP];
+    int         tmu;    // -1 until the list sets it
+    int         ntex;
+    int         tex_tmu[OPT_MAXTEX];
+    GLenum      tex_target[OPT_MAXTEX];
+    GLuint      tex[OPT_MAXTEX];
+    int         mat_set[2][OPT_NBMAT];
+    GLfloat     mat[2][OPT_NBMAT][4];
+} listopt_t;
+
+static void listopt_resetmaterial(listopt_t *o) {
+    memset(o->mat_set, 0, sizeof(o->mat_set));
+}
+
+static void listopt_resetcolor(listopt_t *o) {
+    o->color = NULL;
+    listopt_resetmaterial(o);   // in case of GL_COLOR_MATERIAL
+}
+
+static void listopt_reset(listopt_t *o) {
+    int tmu = o->tmu;
+    memset(o, 0, sizeof(listopt_t));
+    o->tmu = tmu;
+}
+
+static int listopt_samecall(packed_call_t *a, packed_call_t *b) {
+    if(!a || !b || a->func!=b->func || a->format!=b->format)
+        return 0;
+    switch(a->format) {
+        #define GO(F) case FORMAT_##F: return !memcmp(&((PACKED_##F*)a)->args, &((PACKED_##F*)b)->args, sizeof(ARGS_##F))
+        GO(void_GLfloat);
+        GO(void_GLfloat_GLfloat_GLfloat);
+        GO(void_GLfloat_GLfloat_GLfloat_GLfloat);
+        #undef GO
+    }
+    return 0;
+}
+
+// return 1 if the call is redundant with the state already in effect
+static int listopt_call(listopt_t *o, packed_call_t *c) {
+    packed_call_t **setter = NULL;
+    if(c->func==gl4es_glColor4f) setter = &o->color;
+    else if(c->func==gl4es_glNormal3f) setter = &o->normal;
+    else if(c->func==gl4es_glLineWidth) setter = &o->linewidth;
+    else if(c->func==gl4es_glPointSize) setter = &o->pointsize;
+    if(setter) {
+        if(listopt_samecall(*setter, c))
+            return 1;
+        if(setter==&o->color)
+            listopt_resetcolor(o);
+        *setter = c;
+        return 0;
+    }
+    if(c->func==gl4es_glEnable || c->func==gl4es_glDisable) {
+        GLenum cap = ((PACKED_void_GLenum*)c)->args.a1;
+        GLboolean on = (c->func==gl4es_glEnable)?GL_TRUE:GL_FALSE;
+        // enabling GL_COLOR_MATERIAL copies the current color into the material
+        if(cap==GL_COLOR_MATERIAL && on)
+            listopt_resetmaterial(o);
+        for(int i=0; i<o->ncap; ++i)
+            if(o->cap[i]==cap) {
+                if(o->capon[i]==on)
+                    return 1;
+                o->capon[i] = on;
+                return 0;
+            }
+        if(o->ncap<OPT_MAXCAP) {
+            o->cap[o->ncap] = cap;
+            o->capon[o->ncap++] = on;
+        }
+        return 0;
+    }
+    // matrix stack calls don't touch the tracked state, anything else may
+    if(c->func!=gl4es_glPushMatrix && c->func!=gl4es_glPopMatrix && c->func!=gl4es_glMatrixMode)
+        listopt_reset(o);
+    return 0;
+}
+
+// return 1 if the binding is already in effect
+static int listopt_bindtexture(listopt_t *o, GLenum target, GLuint texture) {
+    for(int i=0; i<o->ntex; ++i)
+        if(o->tex_tmu[i]==o->tmu && o->tex_target[i]==target) {
+            if(o->tex[i]==texture)
+                return 1;
+            o->tex[i] = texture;
+            return 0;
+        }
+    if(o->ntex<OPT_MAXTEX) {
+        o->tex_tmu[o->ntex] = o->tmu;
+        o->tex_target[o->ntex] = target;
+        o->tex[o->ntex++] = texture;
+    }
+    return 0;
+}
+
+static int listopt_matslot(GLenum pname) {
+    switch(pname) {
+        case GL_AMBIENT: return 0;
+        case GL_DIFFUSE: return 1;
+        case GL_SPECULAR: return 2;
+        case GL_EMISSION: return 3;
+        case GL_SHININESS: return 4;
+    }
+    return -1;
+}
+
+// return 1 if the material value is already in effect
+static int listopt_material(listopt_t *o, rendermaterial_t *m) {
+    int f0 = (m->face==GL_BACK)?1:0;
+    int f1 = (m->face==GL_FRONT)?0:1;
+    int s0 = listopt_matslot(m->pname);
+    int s1 = s0;
+    if(m->pname==GL_AMBIENT_AND_DIFFUSE) {
+        s0 = 0; s1 = 1;
+    }
+    if(s0<0)
+        return 0;
+    int sz = (m->pname==GL_SHININESS)?1:4;
+    // with GL_COLOR_MATERIAL, the next glColor sets the material again, even with the same color
+    o->color = NULL;
+    int same = 1;
+    for(int f=f0; f<=f1; ++f)
+        for(int s=s0; s<=s1; ++s) {
+            if(!o->mat_set[f][s] || memcmp(o->mat[f][s], m->color, sz*sizeof(GLfloat)))
+                same = 0;
+            o->mat_set[f][s] = 1;
+            memcpy(o->mat[f][s], m->color, sz*sizeof(GLfloat));
+        }
+    return same;
+}
+
+static bool isvoid_renderlist(renderlist_t *list) {
+    // return true if the renderlist does nothing at all
+    if (list->len || list->mode_init || list->calls.len || list->matrix_op || list->raster_op || list->raster || list->bitmaps)
+        return false;
+    if (list->pushattribute || list->popattribute || list->render_op || list->fog_op || list->pointparam_op)
+        return false;
+    if (list->material || list->colormat_face || list->light || list->lightmodel || list->texgen || list->texenv)
+        return false;
+    if (list->linestipple_op || list->polygon_mode || list->set_texture || list->set_tmu)
+        return false;
+    if (list->post_color || list->post_normal)
+        return false;
+    return true;
+}
+
+static void unlink_renderlist(renderlist_t *a, renderlist_t *b) {
+    // remove b, that follows a, from the chain and free it
+    a->next = b->next;
+    if(b->next)
+        b->next->prev = a;
+    b->next = b->prev = NULL;
+    free_renderlist(b);
+}
+
+static GLfloat* constarray_renderlist(renderlist_t *l, int n, const GLfloat *v) {
+    GLfloat *array = alloc_sublist(n, l->cap);
+    for(int i=0; i<l->len; ++i)
+        memcpy(array+i*n, v, n*sizeof(GLfloat));
+    return array;
+}
+
+static packed_call_t* lastcall_renderlist(renderlist_t *l, void *func) {
+    packed_call_t *last = NULL;
+    for(char *p=l->calls.data, *end=p+l->calls.size; p<end; p=CALL_NEXT(p))
+        if(CALL_PACKED(p)->func==func)
+            last = CALL_PACKED(p);
+    return last;
+}
+
+static int bakecalls_renderlist(renderlist_t *a, renderlist_t *b) {
+    // glColor / glNormal are turned into constant arrays when only one of a and b has that array,
+    // so both can be merged. For b, the calls become post calls so b is left with only its draw.
+    // Return 1 if b can now be merged in a, else a and b are left untouched
+    if(!b->len || b->shared_arrays || b->use_glstate || a->shared_arrays || a->use_glstate)
+        return 0;
+    packed_call_t *color = NULL, *normal = NULL;
+    if(b->calls.len) {
+        if(b->shared_calls)
+            return 0;
+        for(char *p=b->calls.data, *end=p+b->calls.size; p<end; p=CALL_NEXT(p)) {
+            packed_call_t *c = CALL_PACKED(p);
+            if(c->func==gl4es_glColor4f && !b->color)
+                color = c;
+            else if(c->func==gl4es_glNormal3f && !b->normal)
+                normal = c;
+            else
+                return 0;
+        }
+    }
+    // a uses the value of its own last call for the whole draw
+    packed_call_t *acolor = (b->color || color) && !a->color?lastcall_renderlist(a, gl4es_glColor4f):NULL;
+    packed_call_t *anormal = (b->normal || normal) && !a->normal?lastcall_renderlist(a, gl4es_glNormal3f):NULL;
+    if(((b->color || color) && !a->color && !acolor) || ((b->normal || normal) && !a->normal && !anormal))
+        return 0; // no way to get the same arrays on both sides
+    if(!acolor && !anormal && !color && !normal)
+        return 0; // nothing to bake
+    // bake, check, and undo if the lists still can't be merged
+    call_list_t calls = b->calls;
+    const int post_color = b->post_color, post_normal = b->post_normal;
+    GLfloat post_colors[4], post_normals[3];
+    memcpy(post_colors, b->post_colors, sizeof(post_colors));
+    memcpy(post_normals, b->post_normals, sizeof(post_normals));
+    #define COLOR(c)  &((PACKED_void_GLfloat_GLfloat_GLfloat_GLfloat*)(c))->args.a1
+    #define NORMAL(c) &((PACKED_void_GLfloat_GLfloat_GLfloat*)(c))->args.a1
+    if(acolor)
+        a->color = constarray_renderlist(a, 4, COLOR(acolor));
+    if(anormal)
+        a->normal = constarray_renderlist(a, 3, NORMAL(anormal));
+    if(color) {
+        b->color = constarray_renderlist(b, 4, COLOR(color));
+        memcpy(b->post_colors, COLOR(color), 4*sizeof(GLfloat));
+        b->post_color = 1;
+    }
+    if(normal) {
+        b->normal = constarray_renderlist(b, 3, NORMAL(normal));
+        memcpy(b->post_normals, NORMAL(normal), 3*sizeof(GLfloat));
+        b->post_normal = 1;
+    }
+    #undef COLOR
+    #undef NORMAL
+    memset(&b->calls, 0, sizeof(call_list_t));
+    if(ispurerender_renderlist(b) && islistscompatible_renderlist(a, b)) {
+        rlFreeCalls(&calls);
+        return 1;
+    }
+    if(acolor) {
+        free(a->color);
+        a->color = NULL;
+    }
+    if(anormal) {
+        free(a->normal);
+        a->normal = NULL;
+    }
+    if(color) {
+        free(b->color);
+        b->color = NULL;
+    }
+    if(normal) {
+        free(b->normal);
+        b->normal = NULL;
+    }
+    b->post_color = post_color;
+    b->post_normal = post_normal;
+    memcpy(b->post_colors, post_colors, sizeof(post_colors));
+    memcpy(b->post_normals, post_normals, sizeof(post_normals));
+    b->calls = calls;
+    return 0;
+}
+
+renderlist_t* optimize_renderlist(renderlist_t *list) {
+    if(!list)
+        return list;
+    list = GetFirst(list);
+    listopt_t opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.tmu = -1;
+    // first pass: drop the state changes that are already in effect, following the order of draw_renderlist
+    for(renderlist_t *l=list; l; l=l->next) {
+        if(l->popattribute)
+            listopt_reset(&opt);
+        call_list_t *cl = &l->calls;
+        if(l->shared_calls) {
+            for(char *p=cl->data, *end=p+cl->size; p<end; p=CALL_NEXT(p))
+                listopt_call(&opt, CALL_PACKED(p));
+        } else {
+            // compact the kept calls in place, each call is moved before being tracked
+            char *w = cl->data, *end = cl->data+cl->size;
+            for(char *p=cl->data, *next; p<end; p=next) {
+                next = CALL_NEXT(p);
+                unsigned int sz = CALL_SIZE(p);
+                if(w!=p)
+                    memmove(w, p, sz);
+                if(listopt_call(&opt, CALL_PACKED(w)))
+                    --cl->len;
+                else
+                    w += sz;
+            }
+            cl->size = w-cl->data;
+            if(!cl->len)
+                rlFreeCalls(cl);
+        }
+        if(l->set_tmu) {
+            opt.tmu = l->tmu;
+            opt.ncap = 0;   // texture enables are per unit
+        }
+        if(l->set_texture && listopt_bindtexture(&opt, l->target_texture, l->texture))
+            l->set_texture = GL_FALSE;
+        if(l->raster || l->bitmaps)
+            opt.ntex = 0;   // bitmaps are drawn with their own texture
+        if(l->material) {
+            khash_t(material) *map = l->material;
+            khint_t k;
+            for (k = kh_begin(map); k != kh_end(map); ++k)
+                if (kh_exist(map, k) && listopt_material(&opt, kh_value(map, k))) {
+                    free(kh_value(map, k));
+                    kh_del(material, map, k);
+                }
+            if(!kh_size(map)) {
+                kh_destroy(material, map);
+                l->material = NULL;
+            }
+        }
+        if(l->colormat_face)
+            listopt_resetmaterial(&opt);
+        if(l->len) {
+            if(l->color || l->post_color)
+                listopt_resetcolor(&opt);
+            if(l->normal || l->post_normal)
+                opt.normal = NULL;
+            if(l->mode_dimension==2) {
+                // line stipple use its own texture and state
+                opt.ntex = 0;
+                opt.ncap = 0;
+            }
+        }
+    }
+    // second pass: remove the empty renderlists and merge the compatible ones
+    renderlist_t *a = list;
+    while(a->next) {
+        renderlist_t *b = a->next;
+        if(isvoid_renderlist(b)) {
+            unlink_renderlist(a, b);
+            continue;
+        }
+        if((a->len && globals4es.mergelist && bakecalls_renderlist(a, b))
+         || (ispurerender_renderlist(b) && islistscompatible_renderlist(a, b))) {
+            append_renderlist(a, b);
+            unlink_renderlist(a, b);
+        } else
+            a = b;
+    }
+    return a;
+}
+
+// Vertex cache pass, done on display lists when they are closed (so before their VBO is built)
+#define VCACHE_SIZE     32
+#define VCACHE_MAXATT   (5+MAX_TEX)
+
+static uint32_t vcache_hash(GLfloat **att, int *n, int natt, int i) {
+    uint32_t h = 2166136261u;
+    for(int a=0; a<natt; ++a) {
+        const unsigned char *p = (const unsigned char*)(att[a]+i*n[a]);
+        for(int j=0; j<n[a]*(int)sizeof(GLfloat); ++j)
+            h = (h^p[j])*16777619u;
+    }
+    return h;
+}
+
+static int vcache_attribs(renderlist_t *list, GLfloat **att, int *n) {
+    // return the number of vertex arrays, -1 if one is not packed
+    int natt = 0;
+    #define ATT(A, N, S) if(list->A) { if(S) return -1; att[natt] = list->A; n[natt++] = N; }
+    ATT(vert, 4, list->vert_stride);
+    ATT(normal, 3, list->normal_stride);
+    ATT(color, 4, list->color_stride);
+    ATT(secondary, 4, list->secondary_stride);
+    ATT(fogcoord, 1, list->fogcoord_stride);
+    for (int a=0; a<list->maxtex; ++a)
+        ATT(tex[a], 4, list->tex_stride[a]);
+    #undef ATT
+    return natt;
+}
+
+static int vcache_dedupe(GLfloat **att, int *n, int natt, int len, GLuint *remap) {
+    // identical vertices get the same new index in remap, return the number of unique vertices
+    int size = 1;
+    while(size < len*2)
+        size <<= 1;
+    GLuint *table = (GLuint*)malloc(size*sizeof(GLuint));
+    memset(table, 0xff, size*sizeof(GLuint));
+    int m = 0;
+    for(int i=0; i<len; ++i) {
+        uint32_t h = vcache_hash(att, n, natt, i)&(size-1);
+        int found = -1;
+        while(table[h]!=0xffffffff) {
+            int j = table[h];
+            int same = 1;
+            for(int a=0; a<natt && same; ++a)
+                same = !memcmp(att[a]+i*n[a], att[a]+j*n[a], n[a]*sizeof(GLfloat));
+            if(same) {
+                found = j;
+                break;
+            }
+            h = (h+1)&(size-1);
+        }
+        if(found<0) {
+            table[h] = i;
+            remap[i] = m++;
+        } else
+            remap[i] = remap[found];
+    }
+    free(table);
+    return m;
+}
+
+static float vcache_score(int pos, int remaining) {
+    // Forsyth "Linear-Speed Vertex Cache Optimisation" scoring
+    if(!remaining)
+        return -1.f;
+    float s = 0.f;
+    if(pos>=0)
+        s = (pos<3)?0.75f:powf(1.f-(pos-3)*(1.f/(VCACHE_SIZE-3)), 1.5f);
+    return s + 2.f/sqrtf(remaining);
+}
+
+static int vcache_faceverts(const GLuint *ind, int unit, GLuint *v) {
+    int k = 0;
+    for(int i=0; i<unit; ++i) {
+        int j = 0;
+        while(j<k && v[j]!=ind[i]) ++j;
+        if(j==k)
+            v[k++] = ind[i];
+    }
+    return k;
+}
+
+typedef struct {
+    int     *head;      // per vertex, first face entry
+    int     *next;      // per face entry
+    int     *remaining; // per vertex, faces not emitted yet
+    int     *pos;       // per vertex, position in the cache or -1
+    float   *score;     // per vertex
+} vcache_t;
+
+static void vcache_reorder(vcache_t *w, GLuint *ind, int nf, int unit) {
+    // reorder the nf faces of unit indices at ind, the vertices of a face are kept in the same order
+    GLuint fv[6];
+    int nent = nf*unit;
+    for(int i=0; i<nent; ++i) {
+        w->head[ind[i]] = -1;
+        w->remaining[ind[i]] = 0;
+        w->pos[ind[i]] = -1;
+    }
+    for(int f=0; f<nf; ++f) {
+        int k = vcache_faceverts(ind+f*unit, unit, fv);
+        for(int j=0; j<k; ++j) {
+            w->next[f*unit+j] = w->head[fv[j]];
+            w->head[fv[j]] = f*unit+j;
+            w->remaining[fv[j]]++;
+        }
+    }
+    for(int i=0; i<nent; ++i)
+        w->score[ind[i]] = vcache_score(-1, w->remaining[ind[i]]);
+    float *fscore = (float*)malloc(nf*sizeof(float));
+    char *emitted = (char*)calloc(nf, 1);
+    for(int f=0; f<nf; ++f) {
+        int k = vcache_faceverts(ind+f*unit, unit, fv);
+        fscore[f] = 0.f;
+        for(int j=0; j<k; ++j)
+            fscore[f] += w->score[fv[j]];
+    }
+    GLuint *out = (GLuint*)malloc(nent*sizeof(GLuint));
+    GLuint cache[VCACHE_SIZE+6];
+    int ncache = 0;
+    int scan = 0;
+    int best = -1;
+    for(int o=0; o<nf; ++o) {
+        if(best<0) {
+            // nothing left around the cache, continue with the first face in submission order
+            while(emitted[scan]) ++scan;
+            best = scan;
+        }
+        memcpy(out+o*unit, ind+best*unit, unit*sizeof(GLuint));
+        emitted[best] = 1;
+        int k = vcache_faceverts(ind+best*unit, unit, fv);
+        // new cache: face vertices first, then the previous content
+        GLuint ncontent[VCACHE_SIZE+6];
+        int nn = 0;
+        for(int j=0; j<k; ++j) {
+            w->remaining[fv[j]]--;
+            ncontent[nn++] = fv[j];
+        }
+        for(int j=0; j<ncache; ++j) {
+            int l = 0;
+            while(l<k && fv[l]!=cache[j]) ++l;
+            if(l==k)
+                ncontent[nn++] = cache[j];
+        }
+        // update the vertices scores, and the faces scores with the difference
+        for(int j=0; j<nn; ++j) {
+            GLuint v = ncontent[j];
+            w->pos[v] = (j<VCACHE_SIZE)?j:-1;
+            float s = vcache_score(w->pos[v], w->remaining[v]);
+            float d = s - w->score[v];
+            w->score[v] = s;
+            if(d!=0.f)
+                for(int e=w->head[v]; e!=-1; e=w->next[e])
+                    fscore[e/unit] += d;
+        }
+        ncache = (nn<VCACHE_SIZE)?nn:VCACHE_SIZE;
+        memcpy(cache, ncontent, ncache*sizeof(GLuint));
+        // best candidate around the cache
+        best = -1;
+        float bestscore = -1.f;
+        for(int j=0; j<ncache; ++j)
+            for(int e=w->head[cache[j]]; e!=-1; e=w->next[e]) {
+                int f = e/unit;
+                if(!emitted[f] && fscore[f]>bestscore) {
+                    bestscore = fscore[f];
+                    best = f;
+                }
+            }
+    }
+    memcpy(ind, out, nent*sizeof(GLuint));
+    free(out);
+    free(emitted);
+    free(fscore);
+}
+
+static int vcache_unit(GLenum mode_init) {
+    // number of indices that stay together, so the GL_LINE polygon mode still outline the original primitives
+    switch(mode_init) {
+        case GL_TRIANGLES:
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:
+            return 3;
+        case GL_QUADS:
+            return 6;
+    }
+    return 0;
+}
+
+static void vcache_triangles(renderlist_t *list, GLuint *ind) {
+    // faces are only reordered inside a run of primitives of the same kind
+    modeinit_t single = {list->mode_init, list->ilen};
+    modeinit_t *modes = list->mode_inits?list->mode_inits:&single;
+    int nmodes = list->mode_inits?list->mode_init_len:1;
+    if(modes[nmodes-1].ilen!=list->ilen)
+        return;
+    vcache_t w;
+    w.head = (int*)malloc(list->len*sizeof(int));
+    w.remaining = (int*)malloc(list->len*sizeof(int));
+    w.pos = (int*)malloc(list->len*sizeof(int));
+    w.score = (float*)malloc(list->len*sizeof(float));
+    w.next = (int*)malloc(list->ilen*sizeof(int));
+    int start = 0;
+    int m = 0;
+    while(m<nmodes) {
+        int unit = vcache_unit(modes[m].mode_init);
+        int end = modes[m].ilen;
+        while(m+1<nmodes && vcache_unit(modes[m+1].mode_init)==unit)
+            end = modes[++m].ilen;
+        ++m;
+        if(end<start)
+            break;
+        if(unit && !((end-start)%unit) && (end-start)/unit>1)
+            vcache_reorder(&w, ind+start, (end-start)/unit, unit);
+        start = end;
+    }
+    free(w.head);
+    free(w.remaining);
+    free(w.pos);
+    free(w.score);
+    free(w.next);
+}
+
+void vcache_renderlist(renderlist_t *list) {
+    if(list->len<4 || list->use_glstate || list->shared_arrays || list->shared_indices || list->vbo_array)
+        return;
+    // triangles only: line stipple writes texcoords per vertex, that can't be shared
+    if(list->mode_dimension!=3)
+        return;
+    int ilen = (list->indices || list->iindices)?list->ilen:list->len;
+    GLuint *ind = (GLuint*)malloc(ilen*sizeof(GLuint));
+    for(int i=0; i<ilen; ++i)
+        ind[i] = list->indices?list->indices[i]:(list->iindices?list->iindices[i]:i);
+    GLfloat *att[VCACHE_MAXATT];
+    int n[VCACHE_MAXATT];
+    int natt = vcache_attribs(list, att, n);
+    GLuint *remap = (GLuint*)malloc(list->len*sizeof(GLuint));
+    int m = (natt>0)?vcache_dedupe(att, n, natt, list->len, remap):list->len;
+    if(!list->indices && !list->iindices && (m*4>list->len*3 || (m>65535 && !hardext.elementuint))) {
+        // not enough shared vertices to be worth drawing with indices (or too many for 16bits indices)
+        free(remap);
+        free(ind);
+        return;
+    }
+    if(m!=list->len) {
+        // move the unique vertices toward the start, they come in the same order as their new index
+        int k = 0;
+        for(int i=0; i<list->len; ++i)
+            if(remap[i]==k) {
+                if(k!=i)
+                    for(int a=0; a<natt; ++a)
+                        memcpy(att[a]+k*n[a], att[a]+i*n[a], n[a]*sizeof(GLfloat));
+                ++k;
+            }
+        for(int i=0; i<ilen; ++i)
+            ind[i] = remap[ind[i]];
+        list->len = m;
+    }
+    free(remap);
+    if(!list->indices && !list->iindices) {
+        list->ilen = ilen;
+        list->indice_cap = ilen;
+        if(m>65535)
+            list->iindices = (GLuint*)malloc(ilen*sizeof(GLuint));
+        else
+            list->indices = (GLushort*)malloc(ilen*sizeof(GLushort));
+    }
+    if(globals4es.listvcache>1 && list->mode==GL_TRIANGLES)
+        vcache_triangles(list, ind);
+    for(int i=0; i<ilen; ++i)
+        if(list->indices)
+            list->indices[i] = ind[i];
+        else
+            list->iindices[i] = ind[i];
+    free(ind);
+}
+
+// glCallLists batching: runs of lists that only draw and translate (one glyph each for bitmap fonts)
+// are merged in a single renderlist, with the translations applied to the vertices, and drawn at once.
+// Bigger lists are better drawn from their own VBO than copied at each call
+#define CALLLISTS_MAXVERTS  256
+static int istranslation_renderlist(renderlist_t *l) {
+    static const GLfloat id[12] = {1.f,0.f,0.f,0.f, 0.f,1.f,0.f,0.f, 0.f,0.f,1.f,0.f};
+    return (l->matrix_op==2) && !memcmp(l->matrix_val, id, sizeof(id)) && (l->matrix_val[15]==1.f);
+}
+
+static bool isglyph_renderlist(renderlist_t *l, renderlist_t **ref) {
+    // true if the list only draws triangles with the same arrays as ref (or set ref), and translates
+    for(; l; l=l->next) {
+        if(l->calls.len || l->raster_op || l->raster || l->bitmaps || l->pushattribute || l->popattribute)
+            return false;
+        if(l->render_op || l->fog_op || l->pointparam_op || l->linestipple_op || l->polygon_mode)
+            return false;
+        if(l->material || l->colormat_face || l->light || l->lightmodel || l->texgen || l->texenv)
+            return false;
+        if(l->set_texture || l->set_tmu || l->post_color || l->post_normal || l->use_glstate || l->instanceCount!=1)
+            return false;
+        if(l->matrix_op && !istranslation_renderlist(l))
+            return false;
+        if(!l->len)
+            continue;
+        if(rendermode_dimensions(l->mode)!=3 || l->iindices || l->final_colors)
+            return false;
+        if(l->vert_stride || l->normal_stride || l->color_stride || l->secondary_stride || l->fogcoord_stride)
+            return false;
+        for(int a=0; a<l->maxtex; ++a)
+            if(l->tex_stride[a])
+                return false;
+        renderlist_t *r = *ref;
+        if(!r) {
+            *ref = l;
+            continue;
+        }
+        if(!l->vert!=!r->vert || !l->normal!=!r->normal || !l->color!=!r->color || !l->secondary!=!r->secondary || !l->fogcoord!=!r->fogcoord)
+            return false;
+        for(int a=0; a<MAX_TEX; ++a)
+            if(!(a<l->maxtex && l->tex[a])!=!(a<r->maxtex && r->tex[a]))
+                return false;
+    }
+    return true;
+}
+
+int batch_calllists(renderlist_t **lists, int n) {
+    // return the number of lists drawn from the start of lists, 0 if they are left to glCallList
+    if(!globals4es.mergelist || glstate->list.active || glstate->render_mode==GL_SELECT || glstate->matrix_mode!=GL_MODELVIEW)
+        return 0;
+    if(glstate->glsl->program || glstate->enable.vertex_arb)
+        return 0;   // the shader or the ARB vertex program may use the object coordinates
+    for(int a=0; a<hardext.maxtex; ++a)
+        if(glstate->enable.texgen_s[a] || glstate->enable.texgen_t[a] || glstate->enable.texgen_r[a] || glstate->enable.texgen_q[a])
+            return 0;
+    renderlist_t *ref = NULL;
+    int count, len = 0, draws = 0;
+    for(count=0; count<n; ++count) {
+        renderlist_t *r = ref;
+        if(lists[count] && !isglyph_renderlist(lists[count], &r))
+            break;
+        int l = 0, d = 0;
+        for(renderlist_t *p=lists[count]; p; p=p->next)
+            if(p->len) {
+                l += p->len;
+                ++d;
+            }
+        if(l>CALLLISTS_MAXVERTS || len+l>65535)
+            break;
+        ref = r;
+        len += l;
+        draws += d;
+    }
+    if(draws<2)
+        return 0;
+    renderlist_t *batch = alloc_renderlist();
+    batch->mode = batch->mode_init = GL_TRIANGLES;
+    batch->mode_dimension = 3;
+    batch->stage = STAGE_DRAW;
+    batch->cap = len;
+    if(ref->vert) batch->vert = alloc_sublist(4, len);
+    if(ref->normal) batch->normal = alloc_sublist(3, len);
+    if(ref->color) batch->color = alloc_sublist(4, len);
+    if(ref->secondary) batch->secondary = alloc_sublist(4, len);
+    if(ref->fogcoord) batch->fogcoord = alloc_sublist(1, len);
+    batch->maxtex = ref->maxtex;
+    for(int a=0; a<ref->maxtex; ++a)
+        if(ref->tex[a])
+            batch->tex[a] = alloc_sublist(4, len);
+    GLfloat t[3] = {0.f, 0.f, 0.f};
+    for(int i=0; i<count; ++i)
+        for(renderlist_t *l=lists[i]; l; l=l->next) {
+            // same order as draw_renderlist: the matrix first, then the draw
+            if(l->matrix_op) {
+                t[0] += l->matrix_val[12];
+                t[1] += l->matrix_val[13];
+                t[2] += l->matrix_val[14];
+            }
+            if(!l->len)
+                continue;
+            int first = batch->len;
+            append_renderlist(batch, l);
+            if(batch->vert)
+                for(int v=first; v<batch->len; ++v) {
+                    GLfloat *p = batch->vert+v*4;
+                    p[0] += t[0]*p[3];
+                    p[1] += t[1]*p[3];
+                    p[2] += t[2]*p[3];
+                }
+        }
+    draw_renderlist(batch);
+    free_renderlist(batch);
+    if(t[0]!=0.f || t[1]!=0.f || t[2]!=0.f) {
+        GLfloat m[16];
+        set_identity(m);
+        m[12] = t[0]; m[13] = t[1]; m[14] = t[2];
+        gl4es_glMultMatrixf(m);
+    }
+    return count;
+}
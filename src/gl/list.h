@@ -109,12 +109,19 @@ KHASH_MAP_DECLARE_INT(light, renderlight_t *);
 KHASH_MAP_DECLARE_INT(texgen, rendertexgen_t *);
 KHASH_MAP_DECLARE_INT(texenv, rendertexenv_t *);
 
+// recorded calls are stored back to back in one buffer, each one behind its entry size
 typedef struct _call_list_t {
-    unsigned long len;
-    unsigned long cap;
-    packed_call_t **calls;
+    unsigned long len;      // number of calls
+    unsigned long size;     // bytes used in data
+    unsigned long cap;      // bytes allocated for data
+    char *data;
 } call_list_t;
 
+#define CALL_HEAD           8   // entry header, keeps the packed calls 8 bytes aligned
+#define CALL_PACKED(p)      ((packed_call_t*)((char*)(p)+CALL_HEAD))
+#define CALL_SIZE(p)        (*(unsigned int*)(p))
+#define CALL_NEXT(p)        ((char*)(p)+CALL_SIZE(p))
+
 typedef struct {
 	GLsizei width;
 	GLsizei height;
@@ -137,6 +144,14 @@ typedef struct {
     int    ilen;
 } modeinit_t;
 
+// layout of one attribute in vbo_array, when it differs from the renderlist arrays
+typedef struct {
+    GLint       size;
+    GLenum      type;
+    GLboolean   normalized;
+    GLsizei     stride;
+} vboformat_t;
+
 typedef struct _renderlist_t {
     unsigned long len;
     unsigned long ilen;
@@ -173,6 +188,7 @@ typedef struct _renderlist_t {
     int      fogcoord_stride;
     int      tex_stride[MAX_TEX];
     GLuint   vbo_array;
+    vboformat_t *vbo_format;  // per ATT_xxx, NULL if vbo_array use the same layout as the arrays
     GLuint   vbo_indices;
     int      use_vbo_array;   // 0=Not evaluated, 1=No, 2=Yes
     int      use_vbo_indices; // same
@@ -184,6 +200,7 @@ typedef struct _renderlist_t {
     GLfloat *vbo_tex[MAX_TEX];
     int *shared_indices;
     GLushort *indices;
+    GLuint   *iindices;     // used instead of indices when the list has more than 65536 vertices (GL_OES_element_index_uint)
     unsigned int indice_cap;
     int maxtex;
     GLenum  merger_mode;
@@ -221,7 +238,7 @@ typedef struct _renderlist_t {
     int     post_normal;
     GLfloat post_normals[3];
 
-    GLushort    *ind_lines;
+    GLvoid      *ind_lines; // GLuint if the list needs 32bits indices, GLushort otherwise
     int         ind_line;
     GLfloat      *final_colors;
 
@@ -248,7 +265,7 @@ typedef struct _renderlist_t {
 
 KHASH_MAP_DECLARE_INT(gllisthead, renderlist_t*);
 
-#define DEFAULT_CALL_LIST_CAPACITY 20
+#define DEFAULT_CALL_LIST_CAPACITY 256     // in bytes
 #define DEFAULT_RENDER_LIST_CAPACITY 64
 
 int rendermode_dimensions(GLenum mode);
@@ -272,8 +289,12 @@ renderlist_t* GetFirst(renderlist_t* list);
 renderlist_t *alloc_renderlist();
 renderlist_t *extend_renderlist(renderlist_t *list);
 void free_renderlist(renderlist_t *list);
+void trim_renderlist_pool();
 void draw_renderlist(renderlist_t *list);
 renderlist_t* end_renderlist(renderlist_t *list);
+renderlist_t* optimize_renderlist(renderlist_t *list);
+void vcache_renderlist(renderlist_t *list);
+int batch_calllists(renderlist_t **lists, int n);
 bool isempty_renderlist(renderlist_t *list);
 void resize_renderlist(renderlist_t *list);
 renderlist_t *alloc_renderlist();
@@ -306,7 +327,8 @@ void rlTexEnvfv(renderlist_t *list, GLenum target, GLenum pname, const GLfloat *
 void rlTexEnviv(renderlist_t *list, GLenum target, GLenum pname, const GLint * params);
 void rlNormal3f(renderlist_t *list, GLfloat x, GLfloat y, GLfloat z) FASTMATH;
 void rlNormal3fv(renderlist_t *list, GLfloat* v) FASTMATH;
-void rlPushCall(renderlist_t *list, packed_call_t *data);
+void* rlAllocCall(renderlist_t *list, int size);
+void rlFreeCalls(call_list_t *cl);
 void rlMultiTexCoord4f(renderlist_t *list, GLenum texture, GLfloat s, GLfloat t, GLfloat r, GLfloat q) FASTMATH;
 void rlMultiTexCoord2fv(renderlist_t *list, GLenum texture, GLfloat* v) FASTMATH;
 void rlMultiTexCoord4fv(renderlist_t *list, GLenum texture, GLfloat* v) FASTMATH;
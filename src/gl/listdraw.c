@@ -9,17 +9,91 @@
 #include "matrix.h"
 #include "texgen.h"
 #include "render.h"
+#include "stats.h"
 #include "fpe.h"
 
-/* return 1 if failed, 2 if succeed */
 typedef struct array2vbo_s {
     uintptr_t   real_base;
     uint32_t    real_size;
+    uint32_t    size;       // size of 1 element
     uint32_t    stride;
     uintptr_t   vbo_base;
     uintptr_t   vbo_basebase;
+    int         att;
+    GLint       vsize;      // format in the VBO (vsize/type), the arrays are always float
+    GLenum      type;
 } array2vbo_t;
 
+// try to find a smaller format for an array, return 1 if found
+static int compact_array(array2vbo_t* w, int len) {
+    const char* p = (const char*)w->real_base;
+    if(w->att==ATT_VERTEX) {
+        // w is always 1?
+        for (int i=0; i<len; ++i, p+=w->stride)
+            if(((const GLfloat*)p)[3]!=1.0f)
+                return 0;
+        w->vsize = 3;
+        w->size = 3*sizeof(GLfloat);
+        return 1;
+    }
+    if(w->att==ATT_COLOR || w->att==ATT_SECONDARY) {
+        // only if going through unsigned byte doesn't change anything
+        for (int i=0; i<len; ++i, p+=w->stride)
+            for (int j=0; j<4; ++j) {
+                const GLfloat c = ((const GLfloat*)p)[j];
+                if(!(c>=0.0f && c<=1.0f) || ((GLfloat)(int)(c*255.0f+0.5f))/255.0f!=c)
+                    return 0;
+            }
+        w->type = GL_UNSIGNED_BYTE;
+        w->size = 4;
+        return 1;
+    }
+    if(w->att==ATT_NORMAL) {
+        if(globals4es.vbocompact<2)
+            return 0;
+        for (int i=0; i<len; ++i, p+=w->stride)
+            for (int j=0; j<3; ++j) {
+                const GLfloat c = ((const GLfloat*)p)[j];
+                if(!(c>=-1.0f && c<=1.0f))
+                    return 0;
+            }
+        w->type = GL_SHORT;
+        w->size = 4*sizeof(GLshort);    // padded to stay 4 bytes aligned
+        return 1;
+    }
+    if(w->att>=ATT_MULTITEXCOORD0 && w->att<ATT_MULTITEXCOORD0+MAX_TEX) {
+        // texcoords are often 2D, with r=0 and q=1
+        for (int i=0; i<len; ++i, p+=w->stride)
+            if(((const GLfloat*)p)[2]!=0.0f || ((const GLfloat*)p)[3]!=1.0f)
+                return 0;
+        w->vsize = 2;
+        w->size = 2*sizeof(GLfloat);
+        return 1;
+    }
+    return 0;
+}
+
+static void encode_array(array2vbo_t* w, char* dst, uint32_t stride, int len) {
+    const char* src = (const char*)w->real_base;
+    for (int i=0; i<len; ++i, src+=w->stride, dst+=stride) {
+        const GLfloat* f = (const GLfloat*)src;
+        switch(w->type) {
+            case GL_UNSIGNED_BYTE:
+                for (int j=0; j<4; ++j)
+                    ((GLubyte*)dst)[j] = (GLubyte)(f[j]*255.0f+0.5f);
+                break;
+            case GL_SHORT:
+                for (int j=0; j<3; ++j)
+                    ((GLshort*)dst)[j] = (GLshort)((f[j]<0.0f)?(f[j]*32767.0f-0.5f):(f[j]*32767.0f+0.5f));
+                ((GLshort*)dst)[3] = 0;
+                break;
+            default:
+                memcpy(dst, src, w->size);
+        }
+    }
+}
+
+/* return 1 if failed, 2 if succeed */
 int list2VBO(renderlist_t* list)
 {
     LOAD_GLES2(glGenBuffers);
@@ -31,89 +105,143 @@ int list2VBO(renderlist_t* list)
     int len = list->len;
     if(list->vert) {
         work[imax].real_base = (uintptr_t)list->vert;
+        work[imax].size = 4*4; // 4*GL_FLOAT
+        work[imax].att = ATT_VERTEX;
+        work[imax].vsize = 4;
+        work[imax].type = GL_FLOAT;
         work[imax].stride = list->vert_stride;
-        if(!work[imax].stride) work[imax].stride = 4*4; // 4*GL_FLOAT
+        if(!work[imax].stride) work[imax].stride = work[imax].size;
         work[imax].real_size = work[imax].stride*len;
         imax++;
     }
     if(list->color) {
         work[imax].real_base = (uintptr_t)list->color;
+        work[imax].size = 4*4; // 4*GL_FLOAT
+        work[imax].att = ATT_COLOR;
+        work[imax].vsize = 4;
+        work[imax].type = GL_FLOAT;
         work[imax].stride = list->color_stride;
-        if(!work[imax].stride) work[imax].stride = 4*4; // 4*GL_FLOAT
+        if(!work[imax].stride) work[imax].stride = work[imax].size;
         work[imax].real_size = work[imax].stride*len;
         imax++;
     }
     if(list->secondary) {
         work[imax].real_base = (uintptr_t)list->secondary;
+        work[imax].size = 4*4; // 4*GL_FLOAT
+        work[imax].att = ATT_SECONDARY;
+        work[imax].vsize = 4;
+        work[imax].type = GL_FLOAT;
         work[imax].stride = list->secondary_stride;
-        if(!work[imax].stride) work[imax].stride = 4*4; // 4*GL_FLOAT
+        if(!work[imax].stride) work[imax].stride = work[imax].size;
         work[imax].real_size = work[imax].stride*len;
         imax++;
     }
     if(list->fogcoord) {
         work[imax].real_base = (uintptr_t)list->fogcoord;
+        work[imax].size = 1*4; // 1*GL_FLOAT
+        work[imax].att = ATT_FOGCOORD;
+        work[imax].vsize = 1;
+        work[imax].type = GL_FLOAT;
         work[imax].stride = list->fogcoord_stride;
-        if(!work[imax].stride) work[imax].stride = 1*4; // 1*GL_FLOAT
+        if(!work[imax].stride) work[imax].stride = work[imax].size;
         work[imax].real_size = work[imax].stride*len;
         imax++;
     }
     if(list->normal) {
         work[imax].real_base = (uintptr_t)list->normal;
+        work[imax].size = 3*4; // 3*GL_FLOAT
+        work[imax].att = ATT_NORMAL;
+        work[imax].vsize = 3;
+        work[imax].type = GL_FLOAT;
         work[imax].stride = list->normal_stride;
-        if(!work[imax].stride) work[imax].stride = 3*4; // 3*GL_FLOAT
+        if(!work[imax].stride) work[imax].stride = work[imax].size;
         work[imax].real_size = work[imax].stride*len;
         imax++;
     }
     for (int a=0; a<list->maxtex; ++a) {
         if(list->tex[a]) {
             work[imax].real_base = (uintptr_t)list->tex[a];
+            work[imax].size = 4*4; // 4*GL_FLOAT
+            work[imax].att = ATT_MULTITEXCOORD0+a;
+            work[imax].vsize = 4;
+            work[imax].type = GL_FLOAT;
             work[imax].stride = list->tex_stride[a];
-            if(!work[imax].stride) work[imax].stride = 4*4; // 4*GL_FLOAT
+            if(!work[imax].stride) work[imax].stride = work[imax].size;
             work[imax].real_size = work[imax].stride*len;
             imax++;
         }
     }
-    // sort the real address...
-    int sorted[ATT_MAX];
-    for (int i=0; i<imax; ++i)
-        sorted[i] = i;
-    // bubble sort, array is small enough, and probably almost sorted
-    for (int i=0; i<imax-1; ++i)
-        for (int j=i+1; j<imax; ++j)
-            if(work[sorted[i]].real_base > work[sorted[j]].real_base) {
-                int tmp = sorted[i];
-                sorted[i] = sorted[j];
-                sorted[j] = tmp;
-            }
-    // get a base vbo offset
-    uintptr_t vbo_base = 0;
-    for (int i=0; i<imax; ++i) {
-        uintptr_t base = vbo_base;
-        uintptr_t basebase = vbo_base;
-        array2vbo_t *r = work+sorted[i];
-        if(i) for(int j=i-1; j<i; ++j) {
-            array2vbo_t *t = work+sorted[j];
-            if(r->real_base<t->real_base+t->real_size) {
-                base = r->vbo_base + (r->real_base - t->real_base);
-                basebase = r->vbo_basebase;
-                break;
+    int packed = (globals4es.vbointerleave && imax>1);
+    if(globals4es.vbocompact)
+        for (int i=0; i<imax; ++i)
+            if(compact_array(work+i, len))
+                packed = 1;
+    if(packed) {
+        // the arrays are converted to the VBO layout. Interleaved: all the attributes
+        // of a vertex are together, with a single stride. Else each array has its own region
+        uint32_t stride = 0;
+        for (int i=0; i<imax; ++i) {
+            work[i].vbo_base = globals4es.vbointerleave?stride:stride*len;
+            stride += work[i].size;
+        }
+        char* data = (char*)malloc(stride*len);
+        for (int i=0; i<imax; ++i)
+            encode_array(work+i, data+work[i].vbo_base, globals4es.vbointerleave?stride:work[i].size, len);
+        gles_glGenBuffers(1, &list->vbo_array);
+        bindBuffer(GL_ARRAY_BUFFER, list->vbo_array);
+        gles_glBufferData(GL_ARRAY_BUFFER, stride*len, data, GL_STATIC_DRAW);
+        free(data);
+        list->vbo_format = (vboformat_t*)calloc(ATT_MAX, sizeof(vboformat_t));
+        for (int i=0; i<imax; ++i) {
+            vboformat_t *fmt = list->vbo_format+work[i].att;
+            fmt->size = work[i].vsize;
+            fmt->type = work[i].type;
+            fmt->normalized = (work[i].type!=GL_FLOAT);
+            fmt->stride = globals4es.vbointerleave?stride:work[i].size;
+        }
+    } else {
+        // sort the real address...
+        int sorted[ATT_MAX];
+        for (int i=0; i<imax; ++i)
+            sorted[i] = i;
+        // bubble sort, array is small enough, and probably almost sorted
+        for (int i=0; i<imax-1; ++i)
+            for (int j=i+1; j<imax; ++j)
+                if(work[sorted[i]].real_base > work[sorted[j]].real_base) {
+                    int tmp = sorted[i];
+                    sorted[i] = sorted[j];
+                    sorted[j] = tmp;
+                }
+        // get a base vbo offset
+        uintptr_t vbo_base = 0;
+        for (int i=0; i<imax; ++i) {
+            uintptr_t base = vbo_base;
+            uintptr_t basebase = vbo_base;
+            array2vbo_t *r = work+sorted[i];
+            if(i) for(int j=i-1; j<i; ++j) {
+                array2vbo_t *t = work+sorted[j];
+                if(r->real_base<t->real_base+t->real_size) {
+                    base = r->vbo_base + (r->real_base - t->real_base);
+                    basebase = r->vbo_basebase;
+                    break;
+                }
             }
+            r->vbo_base = base;
+            r->vbo_basebase = basebase;
+            if(base == basebase)
+                vbo_base += r->real_size;
+        }
+        if(!vbo_base)   // no data?!
+            return 1;
+        // Create the VBO and fill the data
+        gles_glGenBuffers(1, &list->vbo_array);
+        bindBuffer(GL_ARRAY_BUFFER, list->vbo_array);
+        gles_glBufferData(GL_ARRAY_BUFFER, vbo_base, NULL, GL_STATIC_DRAW);
+        for(int i=0; i<imax; ++i) {
+            array2vbo_t *r = work+sorted[i];
+            if(r->vbo_base==r->vbo_basebase)
+                gles_glBufferSubData(GL_ARRAY_BUFFER, r->vbo_basebase, r->real_size, (void*)r->real_base);
         }
-        r->vbo_base = base;
-        r->vbo_basebase = basebase;
-        if(base == basebase)
-            vbo_base += r->real_size;
-    }
-    if(!vbo_base)   // no data?!
-        return 1;
-    // Create the VBO and fill the data
-    gles_glGenBuffers(1, &list->vbo_array);
-    bindBuffer(GL_ARRAY_BUFFER, list->vbo_array);
-    gles_glBufferData(GL_ARRAY_BUFFER, vbo_base, NULL, GL_STATIC_DRAW);
-    for(int i=0; i<imax; ++i) {
-        array2vbo_t *r = work+sorted[i];
-        if(r->vbo_base==r->vbo_basebase)
-            gles_glBufferSubData(GL_ARRAY_BUFFER, r->vbo_basebase, r->real_size, (void*)r->real_base);
     }
     // work -> list
     imax = 0;
@@ -150,57 +278,83 @@ typedef struct save_vbo_s {
     GLuint          real_buffer;
     const GLvoid*   real_pointer;
     glbuffer_t*     buffer;
+    vboformat_t     format;
 } save_vbo_t;
 
+static void save_vboformat(vboformat_t *fmt, vertexattrib_t *va) {
+    fmt->size = va->size;
+    fmt->type = va->type;
+    fmt->normalized = va->normalized;
+    fmt->stride = va->stride;
+}
+static void load_vboformat(vertexattrib_t *va, vboformat_t *fmt) {
+    va->size = fmt->size;
+    va->type = fmt->type;
+    va->normalized = fmt->normalized;
+    va->stride = fmt->stride;
+}
+
 void listActiveVBO(renderlist_t* list, save_vbo_t* saved) {
     if(list->vert) {
         saved[ATT_VERTEX].real_buffer = glstate->vao->vertexattrib[ATT_VERTEX].real_buffer;
         saved[ATT_VERTEX].real_pointer = glstate->vao->vertexattrib[ATT_VERTEX].real_pointer;
         saved[ATT_VERTEX].buffer = glstate->vao->vertexattrib[ATT_VERTEX].buffer;
+        save_vboformat(&saved[ATT_VERTEX].format, &glstate->vao->vertexattrib[ATT_VERTEX]);
         glstate->vao->vertexattrib[ATT_VERTEX].real_buffer = list->vbo_array;
         glstate->vao->vertexattrib[ATT_VERTEX].real_pointer = list->vbo_vert;
         glstate->vao->vertexattrib[ATT_VERTEX].buffer = NULL;
+        if(list->vbo_format) load_vboformat(&glstate->vao->vertexattrib[ATT_VERTEX], &list->vbo_format[ATT_VERTEX]);
     }
     if(list->color) {
         saved[ATT_COLOR].real_buffer = glstate->vao->vertexattrib[ATT_COLOR].real_buffer;
         saved[ATT_COLOR].real_pointer = glstate->vao->vertexattrib[ATT_COLOR].real_pointer;
         saved[ATT_COLOR].buffer = glstate->vao->vertexattrib[ATT_COLOR].buffer;
+        save_vboformat(&saved[ATT_COLOR].format, &glstate->vao->vertexattrib[ATT_COLOR]);
         glstate->vao->vertexattrib[ATT_COLOR].real_buffer = list->vbo_array;
         glstate->vao->vertexattrib[ATT_COLOR].real_pointer = list->vbo_color;
         glstate->vao->vertexattrib[ATT_COLOR].buffer = NULL;
+        if(list->vbo_format) load_vboformat(&glstate->vao->vertexattrib[ATT_COLOR], &list->vbo_format[ATT_COLOR]);
     }
     if(list->secondary) {
         saved[ATT_SECONDARY].real_buffer = glstate->vao->vertexattrib[ATT_SECONDARY].real_buffer;
         saved[ATT_SECONDARY].real_pointer = glstate->vao->vertexattrib[ATT_SECONDARY].real_pointer;
         saved[ATT_SECONDARY].buffer = glstate->vao->vertexattrib[ATT_SECONDARY].buffer;
+        save_vboformat(&saved[ATT_SECONDARY].format, &glstate->vao->vertexattrib[ATT_SECONDARY]);
         glstate->vao->vertexattrib[ATT_SECONDARY].real_buffer = list->vbo_array;
         glstate->vao->vertexattrib[ATT_SECONDARY].real_pointer = list->vbo_secondary;
         glstate->vao->vertexattrib[ATT_SECONDARY].buffer = NULL;
+        if(list->vbo_format) load_vboformat(&glstate->vao->vertexattrib[ATT_SECONDARY], &list->vbo_format[ATT_SECONDARY]);
     }
     if(list->fogcoord) {
         saved[ATT_FOGCOORD].real_buffer = glstate->vao->vertexattrib[ATT_FOGCOORD].real_buffer;
         saved[ATT_FOGCOORD].real_pointer = glstate->vao->vertexattrib[ATT_FOGCOORD].real_pointer;
         saved[ATT_FOGCOORD].buffer = glstate->vao->vertexattrib[ATT_FOGCOORD].buffer;
+        save_vboformat(&saved[ATT_FOGCOORD].format, &glstate->vao->vertexattrib[ATT_FOGCOORD]);
         glstate->vao->vertexattrib[ATT_FOGCOORD].real_buffer = list->vbo_array;
         glstate->vao->vertexattrib[ATT_FOGCOORD].real_pointer = list->vbo_fogcoord;
         glstate->vao->vertexattrib[ATT_FOGCOORD].buffer = NULL;
+        if(list->vbo_format) load_vboformat(&glstate->vao->vertexattrib[ATT_FOGCOORD], &list->vbo_format[ATT_FOGCOORD]);
     }
     if(list->normal) {
         saved[ATT_NORMAL].real_buffer = glstate->vao->vertexattrib[ATT_NORMAL].real_buffer;
         saved[ATT_NORMAL].real_pointer = glstate->vao->vertexattrib[ATT_NORMAL].real_pointer;
         saved[ATT_NORMAL].buffer = glstate->vao->vertexattrib[ATT_NORMAL].buffer;
+        save_vboformat(&saved[ATT_NORMAL].format, &glstate->vao->vertexattrib[ATT_NORMAL]);
         glstate->vao->vertexattrib[ATT_NORMAL].real_buffer = list->vbo_array;
         glstate->vao->vertexattrib[ATT_NORMAL].real_pointer = list->vbo_normal;
         glstate->vao->vertexattrib[ATT_NORMAL].buffer = NULL;
+        if(list->vbo_format) load_vboformat(&glstate->vao->vertexattrib[ATT_NORMAL], &list->vbo_format[ATT_NORMAL]);
     }
     for (int a=0; a<list->maxtex; ++a) {
         if(list->tex[a]) {
             saved[ATT_MULTITEXCOORD0+a].real_buffer = glstate->vao->vertexattrib[ATT_MULTITEXCOORD0+a].real_buffer;
             saved[ATT_MULTITEXCOORD0+a].real_pointer = glstate->vao->vertexattrib[ATT_MULTITEXCOORD0+a].real_pointer;
             saved[ATT_MULTITEXCOORD0+a].buffer = glstate->vao->vertexattrib[ATT_MULTITEXCOORD0+a].buffer;
+            save_vboformat(&saved[ATT_MULTITEXCOORD0+a].format, &glstate->vao->vertexattrib[ATT_MULTITEXCOORD0+a]);
             glstate->vao->vertexattrib[ATT_MULTITEXCOORD0+a].real_buffer = list->vbo_array;
             glstate->vao->vertexattrib[ATT_MULTITEXCOORD0+a].real_pointer = list->vbo_tex[a];
             glstate->vao->vertexattrib[ATT_MULTITEXCOORD0+a].buffer = NULL;
+            if(list->vbo_format) load_vboformat(&glstate->vao->vertexattrib[ATT_MULTITEXCOORD0+a], &list->vbo_format[ATT_MULTITEXCOORD0+a]);
         }
     }
 }
@@ -209,39 +363,46 @@ void listInactiveVBO(renderlist_t* list, save_vbo_t* saved) {
         glstate->vao->vertexattrib[ATT_VERTEX].real_buffer = saved[ATT_VERTEX].real_buffer;
         glstate->vao->vertexattrib[ATT_VERTEX].real_pointer = saved[ATT_VERTEX].real_pointer;
         glstate->vao->vertexattrib[ATT_VERTEX].buffer = saved[ATT_VERTEX].buffer;
+        load_vboformat(&glstate->vao->vertexattrib[ATT_VERTEX], &saved[ATT_VERTEX].format);
     }
     if(list->color) {
         glstate->vao->vertexattrib[ATT_COLOR].real_buffer = saved[ATT_COLOR].real_buffer;
         glstate->vao->vertexattrib[ATT_COLOR].real_pointer = saved[ATT_COLOR].real_pointer;
         glstate->vao->vertexattrib[ATT_COLOR].buffer = saved[ATT_COLOR].buffer;
+        load_vboformat(&glstate->vao->vertexattrib[ATT_COLOR], &saved[ATT_COLOR].format);
     }
     if(list->secondary) {
         glstate->vao->vertexattrib[ATT_SECONDARY].real_buffer = saved[ATT_SECONDARY].real_buffer;
         glstate->vao->vertexattrib[ATT_SECONDARY].real_pointer = saved[ATT_SECONDARY].real_pointer;
         glstate->vao->vertexattrib[ATT_SECONDARY].buffer = saved[ATT_SECONDARY].buffer;
+        load_vboformat(&glstate->vao->vertexattrib[ATT_SECONDARY], &saved[ATT_SECONDARY].format);
     }
     if(list->fogcoord) {
         glstate->vao->vertexattrib[ATT_FOGCOORD].real_buffer = saved[ATT_FOGCOORD].real_buffer;
         glstate->vao->vertexattrib[ATT_FOGCOORD].real_pointer = saved[ATT_FOGCOORD].real_pointer;
         glstate->vao->vertexattrib[ATT_FOGCOORD].buffer = saved[ATT_FOGCOORD].buffer;
+        load_vboformat(&glstate->vao->vertexattrib[ATT_FOGCOORD], &saved[ATT_FOGCOORD].format);
     }
     if(list->normal) {
         glstate->vao->vertexattrib[ATT_NORMAL].real_buffer = saved[ATT_NORMAL].real_buffer;
         glstate->vao->vertexattrib[ATT_NORMAL].real_pointer = saved[ATT_NORMAL].real_pointer;
         glstate->vao->vertexattrib[ATT_NORMAL].buffer = saved[ATT_NORMAL].buffer;
+        load_vboformat(&glstate->vao->vertexattrib[ATT_NORMAL], &saved[ATT_NORMAL].format);
     }
     for (int a=0; a<list->maxtex; ++a) {
         if(list->tex[a]) {
             glstate->vao->vertexattrib[ATT_MULTITEXCOORD0+a].real_buffer = saved[ATT_MULTITEXCOORD0+a].real_buffer;
             glstate->vao->vertexattrib[ATT_MULTITEXCOORD0+a].real_pointer = saved[ATT_MULTITEXCOORD0+a].real_pointer;
             glstate->vao->vertexattrib[ATT_MULTITEXCOORD0+a].buffer = saved[ATT_MULTITEXCOORD0+a].buffer;
+            load_vboformat(&glstate->vao->vertexattrib[ATT_MULTITEXCOORD0+a], &saved[ATT_MULTITEXCOORD0+a].format);
         }
     }
 }
 
-int fill_lineIndices(modeinit_t *modes, int length, GLenum mode, GLushort* indices, GLushort *ind_line)
+int fill_lineIndices(modeinit_t *modes, int length, GLenum mode, GLushort* indices, GLuint* iindices, GLvoid *ind_line, int wide)
 {
-    #define ind(a)  indices?indices[a]:(a)
+    #define ind(a)  (indices?indices[a]:(iindices?iindices[a]:(a)))
+    #define put(a)  do { if(wide) ((GLuint*)ind_line)[k++] = (a); else ((GLushort*)ind_line)[k++] = (a); } while(0)
     int k=0;
     int i=0;
     for (int m=0; m<length; m++) {
@@ -251,11 +412,11 @@ int fill_lineIndices(modeinit_t *modes, int length, GLenum mode, GLushort* indic
             case GL_TRIANGLE_STRIP:
                 // first 3 points a triangle, then a 2 lines per new point
                 if (len>2) {
-                    ind_line[k++] = ind(i+0); ind_line[k++] = ind(i+1);
+                    put(ind(i+0)); put(ind(i+1));
                     i+=2;
                     for (; i<len; i++) {
-                        ind_line[k++] = ind(i-2); ind_line[k++] = ind(i);
-                        ind_line[k++] = ind(i-1); ind_line[k++] = ind(i);
+                        put(ind(i-2)); put(ind(i));
+                        put(ind(i-1)); put(ind(i));
                     }
                 }
                 break;
@@ -263,33 +424,33 @@ int fill_lineIndices(modeinit_t *modes, int length, GLenum mode, GLushort* indic
                 if(mode_init==GL_QUAD_STRIP) {
                     // first 4 points is a quad, then 2 points per new quad
                     if (len>3) {
-                        ind_line[k++] = ind(i+0); ind_line[k++] = ind(i+1);
+                        put(ind(i+0)); put(ind(i+1));
                         i+=2;
                         for (; i<len-1; i+=2) {
-                            ind_line[k++] = ind(i-1); ind_line[k++] = ind(i);
-                            ind_line[k++] = ind(i-2); ind_line[k++] = ind(i+1);
-                            ind_line[k++] = ind(i+0); ind_line[k++] = ind(i+1);
+                            put(ind(i-1)); put(ind(i));
+                            put(ind(i-2)); put(ind(i+1));
+                            put(ind(i+0)); put(ind(i+1));
                         }
                     }
                 } else if(mode_init==GL_POLYGON) {
                     if (len) {
                         int z = i;
-                        ind_line[k++] = ind(i+0); ind_line[k++] = ind(i+1);
+                        put(ind(i+0)); put(ind(i+1));
                         ++i;
                         for (; i<len; i++) {
-                            ind_line[k++] = ind(i-1); ind_line[k++] = ind(i);
+                            put(ind(i-1)); put(ind(i));
                         }
-                        ind_line[k++] = ind(len-1); ind_line[k++] = ind(z);
+                        put(ind(len-1)); put(ind(z));
                     }
                 } else {
                     // first 3 points a triangle, then a 2 lines per new point too
                     if (len>2) {
                         int z = i;
-                        ind_line[k++] = ind(i+0); ind_line[k++] = ind(i+1);
+                        put(ind(i+0)); put(ind(i+1));
                         i+=2;
                         for (; i<len; i++) {
-                            ind_line[k++] = ind(z); ind_line[k++] = ind(i);
-                            ind_line[k++] = ind(i-1); ind_line[k++] = ind(i);
+                            put(ind(z)); put(ind(i));
+                            put(ind(i-1)); put(ind(i));
                         }
                     }
                 }
@@ -302,9 +463,9 @@ int fill_lineIndices(modeinit_t *modes, int length, GLenum mode, GLushort* indic
                     if(len>2) {
                         // 1 triangle -> 3 lines => 6 half-lines !
                         for (; i<len-2; i+=3) {
-                            ind_line[k++] = ind(i+0); ind_line[k++] = ind(i+1);
-                            ind_line[k++] = ind(i+1); ind_line[k++] = ind(i+2);
-                            ind_line[k++] = ind(i+2); ind_line[k++] = ind(i+0);
+                            put(ind(i+0)); put(ind(i+1));
+                            put(ind(i+1)); put(ind(i+2));
+                            put(ind(i+2)); put(ind(i+0));
                         }
                     }
                     break;
@@ -314,15 +475,15 @@ int fill_lineIndices(modeinit_t *modes, int length, GLenum mode, GLushort* indic
                         if (len==4) {
                             // just 1 Quad
                             for (; i<4; i++) {
-                                ind_line[k++] = ind(i+0); ind_line[k++] = ind((i+1)%4);
+                                put(ind(i+0)); put(ind((i+1)%4));
                             }
                         } else {
                             // list of triangles, 2 per quads...
                             for (; i<len-5; i+=6) {
-                                ind_line[k++] = ind(i+0); ind_line[k++] = ind(i+1);
-                                ind_line[k++] = ind(i+1); ind_line[k++] = ind(i+2);
-                                ind_line[k++] = ind(i+2); ind_line[k++] = ind(i+5);
-                                ind_line[k++] = ind(i+5); ind_line[k++] = ind(i+0);
+                                put(ind(i+0)); put(ind(i+1));
+                                put(ind(i+1)); put(ind(i+2));
+                                put(ind(i+2)); put(ind(i+5));
+                                put(ind(i+5)); put(ind(i+0));
                             }
                         }
                     }
@@ -330,12 +491,12 @@ int fill_lineIndices(modeinit_t *modes, int length, GLenum mode, GLushort* indic
                 case GL_QUAD_STRIP:
                     // first 4 points is a quad, then 2 points per new quad
                     if (len>3) {
-                        ind_line[k++] = ind(i+0); ind_line[k++] = ind(i+1);
+                        put(ind(i+0)); put(ind(i+1));
                         i+=2;
                         for (; i<len-1; i+=2) {
-                            ind_line[k++] = ind(i-1); ind_line[k++] = ind(i);
-                            ind_line[k++] = ind(i-2); ind_line[k++] = ind(i+1);
-                            ind_line[k++] = ind(i+0); ind_line[k++] = ind(i+1);
+                            put(ind(i-1)); put(ind(i));
+                            put(ind(i-2)); put(ind(i+1));
+                            put(ind(i+0)); put(ind(i+1));
                         }
                     }
                     break;
@@ -343,18 +504,19 @@ int fill_lineIndices(modeinit_t *modes, int length, GLenum mode, GLushort* indic
                     // if polygons have been merged, then info is lost...
                     if (len) {
                         int z = i;
-                        ind_line[k++] = ind(i+0); ind_line[k++] = ind(i+1);
+                        put(ind(i+0)); put(ind(i+1));
                         ++i;
                         for (; i<len; i++) {
-                            ind_line[k++] = ind(i-1); ind_line[k++] = ind(i);
+                            put(ind(i-1)); put(ind(i));
                         }
-                        ind_line[k++] = ind(len-1); ind_line[k++] = ind(z);
+                        put(ind(len-1)); put(ind(z));
                     }
                     break;
             }
             break;
         }
     }
+    #undef put
     #undef ind
     return k;
 }
@@ -377,6 +539,7 @@ void draw_renderlist(renderlist_t *list) {
 
 	int old_tex;
     GLushort *indices;
+    GLuint *iindices;
     int use_texgen[MAX_TEX] = {0};
     old_tex = glstate->texture.client;
     GLuint cur_tex = old_tex;
@@ -401,11 +564,8 @@ void draw_renderlist(renderlist_t *list) {
         if (list->popattribute)
             gl4es_glPopAttrib();
         call_list_t *cl = &list->calls;
-        if (cl->len > 0) {
-            for (int i = 0; i < cl->len; i++) {
-                glPackedCall(cl->calls[i]);
-            }
-        }
+        for (char *p = cl->data, *end = cl->data + cl->size; p < end; p = CALL_NEXT(p))
+            glPackedCall(CALL_PACKED(p));
         if(list->render_op) {
             switch(list->render_op) {
                 case 1: gl4es_glInitNames(); break;
@@ -544,6 +704,7 @@ void draw_renderlist(renderlist_t *list) {
         }
     
         indices = list->indices;
+        iindices = list->iindices;
 
         if(glstate->raster.bm_drawing)
             bitmap_flush();
@@ -627,7 +788,7 @@ void draw_renderlist(renderlist_t *list) {
             gl4es_glAlphaFunc(GL_GREATER, 0.0f);
             bind_stipple_tex();
             modeinit_t tmp; tmp.mode_init = list->mode_init; tmp.ilen=list->ilen?list->ilen:list->len;
-            list->tex[stipple_tmu] = gen_stipple_tex_coords(list->vert, list->indices, list->mode_inits?list->mode_inits:&tmp, list->vert_stride, list->mode_inits?list->mode_init_len:1, (list->use_glstate)?(list->vert+8+stipple_tmu*4):NULL);
+            list->tex[stipple_tmu] = gen_stipple_tex_coords(list->vert, list->indices, list->iindices, list->mode_inits?list->mode_inits:&tmp, list->vert_stride, list->mode_inits?list->mode_init_len:1, (list->use_glstate)?(list->vert+8+stipple_tmu*4):NULL);
         }
         #define RS(A, len) if(glstate->texgenedsz[A]<len) {free(glstate->texgened[A]); glstate->texgened[A]=malloc(4*sizeof(GLfloat)*len); glstate->texgenedsz[A]=len; } use_texgen[A]=1
         // cannot use list->maxtex because some TMU can be using TexGen or point sprites...
@@ -727,7 +888,7 @@ void draw_renderlist(renderlist_t *list) {
 		if ((glstate->polygon_mode == GL_POINT) && (mode>=GL_TRIANGLES))
 			mode = GL_POINTS;
 
-        if (indices) {
+        if (indices || iindices) {
             if (glstate->render_mode == GL_SELECT) {
                 vertexattrib_t vtx = {0};
                 vtx.pointer = list->vert;
@@ -735,20 +896,21 @@ void draw_renderlist(renderlist_t *list) {
                 vtx.normalized = GL_FALSE;
                 vtx.size = 4;
                 vtx.stride = 0;
-                select_glDrawElements(&vtx, list->mode, list->ilen, GL_UNSIGNED_SHORT, indices);
+                select_glDrawElements(&vtx, list->mode, list->ilen, iindices?GL_UNSIGNED_INT:GL_UNSIGNED_SHORT, iindices?(GLvoid*)iindices:(GLvoid*)indices);
                 use_vbo_indices = 1;
             } else {
                 GLuint old_index = wantBufferIndex(0);
                 if (glstate->polygon_mode == GL_LINE && list->mode_init>=GL_TRIANGLES) {
                     int ilen = list->ilen;
                     if(!list->ind_lines) {
-                        GLushort *ind_line = list->ind_lines = (GLushort*)malloc(sizeof(GLushort)*ilen*4+2);
+                        list->ind_lines = malloc((iindices?sizeof(GLuint):sizeof(GLushort))*ilen*4+2);
                         modeinit_t tmp; tmp.mode_init = list->mode_init; tmp.ilen=list->ilen;
-                        int k = fill_lineIndices(list->mode_inits?list->mode_inits:&tmp, list->mode_inits?list->mode_init_len:1, list->mode, indices, list->ind_lines);
+                        int k = fill_lineIndices(list->mode_inits?list->mode_inits:&tmp, list->mode_inits?list->mode_init_len:1, list->mode, indices, iindices, list->ind_lines, iindices!=NULL);
                         list->ind_line = k;
                     }
                     bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-                    gles_glDrawElements(mode, list->ind_line, GL_UNSIGNED_SHORT, list->ind_lines);
+                    gles_glDrawElements(mode, list->ind_line, iindices?GL_UNSIGNED_INT:GL_UNSIGNED_SHORT, list->ind_lines);
+                    STATS_INC(draws);
                     use_vbo_indices = 1;
                 } else {
                     int vbo_indices = 0;
@@ -758,19 +920,29 @@ void draw_renderlist(renderlist_t *list) {
                         LOAD_GLES2(glBufferData);
                         gles_glGenBuffers(1, &list->vbo_indices);
                         bindBuffer(GL_ELEMENT_ARRAY_BUFFER, list->vbo_indices);
-                        gles_glBufferData(GL_ELEMENT_ARRAY_BUFFER, list->ilen*sizeof(GLushort), indices, GL_STATIC_DRAW);
+                        if(iindices)
+                            gles_glBufferData(GL_ELEMENT_ARRAY_BUFFER, list->ilen*sizeof(GLuint), iindices, GL_STATIC_DRAW);
+                        else
+                            gles_glBufferData(GL_ELEMENT_ARRAY_BUFFER, list->ilen*sizeof(GLushort), indices, GL_STATIC_DRAW);
                         use_vbo_indices = 2;
                         vbo_indices = 1;
                     } else if(use_vbo_indices==2) {
                         bindBuffer(GL_ELEMENT_ARRAY_BUFFER, list->vbo_indices);
                         vbo_indices = 1;
-                    } else
+                    } else {
+                        // non-indexed GL_QUADS end up with the canonical indices, that are already in a VBO
+                        if(indices)
+                            indices = (GLushort*)gl4es_match_quad_indices(indices, list->ilen);
                         realize_bufferIndex();
+                    }
+                    GLenum itype = iindices?GL_UNSIGNED_INT:GL_UNSIGNED_SHORT;
+                    GLvoid *iptr = vbo_indices?NULL:(iindices?(GLvoid*)iindices:(GLvoid*)indices);
+                    STATS_ADD(draws, list->instanceCount);
                     if(list->instanceCount==1)
-                        gles_glDrawElements(mode, list->ilen, GL_UNSIGNED_SHORT, vbo_indices?NULL:indices);
+                        gles_glDrawElements(mode, list->ilen, itype, iptr);
                     else {
                         for (glstate->instanceID=0; glstate->instanceID<list->instanceCount; ++glstate->instanceID)
-                            gles_glDrawElements(mode, list->ilen, GL_UNSIGNED_SHORT, vbo_indices?NULL:indices);
+                            gles_glDrawElements(mode, list->ilen, itype, iptr);
                         glstate->instanceID = 0;
                     }
                 }
@@ -788,15 +960,18 @@ void draw_renderlist(renderlist_t *list) {
             } else {
                 int len = list->len;
                 if ((glstate->polygon_mode == GL_LINE) && (list->mode_init>=GL_TRIANGLES)) {
+                    int wide = (len>65536 && hardext.elementuint);
                     if(!list->ind_lines) {
-                        GLushort *ind_line = list->ind_lines = (GLushort*)malloc(sizeof(GLushort)*len*4+2);
+                        list->ind_lines = malloc((wide?sizeof(GLuint):sizeof(GLushort))*len*4+2);
                         modeinit_t tmp; tmp.mode_init = list->mode_init; tmp.ilen=len;
-                        int k = fill_lineIndices(list->mode_inits?list->mode_inits:&tmp, list->mode_inits?list->mode_init_len:1, list->mode, NULL, list->ind_lines);
+                        int k = fill_lineIndices(list->mode_inits?list->mode_inits:&tmp, list->mode_inits?list->mode_init_len:1, list->mode, NULL, NULL, list->ind_lines, wide);
                         list->ind_line = k;
                     }
                     bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-					gles_glDrawElements(mode, list->ind_line, GL_UNSIGNED_SHORT, list->ind_lines);
+					gles_glDrawElements(mode, list->ind_line, wide?GL_UNSIGNED_INT:GL_UNSIGNED_SHORT, list->ind_lines);
+                    STATS_INC(draws);
                 } else {
+                    STATS_ADD(draws, list->instanceCount);
                     if(list->instanceCount==1)
                         gles_glDrawArrays(mode, 0, len);
                     else {
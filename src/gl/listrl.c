@@ -60,80 +60,83 @@ void rlEnd(renderlist_t *list) {
     //printf("rlEnd(%d), indices=%p, mode_init_len=%d, len/cur_istart(adj)/ilen=%d/%d(%d)/%d, mode/mode_init=%s/%s, merger_mode=%s\n", list, list->indices, list->mode_init_len, list->len, list->cur_istart, adj, list->ilen, PrintEnum(list->mode), PrintEnum(list->mode_init), list->merger_mode?PrintEnum(list->merger_mode):"none");
     list->len -= adj;
     if(!list->mode_inits && list->cur_istart) list_add_modeinit(list, list->mode_init);
-    if(list->indices && list->merger_mode && list->len-list->cur_istart) {
+    if((list->indices || list->iindices) && list->merger_mode && list->len-list->cur_istart) {
         // also feed the indices...
         int istart = list->cur_istart;
         int ivert = 0;
         int len = list->len-istart;
+        // may switch the list to 32bits indices
         resize_indices_renderlist(list, indices_getindicesize(list->merger_mode, len));
+        #define PUSH(A) do { if(list->iindices) list->iindices[list->ilen++]=(A); else list->indices[list->ilen++]=(A); } while(0)
         switch (list->merger_mode) {
             case GL_LINE_STRIP:
                 if(len>1) {
-                    list->indices[list->ilen++]=istart+(ivert);
-                    list->indices[list->ilen++]=istart+(++ivert);
+                    PUSH(istart+(ivert));
+                    PUSH(istart+(++ivert));
                     for (int i=2; i<len; i++) {
-                        list->indices[list->ilen++]=istart+(ivert);
-                        list->indices[list->ilen++]=istart+(++ivert);
+                        PUSH(istart+(ivert));
+                        PUSH(istart+(++ivert));
                     }
                 }
                 break;
             case GL_LINE_LOOP:
                 if(len>1) {
-                    list->indices[list->ilen++]=istart+(ivert++);
-                    list->indices[list->ilen++]=istart+(ivert++);
+                    PUSH(istart+(ivert++));
+                    PUSH(istart+(ivert++));
                     for (int i=istart+2; i<list->len; i++) {
-                        list->indices[list->ilen++]=istart+(ivert-1);
-                        list->indices[list->ilen++]=istart+(ivert++);
+                        PUSH(istart+(ivert-1));
+                        PUSH(istart+(ivert++));
                     }
-                    list->indices[list->ilen++]=istart+(ivert-1);
-                    list->indices[list->ilen++]=istart;
+                    PUSH(istart+(ivert-1));
+                    PUSH(istart);
                 }
                 break;
             case GL_POLYGON:
             case GL_TRIANGLE_FAN:
                 if(len>2) {
-                    list->indices[list->ilen++]=istart+(ivert++);
-                    list->indices[list->ilen++]=istart+(ivert++);
-                    list->indices[list->ilen++]=istart+(ivert++);
+                    PUSH(istart+(ivert++));
+                    PUSH(istart+(ivert++));
+                    PUSH(istart+(ivert++));
                 }
                 for (int i=istart+3; i<list->len; i++) {
                         // add a new triangle for each new point
-                        list->indices[list->ilen++]=istart;
-                        list->indices[list->ilen++]=istart+(ivert-1);
-                        list->indices[list->ilen++]=istart+(ivert++);
+                        PUSH(istart);
+                        PUSH(istart+(ivert-1));
+                        PUSH(istart+(ivert++));
                     }
                 break;
             case GL_QUAD_STRIP:
             case GL_TRIANGLE_STRIP:
                 if(len>2) {
-                    list->indices[list->ilen++]=istart+(ivert++);
-                    list->indices[list->ilen++]=istart+(ivert++);
-                    list->indices[list->ilen++]=istart+(ivert++);
+                    PUSH(istart+(ivert++));
+                    PUSH(istart+(ivert++));
+                    PUSH(istart+(ivert++));
                 }
                 for (int i=istart+3; i<list->len; i++) {
                         // add a new triangle for each new point
-                        list->indices[list->ilen++]=istart+(ivert-((ivert%2)?1:2));
-                        list->indices[list->ilen++]=istart+(ivert-((ivert%2)?2:1));
-                        list->indices[list->ilen++]=istart+(ivert++);
+                        PUSH(istart+(ivert-((ivert%2)?1:2)));
+                        PUSH(istart+(ivert-((ivert%2)?2:1)));
+                        PUSH(istart+(ivert++));
                     }
                 break;
             case GL_QUADS:
                 if(len>3)
                 for (int i=istart; i+3<list->len; i+=4) {
-                    list->indices[list->ilen++]=i+0;
-                    list->indices[list->ilen++]=i+1;
-                    list->indices[list->ilen++]=i+2;
+                    PUSH(i+0);
+                    PUSH(i+1);
+                    PUSH(i+2);
 
-                    list->indices[list->ilen++]=i+0;
-                    list->indices[list->ilen++]=i+2;
-                    list->indices[list->ilen++]=i+3;
+                    PUSH(i+0);
+                    PUSH(i+2);
+                    PUSH(i+3);
                 }
                 break;
             default:
                 for (int i=istart; i<list->len; i++)
-                    list->indices[list->ilen++]=i;
+                    PUSH(i);
                 break;
         }
+        #undef PUSH
     }
     list->cur_istart = 0;
     if(list->mode_inits) list_add_modeinit(list, list->merger_mode?list->merger_mode:list->mode_init);
@@ -413,16 +416,28 @@ void rlPointParamOp(renderlist_t *list, int op, const GLfloat* v) {
     list->pointparam_val[3] = v[3];
 }
 
-void rlPushCall(renderlist_t *list, packed_call_t *data) {
+void* rlAllocCall(renderlist_t *list, int size) {
     call_list_t *cl = &list->calls;
-    if (!cl->calls) {
+    unsigned int entry = (CALL_HEAD + size + 7) & ~7;
+    if (!cl->data) {
         cl->cap = DEFAULT_CALL_LIST_CAPACITY;
-        cl->calls = malloc(DEFAULT_CALL_LIST_CAPACITY * sizeof(void*));
-    } else if (list->calls.len == list->calls.cap) {
-        cl->cap += DEFAULT_CALL_LIST_CAPACITY;
-        cl->calls = realloc(cl->calls, cl->cap * sizeof(void*));
+        cl->data = malloc(cl->cap);
     }
-    cl->calls[cl->len++] = data;
+    if (cl->size + entry > cl->cap) {
+        while (cl->size + entry > cl->cap)
+            cl->cap <<= 1;
+        cl->data = realloc(cl->data, cl->cap);
+    }
+    char *p = cl->data + cl->size;
+    CALL_SIZE(p) = entry;
+    cl->size += entry;
+    cl->len++;
+    return CALL_PACKED(p);
+}
+
+void rlFreeCalls(call_list_t *cl) {
+    free(cl->data);
+    memset(cl, 0, sizeof(call_list_t));
 }
 
 renderlist_t* GetFirst(renderlist_t* list) {
@@ -488,16 +503,25 @@ void rlTexEnviv(renderlist_t *list, GLenum target, GLenum pname, const GLint * p
 #undef realloc_sublist
 
 renderlist_t* NewDrawStage(renderlist_t* l, GLenum m) {
+    if(glstate->batch2d.len && glstate->list.pending && l->stage==STAGE_POSTDRAW && !l->len && !l->prev) {
+        // empty block left pending by the 2D batcher, it can take any primitive
+        l = recycle_renderlist(l, m);
+        l->mode_dimension = rendermode_dimensions(m);
+        return l;
+    }
     if(globals4es.mergelist && !glstate->polygon_mode
         && ((isempty_renderlist(l) && l->prev && l->prev->open && l->prev->mode==m && l->prev->mode_init==m)
             || (l->stage==STAGE_POSTDRAW && l->open))
-        && ((l->mode_dimension==rendermode_dimensions(m) && l->mode_dimension>0)))
+        && ((l->mode_dimension==rendermode_dimensions(m) && l->mode_dimension>0))
+        && l->len<60000)    // keep merged batches within 16bits indices
     {
         return recycle_renderlist(l, m);
     } else {
         // if we are just in glBegin/glEnd merger, then purge the list...
         if(!glstate->list.compiling && glstate->list.pending) {
             glstate->list.active = NULL;
+            glstate->list.pending = 0;
+            batch2d_flush();    // the deferred blocks were issued first
             l = end_renderlist(l);
             draw_renderlist(l);
             free_renderlist(l);
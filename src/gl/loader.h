@@ -245,7 +245,7 @@ EXPORT extern void *egl;
     DEFINE_RAW(gles, name); \
     { \
         LOAD_EGL(eglGetProcAddress); \
-        LOAD_RAW_SILENT(gles, name, ((hardext.esversion==1)?((void*)egl_eglGetProcAddress(#name"OES")):((void*)dlsym(gles, #name)))); \
+        LOAD_RAW_SILENT(gles, name, ((hardext.esversion==1)?((void*)egl_eglGetProcAddress(#name"OES")):((void*)proc_address(gles, #name)))); \
     }
 #endif // defined(AMIGAOS4) || defined(NOEGL)
 
@@ -15,10 +15,15 @@
 #define DBG(a)
 #endif
 
+// generations are unique amongst all the stacks (and contexts)
+static uint64_t matrix_generation = 0;
+
 void alloc_matrix(matrixstack_t **matrixstack, int depth) {
 	*matrixstack = (matrixstack_t*)malloc(sizeof(matrixstack_t));
 	(*matrixstack)->top = 0;
 	(*matrixstack)->identity = 0;
+	(*matrixstack)->gen = ++matrix_generation;
+	(*matrixstack)->inv_gen = 0;
 	(*matrixstack)->stack = (GLfloat*)malloc(sizeof(GLfloat)*depth*16);
 }
 
@@ -39,6 +44,21 @@ static GLfloat* update_current_mat() {
 	}
 }
 
+static matrixstack_t* current_stack() {
+	switch(glstate->matrix_mode) {
+		case GL_MODELVIEW:
+			return glstate->modelview_matrix;
+		case GL_PROJECTION:
+			return glstate->projection_matrix;
+		case GL_TEXTURE:
+			return glstate->texture_matrix[glstate->texture.active];
+		default:
+			if(glstate->matrix_mode>=GL_MATRIX0_ARB && glstate->matrix_mode<GL_MATRIX0_ARB+MAX_ARB_MATRIX)
+				return glstate->arb_matrix[glstate->matrix_mode-GL_MATRIX0_ARB];
+			return NULL;
+	}
+}
+
 static int update_current_identity(int I) {
 	switch(glstate->matrix_mode) {
 		case GL_MODELVIEW:
@@ -85,6 +105,7 @@ DBG(printf("init_matrix(%p)\n", glstate);)
 	glstate->mvp_matrix_dirty = 0;
 	set_identity(glstate->inv_mv_matrix);
 	glstate->inv_mv_matrix_dirty = 0;
+	glstate->inv_mvp_gen[0] = glstate->inv_mvp_gen[1] = 0;
 	// no identity function for 3x3 matrix
 	memset(glstate->normal_matrix, 0, 9*sizeof(GLfloat));
 	glstate->normal_matrix[0] = glstate->normal_matrix[4] = glstate->normal_matrix[8] = 1.0f;
@@ -102,10 +123,11 @@ DBG(printf("init_matrix(%p)\n", glstate);)
 }
 
 void set_fpe_textureidentity() {
-	if(glstate->texture_matrix[glstate->texture.active]->identity)	// inverted in fpe flags
-		glstate->fpe_state->texture[glstate->texture.active].texmat = 0;
-	else
-		glstate->fpe_state->texture[glstate->texture.active].texmat = 1;
+	int texmat = glstate->texture_matrix[glstate->texture.active]->identity?0:1;	// inverted in fpe flags
+	if(glstate->fpe_state->texture[glstate->texture.active].texmat != texmat) {
+		glstate->fpe_state->texture[glstate->texture.active].texmat = texmat;
+		glstate->fpe_dirty = 1;
+	}
 }
 
 void APIENTRY_GL4ES gl4es_glMatrixMode(GLenum mode) {
@@ -186,6 +208,7 @@ DBG(printf("glPopMatrix(), list=%p\n", glstate->list.active);)
 		#define P(A) if(glstate->A->top) { \
 			--glstate->A->top; \
 			glstate->A->identity = is_identity(update_current_mat()); \
+			glstate->A->gen = ++matrix_generation; \
 			if (send_to_hardware()) {LOAD_GLES(glLoadMatrixf); gles_glLoadMatrixf(update_current_mat()); } \
 		} else errorShim(GL_STACK_UNDERFLOW)
 		case GL_PROJECTION:
@@ -229,6 +252,7 @@ DBG(printf("glLoadMatrix(%f, %f, %f, %f, %f, %f, %f...), list=%p\n", m[0], m[1],
 	}
 	memcpy(update_current_mat(), m, 16*sizeof(GLfloat));
 	const int id = update_current_identity(0);
+	current_stack()->gen = ++matrix_generation;
 	if(glstate->matrix_mode==GL_MODELVIEW)
 		glstate->normal_matrix_dirty = glstate->inv_mv_matrix_dirty = 1;
 	if(glstate->matrix_mode==GL_MODELVIEW || glstate->matrix_mode==GL_PROJECTION)
@@ -262,6 +286,7 @@ DBG(printf("glMultMatrix(%f, %f, %f, %f, %f, %f, %f...), list=%p\n", m[0], m[1],
 	GLfloat *current_mat = update_current_mat();
 	matrix_mul(current_mat, m, current_mat);
 	const int id = update_current_identity(0);
+	current_stack()->gen = ++matrix_generation;
 	if(glstate->matrix_mode==GL_MODELVIEW)
 		glstate->normal_matrix_dirty = glstate->inv_mv_matrix_dirty = 1;
 	if(glstate->matrix_mode==GL_MODELVIEW || glstate->matrix_mode==GL_PROJECTION)
@@ -290,6 +315,7 @@ DBG(printf("glLoadIdentity(), list=%p\n", glstate->list.active);)
 	}
 	set_identity(update_current_mat());
 	update_current_identity(1);
+	current_stack()->gen = ++matrix_generation;
 	if(glstate->matrix_mode==GL_MODELVIEW)
 		glstate->normal_matrix_dirty = glstate->inv_mv_matrix_dirty = 1;
 	if(glstate->matrix_mode==GL_MODELVIEW || glstate->matrix_mode==GL_PROJECTION)
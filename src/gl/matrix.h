@@ -55,5 +55,24 @@ static inline GLfloat* getMVPMat()
 	return glstate->mvp_matrix;
 }
 
+// inverse of the top matrix of a stack, only computed again when the matrix changed
+static inline GLfloat* getInvMat(matrixstack_t *m) {
+	if(m->inv_gen!=m->gen) {
+		matrix_inverse(m->stack+m->top*16, m->inv);
+		m->inv_gen = m->gen;
+	}
+	return m->inv;
+}
+
+static inline GLfloat* getInvMVPMat()
+{
+	if(glstate->inv_mvp_gen[0]!=glstate->projection_matrix->gen || glstate->inv_mvp_gen[1]!=glstate->modelview_matrix->gen) {
+		matrix_inverse(getMVPMat(), glstate->inv_mvp_matrix);
+		glstate->inv_mvp_gen[0] = glstate->projection_matrix->gen;
+		glstate->inv_mvp_gen[1] = glstate->modelview_matrix->gen;
+	}
+	return glstate->inv_mvp_matrix;
+}
+
 
 #endif // _GL4ES_MATRIX_H_
@@ -0,0 +1,1261 @@
+#include "nullgles.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../glx/hardext.h"
+#include "const.h"
+#include "enum_info.h"
+#include "envvars.h"
+#include "init.h"
+#include "loader.h"
+#include "logs.h"
+#include "khash.h"
+
+// The null backend hands out its own stubs through gles_getProcAddress, so the normal
+// LOAD_GLES* / LOAD_EGL machinery (and the hardware extension detection) works unchanged.
+
+#define NULL_BINARY_FORMAT  0x4E554C4C  // "NULL"
+
+// GLES entry points that are only counted
+#define NULLGLES_STUBS(_) \
+    _(glActiveTexture) _(glAlphaFunc) _(glAlphaFuncx) _(glBindFramebuffer) \
+    _(glBindRenderbuffer) _(glBindTexture) _(glBlendColor) _(glBlendEquation) _(glBlendEquationSeparate) \
+    _(glBlendFunc) _(glBlendFuncSeparate) _(glClear) _(glClearColor) _(glClearColorx) \
+    _(glClearDepthf) _(glClearDepthx) _(glClearStencil) _(glClientActiveTexture) _(glClipPlanef) \
+    _(glClipPlanex) _(glColor4f) _(glColor4ub) _(glColor4x) _(glColorMask) \
+    _(glColorPointer) _(glCopyTexImage2D) _(glCopyTexSubImage2D) _(glCullFace) \
+    _(glDeleteFramebuffers) _(glDeleteRenderbuffers) _(glDeleteTextures) _(glDepthFunc) _(glDepthMask) \
+    _(glDepthRangef) _(glDepthRangex) _(glDisable) _(glDisableClientState) _(glDisableVertexAttribArray) \
+    _(glDrawBuffers) _(glEnable) _(glEnableClientState) _(glEnableVertexAttribArray) _(glFinish) \
+    _(glFlush) _(glFogCoordPointer) _(glFogCoordf) _(glFogCoordfv) _(glFogf) \
+    _(glFogfv) _(glFogx) _(glFogxv) _(glFramebufferRenderbuffer) _(glFramebufferTexture2D) \
+    _(glFrontFace) _(glFrustumf) _(glFrustumx) _(glGenerateMipmap) _(glHint) \
+    _(glLightModelf) _(glLightModelfv) _(glLightModelx) _(glLightModelxv) _(glLightf) \
+    _(glLightfv) _(glLightx) _(glLightxv) _(glLineWidth) _(glLineWidthx) \
+    _(glLoadIdentity) _(glLoadMatrixf) _(glLoadMatrixx) _(glLogicOp) _(glMaterialf) \
+    _(glMaterialfv) _(glMaterialx) _(glMaterialxv) _(glMatrixMode) _(glMultMatrixf) \
+    _(glMultMatrixx) _(glMultiTexCoord4f) _(glMultiTexCoord4x) _(glNormal3f) _(glNormal3x) \
+    _(glNormalPointer) _(glOrthof) _(glOrthox) _(glPixelStorei) _(glPointParameterf) \
+    _(glPointParameterfv) _(glPointParameterx) _(glPointParameterxv) _(glPointSize) _(glPointSizePointerOES) \
+    _(glPointSizex) _(glPolygonOffset) _(glPolygonOffsetx) _(glPopMatrix) _(glPushMatrix) \
+    _(glReleaseShaderCompiler) _(glRenderbufferStorage) _(glRotatef) _(glRotatex) _(glSampleCoverage) \
+    _(glSampleCoveragex) _(glScalef) _(glScalex) _(glShadeModel) _(glShaderBinary) \
+    _(glStencilFunc) _(glStencilFuncSeparate) _(glStencilMask) _(glStencilMaskSeparate) _(glStencilOp) \
+    _(glStencilOpSeparate) _(glTexCoordPointer) _(glTexEnvf) _(glTexEnvfv) _(glTexEnvi) \
+    _(glTexEnviv) _(glTexEnvx) _(glTexEnvxv) _(glTexGenfv) _(glTexGeni) \
+    _(glTexParameterf) _(glTexParameterfv) _(glTexParameteri) _(glTexParameteriv) _(glTexParameterx) \
+    _(glTexParameterxv) _(glTranslatef) _(glTranslatex) _(glUniform1f) _(glUniform1fv) \
+    _(glUniform1i) _(glUniform1iv) _(glUniform2f) _(glUniform2fv) _(glUniform2i) \
+    _(glUniform2iv) _(glUniform3f) _(glUniform3fv) _(glUniform3i) _(glUniform3iv) \
+    _(glUniform4f) _(glUniform4fv) _(glUniform4i) _(glUniform4iv) _(glUniformMatrix2fv) \
+    _(glUniformMatrix3fv) _(glUniformMatrix4fv) _(glUseProgram) _(glValidateProgram) _(glVertexAttrib1f) \
+    _(glVertexAttrib1fv) _(glVertexAttrib2f) _(glVertexAttrib2fv) _(glVertexAttrib3f) _(glVertexAttrib3fv) \
+    _(glVertexAttrib4f) _(glVertexAttrib4fv) _(glVertexAttribIPointer) _(glVertexAttribPointer) _(glVertexPointer)
+
+// GLES entry points with a (fake) implementation below
+#define NULLGLES_IMPLS(_) \
+    _(glGetString) _(glGetIntegerv) _(glGetFloatv) _(glGetBooleanv) _(glGetFixedv) \
+    _(glGetError) _(glIsEnabled) _(glGenTextures) _(glGenBuffers) _(glGenFramebuffers) \
+    _(glGenRenderbuffers) _(glCreateShader) _(glCreateProgram) _(glDeleteShader) _(glDeleteProgram) \
+    _(glShaderSource) _(glCompileShader) _(glGetShaderiv) _(glGetShaderInfoLog) _(glGetShaderSource) \
+    _(glGetShaderPrecisionFormat) _(glAttachShader) _(glDetachShader) _(glGetAttachedShaders) _(glBindAttribLocation) \
+    _(glLinkProgram) _(glGetProgramiv) _(glGetProgramInfoLog) _(glGetActiveUniform) _(glGetActiveAttrib) \
+    _(glGetUniformLocation) _(glGetAttribLocation) _(glGetProgramBinary) _(glProgramBinary) _(glCheckFramebufferStatus) \
+    _(glIsBuffer) _(glIsFramebuffer) _(glIsProgram) _(glIsRenderbuffer) _(glIsShader) \
+    _(glIsTexture) _(glReadPixels) _(glViewport) _(glScissor) _(glDrawArrays) \
+    _(glDrawElements) _(glMultiDrawArrays) _(glMultiDrawElements) _(glDrawTexf) _(glDrawTexi) \
+    _(glTexImage2D) _(glTexSubImage2D) _(glCompressedTexImage2D) _(glCompressedTexSubImage2D) _(glBufferData) \
+    _(glBufferSubData) _(glBindBuffer) _(glDeleteBuffers) _(glGetTexParameterfv) _(glGetTexParameteriv) _(glGetTexParameterxv) _(glGetBufferParameteriv) \
+    _(glGetRenderbufferParameteriv) _(glGetFramebufferAttachmentParameteriv) _(glGetVertexAttribfv) _(glGetVertexAttribiv) _(glGetVertexAttribPointerv) \
+    _(glGetUniformfv) _(glGetUniformiv) _(glGetPointerv) _(glGetLightfv) _(glGetLightxv) \
+    _(glGetMaterialfv) _(glGetMaterialxv) _(glGetTexEnvfv) _(glGetTexEnviv) _(glGetTexEnvxv) \
+    _(glGetClipPlanef) _(glGetClipPlanex)
+
+#ifndef NOEGL
+// EGL entry points that simply succeed
+#define NULLEGL_STUBS(_) \
+    _(eglBindAPI) _(eglBindTexImage) _(eglCopyBuffers) _(eglDestroyContext) _(eglDestroySurface) \
+    _(eglReleaseTexImage) _(eglReleaseThread) _(eglSurfaceAttrib) _(eglSwapInterval) _(eglTerminate) \
+    _(eglWaitClient) _(eglWaitGL) _(eglWaitNative) _(eglCreateSyncKHR) _(eglDestroySyncKHR) \
+    _(eglClientWaitSyncKHR) _(eglUnlockSurfaceKHR)
+// EGL entry points with a (fake) implementation below
+#define NULLEGL_IMPLS(_) \
+    _(eglInitialize) _(eglGetDisplay) _(eglGetPlatformDisplay) _(eglChooseConfig) _(eglGetConfigs) \
+    _(eglGetConfigAttrib) _(eglCreateContext) _(eglCreatePbufferSurface) _(eglCreateWindowSurface) _(eglCreatePlatformWindowSurface) \
+    _(eglCreatePixmapSurface) _(eglCreatePbufferFromClientBuffer) _(eglMakeCurrent) _(eglGetCurrentContext) _(eglGetCurrentDisplay) \
+    _(eglGetCurrentSurface) _(eglQueryString) _(eglQueryContext) _(eglQuerySurface) _(eglQueryAPI) \
+    _(eglGetError) _(eglGetProcAddress) _(eglSwapBuffers)
+#else
+#define NULLEGL_STUBS(_)
+#define NULLEGL_IMPLS(_)
+#endif
+
+#define ALL_ENTRIES(_) NULLGLES_STUBS(_) NULLGLES_IMPLS(_) NULLEGL_STUBS(_) NULLEGL_IMPLS(_)
+
+enum {
+#define ENUM(name) NULL_##name,
+    ALL_ENTRIES(ENUM)
+#undef ENUM
+    NULL_LAST
+};
+
+static int null_mode = 0;
+static unsigned long null_calls[NULL_LAST];
+static nullgles_counters_t null_counters;
+
+#define COUNT(name) \
+    ++null_calls[NULL_##name]; \
+    ++null_counters.calls; \
+    if(null_mode>1) LOGD("nullgles: %s\n", #name)
+
+// ********* Fake capabilities *********
+
+static const char null_default_ext[] =
+    "GL_OES_element_index_uint GL_OES_packed_depth_stencil GL_OES_depth24 GL_OES_rgb8_rgba8 "
+    "GL_EXT_texture_format_BGRA8888 GL_OES_depth_texture GL_OES_texture_npot GL_OES_mapbuffer "
+    "GL_OES_get_program_binary GL_OES_standard_derivatives GL_OES_fragment_precision_high "
+    "GL_EXT_blend_minmax GL_EXT_texture_filter_anisotropic ";
+
+static char *null_ext = NULL;
+static char *null_vendor = NULL;
+static int null_maxsize = 4096;
+static int null_texunits = 8;
+static int null_prgbin = 0;
+static GLint null_viewport[4] = {0, 0, 800, 600};
+static GLint null_scissor[4] = {0, 0, 800, 600};
+static GLuint null_names = 0;
+
+// ********* Shader & Program objects *********
+
+typedef struct {
+    char    *name;
+    GLenum  type;
+    GLint   size;
+    GLint   location;
+} null_var_t;
+
+typedef struct {
+    null_var_t *vars;
+    int size;
+    int cap;
+} null_varlist_t;
+
+typedef struct {
+    int     used;
+    GLenum  shader_type;    // 0 for a program
+    char    *source;
+    int     compiled;
+    const char *log;
+    GLuint  *attached;
+    int     n_attached;
+    int     cap_attached;
+    int     linked;
+    null_varlist_t uniforms;
+    null_varlist_t attribs;
+    null_varlist_t bindings;
+} null_object_t;
+
+static null_object_t *null_objects = NULL;
+static GLuint null_objects_cap = 0;
+static GLuint null_objects_next = 1;
+
+static void varlist_clear(null_varlist_t *list) {
+    for (int i=0; i<list->size; ++i)
+        free(list->vars[i].name);
+    list->size = 0;
+}
+
+static void varlist_free(null_varlist_t *list) {
+    varlist_clear(list);
+    free(list->vars);
+    list->vars = NULL;
+    list->cap = 0;
+}
+
+static null_var_t* varlist_find(null_varlist_t *list, const char *name) {
+    for (int i=0; i<list->size; ++i)
+        if(strcmp(list->vars[i].name, name)==0)
+            return &list->vars[i];
+    return NULL;
+}
+
+static null_var_t* varlist_add(null_varlist_t *list, const char *name, GLenum type, GLint size, GLint location) {
+    if(list->size==list->cap) {
+        list->cap += 16;
+        list->vars = (null_var_t*)realloc(list->vars, list->cap*sizeof(null_var_t));
+    }
+    null_var_t *v = &list->vars[list->size++];
+    v->name = strdup(name);
+    v->type = type;
+    v->size = size;
+    v->location = location;
+    return v;
+}
+
+static null_object_t* new_object(GLenum shader_type) {
+    if(null_objects_next>=null_objects_cap) {
+        GLuint old = null_objects_cap;
+        null_objects_cap += 64;
+        null_objects = (null_object_t*)realloc(null_objects, null_objects_cap*sizeof(null_object_t));
+        memset(null_objects+old, 0, (null_objects_cap-old)*sizeof(null_object_t));
+    }
+    null_object_t *obj = &null_objects[null_objects_next++];
+    obj->used = 1;
+    obj->shader_type = shader_type;
+    return obj;
+}
+
+static null_object_t* get_object(GLuint id) {
+    if(!id || id>=null_objects_next || !null_objects[id].used)
+        return NULL;
+    return &null_objects[id];
+}
+
+static void delete_object(GLuint id) {
+    null_object_t *obj = get_object(id);
+    if(!obj)
+        return;
+    free(obj->source);
+    free(obj->attached);
+    varlist_free(&obj->uniforms);
+    varlist_free(&obj->attribs);
+    varlist_free(&obj->bindings);
+    memset(obj, 0, sizeof(null_object_t));
+}
+
+// ********* Minimal GLSL declaration parser *********
+// Only top level "uniform", "attribute" / "in" and "struct" declarations are looked at,
+// which is enough to expose the same active uniforms & attributes a real driver would.
+
+typedef struct {
+    const char *p;
+    char tok[128];
+} lexer_t;
+
+static int next_token(lexer_t *lex) {
+    const char *p = lex->p;
+    while(*p) {
+        if(*p==' ' || *p=='\t' || *p=='\n' || *p=='\r')
+            ++p;
+        else if(p[0]=='/' && p[1]=='/') {
+            while(*p && *p!='\n') ++p;
+        } else if(p[0]=='/' && p[1]=='*') {
+            p+=2;
+            while(*p && !(p[0]=='*' && p[1]=='/')) ++p;
+            if(*p) p+=2;
+        } else if(*p=='#') {
+            while(*p && *p!='\n') ++p;
+        } else
+            break;
+    }
+    if(!*p) {
+        lex->p = p;
+        lex->tok[0] = '\0';
+        return 0;
+    }
+    int n = 0;
+    if((*p>='a' && *p<='z') || (*p>='A' && *p<='Z') || (*p>='0' && *p<='9') || *p=='_') {
+        while((*p>='a' && *p<='z') || (*p>='A' && *p<='Z') || (*p>='0' && *p<='9') || *p=='_' || *p=='.') {
+            if(n<(int)sizeof(lex->tok)-1) lex->tok[n++] = *p;
+            ++p;
+        }
+    } else
+        lex->tok[n++] = *(p++);
+    lex->tok[n] = '\0';
+    lex->p = p;
+    return 1;
+}
+
+static GLenum glsl_type(const char *name) {
+    static const struct { const char *name; GLenum type; } types[] = {
+        {"float", GL_FLOAT}, {"vec2", GL_FLOAT_VEC2}, {"vec3", GL_FLOAT_VEC3}, {"vec4", GL_FLOAT_VEC4},
+        {"int", GL_INT}, {"ivec2", GL_INT_VEC2}, {"ivec3", GL_INT_VEC3}, {"ivec4", GL_INT_VEC4},
+        {"bool", GL_BOOL}, {"bvec2", GL_BOOL_VEC2}, {"bvec3", GL_BOOL_VEC3}, {"bvec4", GL_BOOL_VEC4},
+        {"mat2", GL_FLOAT_MAT2}, {"mat3", GL_FLOAT_MAT3}, {"mat4", GL_FLOAT_MAT4},
+        {"sampler2D", GL_SAMPLER_2D}, {"samplerCube", GL_SAMPLER_CUBE},
+    };
+    for (int i=0; i<sizeof(types)/sizeof(types[0]); ++i)
+        if(strcmp(types[i].name, name)==0)
+            return types[i].type;
+    return 0;
+}
+
+static int is_qualifier(const char *tok) {
+    return !strcmp(tok, "lowp") || !strcmp(tok, "mediump") || !strcmp(tok, "highp")
+        || !strcmp(tok, "flat") || !strcmp(tok, "smooth") || !strcmp(tok, "invariant")
+        || !strcmp(tok, "const");
+}
+
+typedef struct {
+    char            name[128];
+    null_varlist_t  members;    // type==0 and location = index of the struct for nested structs
+} null_struct_t;
+
+typedef struct {
+    null_struct_t   *structs;
+    int             size;
+} structlist_t;
+
+static int find_struct(structlist_t *structs, const char *name) {
+    for (int i=0; i<structs->size; ++i)
+        if(strcmp(structs->structs[i].name, name)==0)
+            return i;
+    return -1;
+}
+
+// parse "type name[N], name2;" declarators, calling add for each
+typedef void (*declare_t)(void *user, structlist_t *structs, const char *name, GLenum type, int st, int size, int array);
+
+static void parse_declaration(lexer_t *lex, structlist_t *structs, declare_t add, void *user) {
+    while(next_token(lex) && is_qualifier(lex->tok));
+    GLenum type = glsl_type(lex->tok);
+    int st = (type)?-1:find_struct(structs, lex->tok);
+    char name[128];
+    while(next_token(lex)) {
+        if(!strcmp(lex->tok, ";"))
+            return;
+        if(!strcmp(lex->tok, ",")) continue;
+        strcpy(name, lex->tok);
+        int size = 1, array = 0;
+        next_token(lex);
+        if(!strcmp(lex->tok, "[")) {
+            next_token(lex);
+            size = atoi(lex->tok);
+            if(size<1) size = 1;
+            array = 1;
+            while(strcmp(lex->tok, "]") && next_token(lex));
+            next_token(lex);
+        }
+        if(!strcmp(lex->tok, "=")) // skip initializer
+            while(strcmp(lex->tok, ";") && strcmp(lex->tok, ",") && next_token(lex));
+        if(type || st>=0)
+            add(user, structs, name, type, st, size, array);
+        if(!strcmp(lex->tok, ";") || !lex->tok[0])
+            return;
+    }
+}
+
+static void add_member(void *user, structlist_t *structs, const char *name, GLenum type, int st, int size, int array) {
+    null_varlist_t *members = (null_varlist_t*)user;
+    varlist_add(members, name, type, array?size:-size, st);
+}
+
+static void add_uniform(void *user, structlist_t *structs, const char *name, GLenum type, int st, int size, int array) {
+    null_object_t *prog = (null_object_t*)user;
+    char buff[256];
+    if(type) {
+        if(array)
+            snprintf(buff, sizeof(buff), "%s[0]", name);
+        else
+            strcpy(buff, name);
+        if(!varlist_find(&prog->uniforms, buff)) {
+            GLint loc = 0;
+            if(prog->uniforms.size) {
+                null_var_t *last = &prog->uniforms.vars[prog->uniforms.size-1];
+                loc = last->location + last->size;
+            }
+            varlist_add(&prog->uniforms, buff, type, size, loc);
+        }
+        return;
+    }
+    // struct: expand all members, like drivers do
+    null_varlist_t *members = &structs->structs[st].members;
+    for (int i=0; i<size; ++i) {
+        for (int j=0; j<members->size; ++j) {
+            null_var_t *m = &members->vars[j];
+            if(array)
+                snprintf(buff, sizeof(buff), "%s[%d].%s", name, i, m->name);
+            else
+                snprintf(buff, sizeof(buff), "%s.%s", name, m->name);
+            add_uniform(user, structs, buff, m->type, m->location, (m->size<0)?-m->size:m->size, m->size>0);
+        }
+    }
+}
+
+static void add_attrib(void *user, structlist_t *structs, const char *name, GLenum type, int st, int size, int array) {
+    null_object_t *prog = (null_object_t*)user;
+    if(type && !varlist_find(&prog->attribs, name))
+        varlist_add(&prog->attribs, name, type, size, -1);
+}
+
+static void parse_shader(null_object_t *prog, null_object_t *shader, structlist_t *structs) {
+    lexer_t lex = {0};
+    lex.p = shader->source;
+    int braces = 0, parens = 0;
+    while(next_token(&lex)) {
+        if(!strcmp(lex.tok, "{")) ++braces;
+        else if(!strcmp(lex.tok, "}")) --braces;
+        else if(!strcmp(lex.tok, "(")) ++parens;
+        else if(!strcmp(lex.tok, ")")) --parens;
+        else if(braces || parens) continue;
+        else if(!strcmp(lex.tok, "struct")) {
+            if(!next_token(&lex)) break;
+            structs->structs = (null_struct_t*)realloc(structs->structs, (structs->size+1)*sizeof(null_struct_t));
+            null_struct_t *s = &structs->structs[structs->size++];
+            memset(s, 0, sizeof(null_struct_t));
+            strncpy(s->name, lex.tok, sizeof(s->name)-1);
+            next_token(&lex);   // "{"
+            const char *save = lex.p;
+            while(next_token(&lex) && strcmp(lex.tok, "}")) {
+                lex.p = save;
+                parse_declaration(&lex, structs, add_member, &s->members);
+                save = lex.p;
+            }
+        } else if(!strcmp(lex.tok, "uniform"))
+            parse_declaration(&lex, structs, add_uniform, prog);
+        else if(shader->shader_type==GL_VERTEX_SHADER && (!strcmp(lex.tok, "attribute") || !strcmp(lex.tok, "in")))
+            parse_declaration(&lex, structs, add_attrib, prog);
+    }
+}
+
+static void link_program(null_object_t *prog) {
+    varlist_clear(&prog->uniforms);
+    varlist_clear(&prog->attribs);
+    structlist_t structs = {0};
+    for (int i=0; i<prog->n_attached; ++i) {
+        null_object_t *shader = get_object(prog->attached[i]);
+        if(shader && shader->source)
+            parse_shader(prog, shader, &structs);
+    }
+    for (int i=0; i<structs.size; ++i)
+        varlist_free(&structs.structs[i].members);
+    free(structs.structs);
+    // attributes: explicit bindings first, then the first free slots
+    unsigned int used = 0;
+    for (int i=0; i<prog->attribs.size; ++i) {
+        null_var_t *b = varlist_find(&prog->bindings, prog->attribs.vars[i].name);
+        if(b) {
+            prog->attribs.vars[i].location = b->location;
+            if(b->location>=0 && b->location<32)
+                used |= 1u<<b->location;
+        }
+    }
+    for (int i=0; i<prog->attribs.size; ++i) {
+        if(prog->attribs.vars[i].location==-1) {
+            int loc = 0;
+            while(loc<31 && (used&(1u<<loc))) ++loc;
+            prog->attribs.vars[i].location = loc;
+            used |= 1u<<loc;
+        }
+    }
+    prog->linked = 1;
+    ++null_counters.programs;
+}
+
+static GLint varlist_maxlength(null_varlist_t *list) {
+    GLint l = 0;
+    for (int i=0; i<list->size; ++i)
+        if(strlen(list->vars[i].name)+1>l)
+            l = strlen(list->vars[i].name)+1;
+    return l;
+}
+
+static GLint varlist_location(null_varlist_t *list, const char *name) {
+    null_var_t *v = varlist_find(list, name);
+    if(v)
+        return v->location;
+    // "name" or "name[n]" of an array reported as "name[0]"
+    char buff[256];
+    strncpy(buff, name, sizeof(buff)-4);
+    buff[sizeof(buff)-4] = '\0';
+    int idx = 0;
+    char *p = strrchr(buff, '[');
+    if(p && buff[strlen(buff)-1]==']') {
+        idx = atoi(p+1);
+        *p = '\0';
+    }
+    strcat(buff, "[0]");
+    v = varlist_find(list, buff);
+    if(v && idx<v->size)
+        return v->location + idx;
+    return -1;
+}
+
+static void get_active(null_varlist_t *list, GLuint index, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name) {
+    if(index>=list->size) {
+        if(length) *length = 0;
+        return;
+    }
+    null_var_t *v = &list->vars[index];
+    if(size) *size = v->size;
+    if(type) *type = v->type;
+    if(name && bufSize>0) {
+        strncpy(name, v->name, bufSize-1);
+        name[bufSize-1] = '\0';
+        if(length) *length = strlen(name);
+    } else if(length)
+        *length = 0;
+}
+
+// program binaries are just the serialized uniform and attribute tables
+static int binary_size(null_varlist_t *list) {
+    int s = sizeof(GLint);
+    for (int i=0; i<list->size; ++i)
+        s += 4*sizeof(GLint) + strlen(list->vars[i].name);
+    return s;
+}
+
+static char* binary_write(null_varlist_t *list, char *p) {
+    GLint n = list->size;
+    memcpy(p, &n, sizeof(GLint)); p += sizeof(GLint);
+    for (int i=0; i<list->size; ++i) {
+        null_var_t *v = &list->vars[i];
+        GLint hdr[4] = {v->type, v->size, v->location, strlen(v->name)};
+        memcpy(p, hdr, sizeof(hdr)); p += sizeof(hdr);
+        memcpy(p, v->name, hdr[3]); p += hdr[3];
+    }
+    return p;
+}
+
+static const char* binary_read(null_varlist_t *list, const char *p, const char *end) {
+    GLint n;
+    if(!p || p+sizeof(GLint)>end) return NULL;
+    memcpy(&n, p, sizeof(GLint)); p += sizeof(GLint);
+    char name[256];
+    for (int i=0; i<n; ++i) {
+        GLint hdr[4];
+        if(p+sizeof(hdr)>end) return NULL;
+        memcpy(hdr, p, sizeof(hdr)); p += sizeof(hdr);
+        if(hdr[3]<0 || hdr[3]>=sizeof(name) || p+hdr[3]>end) return NULL;
+        memcpy(name, p, hdr[3]); p += hdr[3];
+        name[hdr[3]] = '\0';
+        varlist_add(list, name, hdr[0], hdr[1], hdr[2]);
+    }
+    return p;
+}
+
+// ********* Stubs *********
+
+#define STUB(name) static void APIENTRY_GLES null_##name() { COUNT(name); }
+NULLGLES_STUBS(STUB)
+#undef STUB
+
+static const GLubyte* APIENTRY_GLES null_glGetString(glGetString_ARG_EXPAND) {
+    COUNT(glGetString);
+    switch(name) {
+        case GL_VENDOR: return (const GLubyte*)null_vendor;
+        case GL_RENDERER: return (const GLubyte*)"gl4es null GLES";
+        case GL_VERSION: return (const GLubyte*)((hardext.esversion==1)?"OpenGL ES-CM 1.1 null":"OpenGL ES 2.0 null");
+        case GL_SHADING_LANGUAGE_VERSION: return (const GLubyte*)"OpenGL ES GLSL ES 1.00 null";
+        case GL_EXTENSIONS: return (const GLubyte*)null_ext;
+    }
+    return NULL;
+}
+
+static void APIENTRY_GLES null_glGetIntegerv(glGetIntegerv_ARG_EXPAND) {
+    COUNT(glGetIntegerv);
+    switch(pname) {
+        case GL_MAX_TEXTURE_SIZE:
+        case GL_MAX_RENDERBUFFER_SIZE: *params = null_maxsize; break;
+        case GL_MAX_TEXTURE_UNITS:
+        case GL_MAX_TEXTURE_IMAGE_UNITS: *params = null_texunits; break;
+        case GL_MAX_VERTEX_ATTRIBS: *params = 16; break;
+        case GL_MAX_VARYING_VECTORS: *params = 16; break;
+        case GL_MAX_VERTEX_UNIFORM_VECTORS: *params = 256; break;
+        case GL_MAX_FRAGMENT_UNIFORM_VECTORS: *params = 224; break;
+        case GL_MAX_LIGHTS: *params = 8; break;
+        case GL_MAX_CLIP_PLANES: *params = 6; break;
+        case GL_MAX_TEXTURE_MAX_ANISOTROPY: *params = 16; break;
+        case GL_MAX_COLOR_ATTACHMENTS_EXT:
+        case GL_MAX_DRAW_BUFFERS_ARB: *params = 4; break;
+        case GL_VIEWPORT: memcpy(params, null_viewport, sizeof(null_viewport)); break;
+        case GL_SCISSOR_BOX: memcpy(params, null_scissor, sizeof(null_scissor)); break;
+        case GL_IMPLEMENTATION_COLOR_READ_FORMAT_OES: *params = GL_RGBA; break;
+        case GL_IMPLEMENTATION_COLOR_READ_TYPE_OES: *params = GL_UNSIGNED_BYTE; break;
+        case GL_NUM_PROGRAM_BINARY_FORMATS_OES: *params = null_prgbin; break;
+        case GL_PROGRAM_BINARY_FORMATS_OES: *params = NULL_BINARY_FORMAT; break;
+        case GL_RED_BITS:
+        case GL_GREEN_BITS:
+        case GL_BLUE_BITS:
+        case GL_ALPHA_BITS:
+        case GL_STENCIL_BITS: *params = 8; break;
+        case GL_DEPTH_BITS: *params = 24; break;
+        default: *params = 0;
+    }
+}
+
+static void APIENTRY_GLES null_glGetFloatv(glGetFloatv_ARG_EXPAND) {
+    COUNT(glGetFloatv);
+    switch(pname) {
+        case GL_ALIASED_POINT_SIZE_RANGE:
+        case GL_ALIASED_LINE_WIDTH_RANGE: params[0] = 1.0f; params[1] = 64.0f; break;
+        case GL_MAX_TEXTURE_MAX_ANISOTROPY: *params = 16.0f; break;
+        default: *params = 0.0f;
+    }
+}
+
+static void APIENTRY_GLES null_glGetBooleanv(glGetBooleanv_ARG_EXPAND) { COUNT(glGetBooleanv); *params = GL_FALSE; }
+static void APIENTRY_GLES null_glGetFixedv(glGetFixedv_ARG_EXPAND) { COUNT(glGetFixedv); *params = 0; }
+static GLenum APIENTRY_GLES null_glGetError(glGetError_ARG_EXPAND) { COUNT(glGetError); return GL_NO_ERROR; }
+static GLboolean APIENTRY_GLES null_glIsEnabled(glIsEnabled_ARG_EXPAND) { COUNT(glIsEnabled); return GL_FALSE; }
+
+#define GEN(name) \
+static void APIENTRY_GLES null_##name(GLsizei n, GLuint *ids) { \
+    COUNT(name); \
+    for (int i=0; i<n; ++i) ids[i] = ++null_names; \
+}
+GEN(glGenTextures)
+GEN(glGenBuffers)
+GEN(glGenFramebuffers)
+GEN(glGenRenderbuffers)
+#undef GEN
+
+#define IS(name) static GLboolean APIENTRY_GLES null_##name(GLuint id) { COUNT(name); return id?GL_TRUE:GL_FALSE; }
+IS(glIsBuffer)
+IS(glIsFramebuffer)
+IS(glIsRenderbuffer)
+IS(glIsTexture)
+#undef IS
+static GLboolean APIENTRY_GLES null_glIsProgram(glIsProgram_ARG_EXPAND) { COUNT(glIsProgram); null_object_t *o = get_object(program); return (o && !o->shader_type)?GL_TRUE:GL_FALSE; }
+static GLboolean APIENTRY_GLES null_glIsShader(glIsShader_ARG_EXPAND) { COUNT(glIsShader); null_object_t *o = get_object(shader); return (o && o->shader_type)?GL_TRUE:GL_FALSE; }
+
+static GLuint APIENTRY_GLES null_glCreateShader(glCreateShader_ARG_EXPAND) {
+    COUNT(glCreateShader);
+    new_object(type);
+    return null_objects_next-1;
+}
+
+static GLuint APIENTRY_GLES null_glCreateProgram(glCreateProgram_ARG_EXPAND) {
+    COUNT(glCreateProgram);
+    new_object(0);
+    return null_objects_next-1;
+}
+
+static void APIENTRY_GLES null_glDeleteShader(glDeleteShader_ARG_EXPAND) { COUNT(glDeleteShader); delete_object(shader); }
+static void APIENTRY_GLES null_glDeleteProgram(glDeleteProgram_ARG_EXPAND) { COUNT(glDeleteProgram); delete_object(program); }
+
+static void APIENTRY_GLES null_glShaderSource(glShaderSource_ARG_EXPAND) {
+    COUNT(glShaderSource);
+    null_object_t *obj = get_object(shader);
+    if(!obj) return;
+    int len = 0;
+    for (int i=0; i<count; ++i)
+        len += (length && length[i]>=0)?length[i]:strlen(string[i]);
+    free(obj->source);
+    obj->source = (char*)malloc(len+1);
+    obj->source[0] = '\0';
+    char *p = obj->source;
+    for (int i=0; i<count; ++i) {
+        int l = (length && length[i]>=0)?length[i]:strlen(string[i]);
+        memcpy(p, string[i], l);
+        p += l;
+    }
+    *p = '\0';
+}
+
+static void APIENTRY_GLES null_glCompileShader(glCompileShader_ARG_EXPAND) {
+    COUNT(glCompileShader);
+    null_object_t *obj = get_object(shader);
+    if(!obj) return;
+    // behave like a plain GLES2 driver: only GLSL 100 is accepted
+    const char *v = (obj->source)?strstr(obj->source, "#version"):NULL;
+    obj->compiled = (!v || atoi(v+strlen("#version"))==100);
+    obj->log = obj->compiled?NULL:"null GLES: unsupported GLSL version";
+}
+
+static void APIENTRY_GLES null_glGetShaderiv(glGetShaderiv_ARG_EXPAND) {
+    COUNT(glGetShaderiv);
+    null_object_t *obj = get_object(shader);
+    *params = 0;
+    if(!obj) return;
+    switch(pname) {
+        case GL_SHADER_TYPE: *params = obj->shader_type; break;
+        case GL_COMPILE_STATUS: *params = obj->compiled; break;
+        case GL_INFO_LOG_LENGTH: *params = obj->log?strlen(obj->log)+1:0; break;
+        case GL_SHADER_SOURCE_LENGTH: *params = obj->source?strlen(obj->source)+1:0; break;
+    }
+}
+
+static void copy_string(const char *s, GLsizei bufSize, GLsizei *length, GLchar *out) {
+    if(!s) s = "";
+    if(bufSize>0) {
+        strncpy(out, s, bufSize-1);
+        out[bufSize-1] = '\0';
+        if(length) *length = strlen(out);
+    } else if(length)
+        *length = 0;
+}
+
+static void APIENTRY_GLES null_glGetShaderInfoLog(glGetShaderInfoLog_ARG_EXPAND) {
+    COUNT(glGetShaderInfoLog);
+    null_object_t *obj = get_object(shader);
+    copy_string(obj?obj->log:NULL, bufSize, length, infoLog);
+}
+
+static void APIENTRY_GLES null_glGetShaderSource(glGetShaderSource_ARG_EXPAND) {
+    COUNT(glGetShaderSource);
+    null_object_t *obj = get_object(shader);
+    copy_string(obj?obj->source:NULL, bufSize, length, source);
+}
+
+static void APIENTRY_GLES null_glGetShaderPrecisionFormat(glGetShaderPrecisionFormat_ARG_EXPAND) {
+    COUNT(glGetShaderPrecisionFormat);
+    range[0] = range[1] = 127;
+    *precision = 23;
+}
+
+static void APIENTRY_GLES null_glAttachShader(glAttachShader_ARG_EXPAND) {
+    COUNT(glAttachShader);
+    null_object_t *prog = get_object(program);
+    if(!prog) return;
+    if(prog->n_attached==prog->cap_attached) {
+        prog->cap_attached += 4;
+        prog->attached = (GLuint*)realloc(prog->attached, prog->cap_attached*sizeof(GLuint));
+    }
+    prog->attached[prog->n_attached++] = shader;
+}
+
+static void APIENTRY_GLES null_glDetachShader(glDetachShader_ARG_EXPAND) {
+    COUNT(glDetachShader);
+    null_object_t *prog = get_object(program);
+    if(!prog) return;
+    for (int i=0; i<prog->n_attached; ++i)
+        if(prog->attached[i]==shader) {
+            prog->attached[i] = prog->attached[--prog->n_attached];
+            return;
+        }
+}
+
+static void APIENTRY_GLES null_glGetAttachedShaders(glGetAttachedShaders_ARG_EXPAND) {
+    COUNT(glGetAttachedShaders);
+    null_object_t *prog = get_object(program);
+    int n = 0;
+    if(prog)
+        for (; n<prog->n_attached && n<maxCount; ++n)
+            obj[n] = prog->attached[n];
+    if(count) *count = n;
+}
+
+static void APIENTRY_GLES null_glBindAttribLocation(glBindAttribLocation_ARG_EXPAND) {
+    COUNT(glBindAttribLocation);
+    null_object_t *prog = get_object(program);
+    if(!prog) return;
+    null_var_t *v = varlist_find(&prog->bindings, name);
+    if(v)
+        v->location = index;
+    else
+        varlist_add(&prog->bindings, name, 0, 1, index);
+}
+
+static void APIENTRY_GLES null_glLinkProgram(glLinkProgram_ARG_EXPAND) {
+    COUNT(glLinkProgram);
+    null_object_t *prog = get_object(program);
+    if(prog)
+        link_program(prog);
+}
+
+static void APIENTRY_GLES null_glGetProgramiv(glGetProgramiv_ARG_EXPAND) {
+    COUNT(glGetProgramiv);
+    null_object_t *prog = get_object(program);
+    *params = 0;
+    if(!prog) return;
+    switch(pname) {
+        case GL_LINK_STATUS:
+        case GL_VALIDATE_STATUS: *params = prog->linked; break;
+        case GL_ATTACHED_SHADERS: *params = prog->n_attached; break;
+        case GL_ACTIVE_UNIFORMS: *params = prog->uniforms.size; break;
+        case GL_ACTIVE_UNIFORM_MAX_LENGTH: *params = varlist_maxlength(&prog->uniforms); break;
+        case GL_ACTIVE_ATTRIBUTES: *params = prog->attribs.size; break;
+        case GL_ACTIVE_ATTRIBUTE_MAX_LENGTH: *params = varlist_maxlength(&prog->attribs); break;
+        case GL_PROGRAM_BINARY_LENGTH_OES: *params = prog->linked?(binary_size(&prog->uniforms)+binary_size(&prog->attribs)):0; break;
+    }
+}
+
+static void APIENTRY_GLES null_glGetProgramInfoLog(glGetProgramInfoLog_ARG_EXPAND) {
+    COUNT(glGetProgramInfoLog);
+    copy_string(NULL, bufSize, length, infoLog);
+}
+
+static void APIENTRY_GLES null_glGetActiveUniform(glGetActiveUniform_ARG_EXPAND) {
+    COUNT(glGetActiveUniform);
+    null_object_t *prog = get_object(program);
+    if(prog)
+        get_active(&prog->uniforms, index, bufSize, length, size, type, name);
+}
+
+static void APIENTRY_GLES null_glGetActiveAttrib(glGetActiveAttrib_ARG_EXPAND) {
+    COUNT(glGetActiveAttrib);
+    null_object_t *prog = get_object(program);
+    if(prog)
+        get_active(&prog->attribs, index, bufSize, length, size, type, name);
+}
+
+static GLint APIENTRY_GLES null_glGetUniformLocation(glGetUniformLocation_ARG_EXPAND) {
+    COUNT(glGetUniformLocation);
+    null_object_t *prog = get_object(program);
+    return prog?varlist_location(&prog->uniforms, name):-1;
+}
+
+static GLint APIENTRY_GLES null_glGetAttribLocation(glGetAttribLocation_ARG_EXPAND) {
+    COUNT(glGetAttribLocation);
+    null_object_t *prog = get_object(program);
+    return prog?varlist_location(&prog->attribs, name):-1;
+}
+
+static void APIENTRY_GLES null_glGetProgramBinary(glGetProgramBinary_ARG_EXPAND) {
+    COUNT(glGetProgramBinary);
+    null_object_t *prog = get_object(program);
+    if(length) *length = 0;
+    if(!prog || !prog->linked) return;
+    int size = binary_size(&prog->uniforms)+binary_size(&prog->attribs);
+    if(size>bufSize) return;
+    binary_write(&prog->attribs, binary_write(&prog->uniforms, (char*)binary));
+    if(length) *length = size;
+    if(binaryFormat) *binaryFormat = NULL_BINARY_FORMAT;
+}
+
+static void APIENTRY_GLES null_glProgramBinary(glProgramBinary_ARG_EXPAND) {
+    COUNT(glProgramBinary);
+    null_object_t *prog = get_object(program);
+    if(!prog) return;
+    varlist_clear(&prog->uniforms);
+    varlist_clear(&prog->attribs);
+    const char *end = (const char*)binary+length;
+    prog->linked = (binaryFormat==NULL_BINARY_FORMAT)
+        && binary_read(&prog->attribs, binary_read(&prog->uniforms, (const char*)binary, end), end);
+    if(prog->linked)
+        ++null_counters.programs;
+}
+
+static GLenum APIENTRY_GLES null_glCheckFramebufferStatus(glCheckFramebufferStatus_ARG_EXPAND) {
+    COUNT(glCheckFramebufferStatus);
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void APIENTRY_GLES null_glReadPixels(glReadPixels_ARG_EXPAND) {
+    COUNT(glReadPixels);
+    if(pixels)
+        memset(pixels, 0, width*height*pixel_sizeof(format, type));
+}
+
+static void APIENTRY_GLES null_glViewport(glViewport_ARG_EXPAND) {
+    COUNT(glViewport);
+    null_viewport[0] = x; null_viewport[1] = y; null_viewport[2] = width; null_viewport[3] = height;
+}
+
+static void APIENTRY_GLES null_glScissor(glScissor_ARG_EXPAND) {
+    COUNT(glScissor);
+    null_scissor[0] = x; null_scissor[1] = y; null_scissor[2] = width; null_scissor[3] = height;
+}
+
+// ********* Vertex cache simulation *********
+// With LIBGL_NULLGLES_VCACHE=n, the triangles drawn go through a FIFO post-transform cache
+// of n entries (emptied at each draw), and the vertices that miss it are counted.
+// Element buffers are shadowed for that.
+
+#define NULL_VCACHE_MAX 64
+
+typedef struct {
+    char        *data;
+    GLsizeiptr  size;
+} null_buffer_t;
+
+KHASH_MAP_INIT_INT(nullbuffers, null_buffer_t*);
+
+static int null_vcache = 0;
+static khash_t(nullbuffers) *null_buffers = NULL;
+static GLuint null_elements = 0;    // bound GL_ELEMENT_ARRAY_BUFFER
+
+static null_buffer_t* get_buffer(GLuint id, int create) {
+    khint_t k = kh_get(nullbuffers, null_buffers, id);
+    if(k!=kh_end(null_buffers))
+        return kh_value(null_buffers, k);
+    if(!create)
+        return NULL;
+    int ret;
+    k = kh_put(nullbuffers, null_buffers, id, &ret);
+    null_buffer_t *buff = kh_value(null_buffers, k) = (null_buffer_t*)calloc(1, sizeof(null_buffer_t));
+    return buff;
+}
+
+static void vcache_draw(GLenum mode, GLsizei count, GLenum type, const void *indices, GLint first) {
+    if(!null_vcache)
+        return;
+    int tris;
+    switch(mode) {
+        case GL_TRIANGLES: tris = count/3; break;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN: tris = count-2; break;
+        default: return;
+    }
+    if(tris<=0)
+        return;
+    const char *ind = (const char*)indices;
+    if(type) {
+        int sz = (type==GL_UNSIGNED_INT)?4:(type==GL_UNSIGNED_SHORT)?2:1;
+        if(null_elements) {
+            null_buffer_t *buff = get_buffer(null_elements, 0);
+            if(!buff || !buff->data || (uintptr_t)indices+count*sz>(uintptr_t)buff->size)
+                return;
+            ind = buff->data+(uintptr_t)indices;
+        }
+        if(!ind)
+            return;
+    }
+    GLuint fifo[NULL_VCACHE_MAX];
+    int n = 0, w = 0;
+    unsigned long misses = 0;
+    for (int i=0; i<count; ++i) {
+        GLuint v = !type?(GLuint)(first+i):(type==GL_UNSIGNED_INT)?((const GLuint*)ind)[i]
+                 :(type==GL_UNSIGNED_SHORT)?((const GLushort*)ind)[i]:((const GLubyte*)ind)[i];
+        int hit = 0;
+        for (int j=0; j<n && !hit; ++j)
+            hit = (fifo[j]==v);
+        if(hit)
+            continue;
+        ++misses;
+        if(n<null_vcache)
+            fifo[n++] = v;
+        else {
+            fifo[w] = v;
+            w = (w+1)%null_vcache;
+        }
+    }
+    null_counters.vcache_triangles += tris;
+    null_counters.vcache_misses += misses;
+}
+
+static void APIENTRY_GLES null_glBindBuffer(glBindBuffer_ARG_EXPAND) {
+    COUNT(glBindBuffer);
+    if(target==GL_ELEMENT_ARRAY_BUFFER)
+        null_elements = buffer;
+}
+
+static void APIENTRY_GLES null_glDeleteBuffers(glDeleteBuffers_ARG_EXPAND) {
+    COUNT(glDeleteBuffers);
+    if(!null_buffers)
+        return;
+    for (int i=0; i<n; ++i) {
+        if(buffer[i]==null_elements)
+            null_elements = 0;
+        khint_t k = kh_get(nullbuffers, null_buffers, buffer[i]);
+        if(k!=kh_end(null_buffers)) {
+            free(kh_value(null_buffers, k)->data);
+            free(kh_value(null_buffers, k));
+            kh_del(nullbuffers, null_buffers, k);
+        }
+    }
+}
+
+static void APIENTRY_GLES null_glDrawArrays(glDrawArrays_ARG_EXPAND) {
+    COUNT(glDrawArrays);
+    ++null_counters.draws;
+    null_counters.vertices += count;
+    vcache_draw(mode, count, 0, NULL, first);
+}
+
+static void APIENTRY_GLES null_glDrawElements(glDrawElements_ARG_EXPAND) {
+    COUNT(glDrawElements);
+    ++null_counters.draws;
+    null_counters.vertices += count;
+    vcache_draw(mode, count, type, indices, 0);
+}
+
+static void APIENTRY_GLES null_glMultiDrawArrays(glMultiDrawArrays_ARG_EXPAND) {
+    COUNT(glMultiDrawArrays);
+    ++null_counters.draws;
+    for (int i=0; i<primcount; ++i) {
+        null_counters.vertices += count[i];
+        vcache_draw(mode, count[i], 0, NULL, first[i]);
+    }
+}
+
+static void APIENTRY_GLES null_glMultiDrawElements(glMultiDrawElements_ARG_EXPAND) {
+    COUNT(glMultiDrawElements);
+    ++null_counters.draws;
+    for (int i=0; i<primcount; ++i) {
+        null_counters.vertices += count[i];
+        vcache_draw(mode, count[i], type, indices[i], 0);
+    }
+}
+
+static void APIENTRY_GLES null_glDrawTexf(glDrawTexf_ARG_EXPAND) { COUNT(glDrawTexf); ++null_counters.draws; null_counters.vertices += 4; }
+static void APIENTRY_GLES null_glDrawTexi(glDrawTexi_ARG_EXPAND) { COUNT(glDrawTexi); ++null_counters.draws; null_counters.vertices += 4; }
+
+static void APIENTRY_GLES null_glTexImage2D(glTexImage2D_ARG_EXPAND) {
+    COUNT(glTexImage2D);
+    if(data)
+        null_counters.texbytes += width*height*pixel_sizeof(format, type);
+}
+
+static void APIENTRY_GLES null_glTexSubImage2D(glTexSubImage2D_ARG_EXPAND) {
+    COUNT(glTexSubImage2D);
+    if(data)
+        null_counters.texbytes += width*height*pixel_sizeof(format, type);
+}
+
+static void APIENTRY_GLES null_glCompressedTexImage2D(glCompressedTexImage2D_ARG_EXPAND) {
+    COUNT(glCompressedTexImage2D);
+    if(data)
+        null_counters.texbytes += imageSize;
+}
+
+static void APIENTRY_GLES null_glCompressedTexSubImage2D(glCompressedTexSubImage2D_ARG_EXPAND) {
+    COUNT(glCompressedTexSubImage2D);
+    if(data)
+        null_counters.texbytes += imageSize;
+}
+
+static void APIENTRY_GLES null_glBufferData(glBufferData_ARG_EXPAND) {
+    COUNT(glBufferData);
+    if(data)
+        null_counters.bufbytes += size;
+    if(null_vcache && target==GL_ELEMENT_ARRAY_BUFFER && null_elements) {
+        null_buffer_t *buff = get_buffer(null_elements, 1);
+        buff->data = (char*)realloc(buff->data, size);
+        buff->size = size;
+        if(data)
+            memcpy(buff->data, data, size);
+    }
+}
+
+static void APIENTRY_GLES null_glBufferSubData(glBufferSubData_ARG_EXPAND) {
+    COUNT(glBufferSubData);
+    null_counters.bufbytes += size;
+    if(null_vcache && target==GL_ELEMENT_ARRAY_BUFFER && null_elements) {
+        null_buffer_t *buff = get_buffer(null_elements, 0);
+        if(buff && offset>=0 && offset+size<=buff->size)
+            memcpy(buff->data+offset, data, size);
+    }
+}
+
+// all other getters just return 0
+#define GETTER(name, out) static void APIENTRY_GLES null_##name(name##_ARG_EXPAND) { COUNT(name); if(out) *(out) = 0; }
+GETTER(glGetTexParameterfv, params)
+GETTER(glGetTexParameteriv, params)
+GETTER(glGetTexParameterxv, params)
+GETTER(glGetBufferParameteriv, params)
+GETTER(glGetRenderbufferParameteriv, params)
+GETTER(glGetFramebufferAttachmentParameteriv, params)
+GETTER(glGetVertexAttribfv, params)
+GETTER(glGetVertexAttribiv, params)
+GETTER(glGetVertexAttribPointerv, pointer)
+GETTER(glGetUniformfv, params)
+GETTER(glGetUniformiv, params)
+GETTER(glGetPointerv, params)
+GETTER(glGetLightfv, params)
+GETTER(glGetLightxv, params)
+GETTER(glGetMaterialfv, params)
+GETTER(glGetMaterialxv, params)
+GETTER(glGetTexEnvfv, params)
+GETTER(glGetTexEnviv, params)
+GETTER(glGetTexEnvxv, params)
+GETTER(glGetClipPlanef, equation)
+GETTER(glGetClipPlanex, equation)
+#undef GETTER
+
+#ifndef NOEGL
+#define NULL_HANDLE ((void*)(uintptr_t)1)
+static EGLContext null_context = EGL_NO_CONTEXT;
+static EGLSurface null_draw = EGL_NO_SURFACE;
+static EGLSurface null_read = EGL_NO_SURFACE;
+
+#define STUB(name) static EGLBoolean null_##name() { COUNT(name); return EGL_TRUE; }
+NULLEGL_STUBS(STUB)
+#undef STUB
+
+static EGLBoolean null_eglInitialize(EGLDisplay dpy, EGLint *major, EGLint *minor) {
+    COUNT(eglInitialize);
+    if(major) *major = 1;
+    if(minor) *minor = 4;
+    return EGL_TRUE;
+}
+static EGLDisplay null_eglGetDisplay(EGLNativeDisplayType display_id) { COUNT(eglGetDisplay); return NULL_HANDLE; }
+static EGLDisplay null_eglGetPlatformDisplay(EGLenum platform, void *native_display, const EGLint *attrib_list) { COUNT(eglGetPlatformDisplay); return NULL_HANDLE; }
+
+static EGLBoolean null_eglChooseConfig(EGLDisplay dpy, const EGLint *attrib_list, EGLConfig *configs, EGLint config_size, EGLint *num_config) {
+    COUNT(eglChooseConfig);
+    if(configs && config_size>0)
+        configs[0] = NULL_HANDLE;
+    if(num_config) *num_config = 1;
+    return EGL_TRUE;
+}
+
+static EGLBoolean null_eglGetConfigs(EGLDisplay dpy, EGLConfig *configs, EGLint config_size, EGLint *num_config) {
+    COUNT(eglGetConfigs);
+    if(configs && config_size>0)
+        configs[0] = NULL_HANDLE;
+    if(num_config) *num_config = 1;
+    return EGL_TRUE;
+}
+
+static EGLBoolean null_eglGetConfigAttrib(EGLDisplay dpy, EGLConfig config, EGLint attribute, EGLint *value) {
+    COUNT(eglGetConfigAttrib);
+    switch(attribute) {
+        case EGL_RED_SIZE:
+        case EGL_GREEN_SIZE:
+        case EGL_BLUE_SIZE:
+        case EGL_ALPHA_SIZE:
+        case EGL_STENCIL_SIZE: *value = 8; break;
+        case EGL_BUFFER_SIZE: *value = 32; break;
+        case EGL_DEPTH_SIZE: *value = 24; break;
+        case EGL_CONFIG_ID: *value = 1; break;
+        case EGL_SURFACE_TYPE: *value = EGL_WINDOW_BIT|EGL_PBUFFER_BIT|EGL_PIXMAP_BIT; break;
+        case EGL_RENDERABLE_TYPE: *value = EGL_OPENGL_ES_BIT|EGL_OPENGL_ES2_BIT; break;
+        case EGL_MAX_PBUFFER_WIDTH:
+        case EGL_MAX_PBUFFER_HEIGHT: *value = null_maxsize; break;
+        default: *value = 0;
+    }
+    return EGL_TRUE;
+}
+
+static EGLContext null_eglCreateContext(EGLDisplay dpy, EGLConfig config, EGLContext share_context, const EGLint *attrib_list) { COUNT(eglCreateContext); return NULL_HANDLE; }
+static EGLSurface null_eglCreatePbufferSurface(EGLDisplay dpy, EGLConfig config, const EGLint *attrib_list) { COUNT(eglCreatePbufferSurface); return NULL_HANDLE; }
+static EGLSurface null_eglCreateWindowSurface(EGLDisplay dpy, EGLConfig config, EGLNativeWindowType win, const EGLint *attrib_list) { COUNT(eglCreateWindowSurface); return NULL_HANDLE; }
+static EGLSurface null_eglCreatePlatformWindowSurface(EGLDisplay dpy, EGLConfig config, void *native_window, const EGLint *attrib_list) { COUNT(eglCreatePlatformWindowSurface); return NULL_HANDLE; }
+static EGLSurface null_eglCreatePixmapSurface(EGLDisplay dpy, EGLConfig config, EGLNativePixmapType pixmap, const EGLint *attrib_list) { COUNT(eglCreatePixmapSurface); return NULL_HANDLE; }
+static EGLSurface null_eglCreatePbufferFromClientBuffer(EGLDisplay dpy, EGLenum buftype, EGLClientBuffer buffer, EGLConfig config, const EGLint *attrib_list) { COUNT(eglCreatePbufferFromClientBuffer); return NULL_HANDLE; }
+
+static EGLBoolean null_eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx) {
+    COUNT(eglMakeCurrent);
+    null_context = ctx;
+    null_draw = draw;
+    null_read = read;
+    return EGL_TRUE;
+}
+static EGLContext null_eglGetCurrentContext() { COUNT(eglGetCurrentContext); return null_context; }
+static EGLDisplay null_eglGetCurrentDisplay() { COUNT(eglGetCurrentDisplay); return null_context?NULL_HANDLE:EGL_NO_DISPLAY; }
+static EGLSurface null_eglGetCurrentSurface(EGLint readdraw) { COUNT(eglGetCurrentSurface); return (readdraw==EGL_READ)?null_read:null_draw; }
+
+static const char* null_eglQueryString(EGLDisplay dpy, EGLint name) {
+    COUNT(eglQueryString);
+    switch(name) {
+        case EGL_VENDOR: return "gl4es";
+        case EGL_VERSION: return "1.4 null";
+        case EGL_CLIENT_APIS: return "OpenGL_ES";
+    }
+    return "";
+}
+
+static EGLBoolean null_eglQueryContext(EGLDisplay dpy, EGLContext ctx, EGLint attribute, EGLint *value) {
+    COUNT(eglQueryContext);
+    *value = (attribute==EGL_CONTEXT_CLIENT_VERSION)?hardext.esversion:0;
+    return EGL_TRUE;
+}
+
+static EGLBoolean null_eglQuerySurface(EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint *value) {
+    COUNT(eglQuerySurface);
+    switch(attribute) {
+        case EGL_WIDTH: *value = null_viewport[2]; break;
+        case EGL_HEIGHT: *value = null_viewport[3]; break;
+        default: *value = 0;
+    }
+    return EGL_TRUE;
+}
+
+static EGLenum null_eglQueryAPI() { COUNT(eglQueryAPI); return EGL_OPENGL_ES_API; }
+static EGLint null_eglGetError() { COUNT(eglGetError); return EGL_SUCCESS; }
+static __eglMustCastToProperFunctionPointerType null_eglGetProcAddress(const char *procname) {
+    COUNT(eglGetProcAddress);
+    return (__eglMustCastToProperFunctionPointerType)nullgles_getProcAddress(procname);
+}
+
+static EGLBoolean null_eglSwapBuffers(EGLDisplay dpy, EGLSurface surface) {
+    COUNT(eglSwapBuffers);
+    ++null_counters.frames;
+    return EGL_TRUE;
+}
+#endif // NOEGL
+
+// ********* Lookup *********
+
+typedef struct {
+    const char *name;
+    void *func;
+} null_entry_t;
+
+static const null_entry_t null_entries[] = {
+#define ENTRY(name) {#name, (void*)null_##name},
+    ALL_ENTRIES(ENTRY)
+#undef ENTRY
+};
+
+static int find_entry(const char *name) {
+    for (int i=0; i<NULL_LAST; ++i)
+        if(strcmp(null_entries[i].name, name)==0)
+            return i;
+    return -1;
+}
+
+void* APIENTRY_GL4ES nullgles_getProcAddress(const char *name) {
+    if(!name)
+        return NULL;
+    int i = find_entry(name);
+    if(i<0) {
+        // OES / EXT / ARB variant of a core function
+        int l = strlen(name);
+        if(l>3 && (!strcmp(name+l-3, "OES") || !strcmp(name+l-3, "EXT") || !strcmp(name+l-3, "ARB"))) {
+            char buff[100];
+            if(l-3<sizeof(buff)) {
+                memcpy(buff, name, l-3);
+                buff[l-3] = '\0';
+                i = find_entry(buff);
+            }
+        }
+    }
+    return (i<0)?NULL:null_entries[i].func;
+}
+
+void nullgles_init(int mode) {
+    null_mode = mode;
+    memset(null_calls, 0, sizeof(null_calls));
+    memset(&null_counters, 0, sizeof(null_counters));
+    // fake capabilities
+    const char *ext = GetEnvVar("LIBGL_NULLGLES_EXT");
+    if(!ext) ext = null_default_ext;
+    // extensions are detected with a trailing space
+    null_ext = (char*)malloc(strlen(ext)+2);
+    strcpy(null_ext, ext);
+    if(strlen(ext) && ext[strlen(ext)-1]!=' ')
+        strcat(null_ext, " ");
+    const char *vendor = GetEnvVar("LIBGL_NULLGLES_VENDOR");
+    null_vendor = strdup(vendor?vendor:"gl4es null");
+    null_maxsize = ReturnEnvVarIntDef("LIBGL_NULLGLES_MAXSIZE", 4096);
+    null_texunits = ReturnEnvVarIntDef("LIBGL_NULLGLES_TEXUNITS", 8);
+    null_vcache = ReturnEnvVarIntDef("LIBGL_NULLGLES_VCACHE", 0);
+    if(null_vcache<0) null_vcache = 0;
+    if(null_vcache>NULL_VCACHE_MAX) null_vcache = NULL_VCACHE_MAX;
+    if(null_vcache && !null_buffers)
+        null_buffers = kh_init(nullbuffers);
+    null_prgbin = (strstr(null_ext, "GL_OES_get_program_binary ") || strstr(null_ext, "GL_OES_get_program "))?1:0;
+    int w, h;
+    if(GetEnvVarFmt("LIBGL_NULLGLES_SIZE", "%dx%d", &w, &h)==2) {
+        null_viewport[2] = null_scissor[2] = w;
+        null_viewport[3] = null_scissor[3] = h;
+    }
+    // plug the null backend in the loader
+    gles_getProcAddress = nullgles_getProcAddress;
+    gles = egl = (void*)(~(uintptr_t)0);
+}
+
+void APIENTRY_GL4ES nullgles_getcounters(nullgles_counters_t *counters) {
+    memcpy(counters, &null_counters, sizeof(null_counters));
+}
+
+unsigned long APIENTRY_GL4ES nullgles_callcount(const char *name) {
+    if(!name)
+        return null_counters.calls;
+    int i = find_entry(name);
+    return (i<0)?0:null_calls[i];
+}
+
+void APIENTRY_GL4ES nullgles_reset() {
+    memset(null_calls, 0, sizeof(null_calls));
+    memset(&null_counters, 0, sizeof(null_counters));
+}
+
+void nullgles_print_stats() {
+    if(!null_mode)
+        return;
+    SHUT_LOGD("null GLES backend: %lu calls, %lu draws, %lu vertices, %lu texture bytes, %lu buffer bytes, %lu programs, %lu frames\n",
+        null_counters.calls, null_counters.draws, null_counters.vertices, null_counters.texbytes,
+        null_counters.bufbytes, null_counters.programs, null_counters.frames);
+    if(null_vcache && null_counters.vcache_triangles)
+        SHUT_LOGD("null GLES backend: FIFO-%d vertex cache, %lu triangles, %lu misses, %.3f misses/triangle\n",
+            null_vcache, null_counters.vcache_triangles, null_counters.vcache_misses,
+            (double)null_counters.vcache_misses/null_counters.vcache_triangles);
+    for (int i=0; i<NULL_LAST; ++i)
+        if(null_calls[i])
+            SHUT_LOGD_NOPREFIX("  %-40s %lu\n", null_entries[i].name, null_calls[i]);
+}
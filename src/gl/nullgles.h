@@ -0,0 +1,33 @@
+#ifndef _GL4ES_NULLGLES_H_
+#define _GL4ES_NULLGLES_H_
+
+#include "gles.h"
+#include "attributes.h"
+
+// Headless "null" GLES backend: every GLES / EGL entry point used by gl4es is a stub
+// that only counts (and optionally logs) its calls, so the CPU cost of gl4es itself
+// can be measured without any GPU or driver.
+
+typedef struct {
+    unsigned long calls;      // total number of GLES / EGL calls
+    unsigned long draws;      // glDrawArrays / glDrawElements / glMultiDraw* / glDrawTex* calls
+    unsigned long vertices;   // vertices (or indices) submitted by the draws
+    unsigned long texbytes;   // bytes sent through glTex(Sub)Image2D and glCompressedTex(Sub)Image2D
+    unsigned long bufbytes;   // bytes sent through glBuffer(Sub)Data
+    unsigned long programs;   // programs linked (including glProgramBinary)
+    unsigned long frames;     // eglSwapBuffers calls
+    unsigned long vcache_triangles; // triangles that went through the vertex cache simulation (LIBGL_NULLGLES_VCACHE)
+    unsigned long vcache_misses;    // vertices of those triangles that missed the cache (so were transformed)
+} nullgles_counters_t;
+
+// mode 1 = count calls, mode 2 = also log every call
+void nullgles_init(int mode);
+void* APIENTRY_GL4ES nullgles_getProcAddress(const char *name);
+
+// exported, for gl4es_bench
+NonAliasExportDecl(void,nullgles_getcounters,(nullgles_counters_t *counters));
+NonAliasExportDecl(unsigned long,nullgles_callcount,(const char *name));
+NonAliasExportDecl(void,nullgles_reset,());
+void nullgles_print_stats();
+
+#endif // _GL4ES_NULLGLES_H_
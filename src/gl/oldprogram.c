@@ -223,6 +223,7 @@ void APIENTRY_GL4ES gl4es_glBindProgramARB(GLenum target, GLuint program) {
         case GL_VERTEX_PROGRAM_ARB:
             if(program) {
                 noerrorShimNoPurge();
+                glstate->fpe_dirty = 1;
                 if(glstate->fpe_state)
                     glstate->fpe_state->vertex_prg_id = program;
                 glstate->glsl->vtx_prog = old;
@@ -248,6 +249,7 @@ void APIENTRY_GL4ES gl4es_glBindProgramARB(GLenum target, GLuint program) {
             } else {
                 noerrorShimNoPurge();
                 glstate->glsl->vtx_prog = NULL;
+                glstate->fpe_dirty = 1;
                 if(glstate->fpe_state)
                     glstate->fpe_state->vertex_prg_id = 0;
             }
@@ -255,6 +257,7 @@ void APIENTRY_GL4ES gl4es_glBindProgramARB(GLenum target, GLuint program) {
         case GL_FRAGMENT_PROGRAM_ARB:
             if(program) {
                 noerrorShimNoPurge();
+                glstate->fpe_dirty = 1;
                 if(glstate->fpe_state)
                     glstate->fpe_state->fragment_prg_id = program;
                 glstate->glsl->frg_prog = old;
@@ -280,6 +283,7 @@ void APIENTRY_GL4ES gl4es_glBindProgramARB(GLenum target, GLuint program) {
             } else {
                 noerrorShimNoPurge();
                 glstate->glsl->frg_prog = NULL;
+                glstate->fpe_dirty = 1;
                 if(glstate->fpe_state)
                     glstate->fpe_state->fragment_prg_id = 0;
             }
@@ -6,6 +6,8 @@
 #include "gl4es.h"
 #include "glstate.h"
 #include "debug.h"
+#include "stats.h"
+#include "texthreads.h"
 
 #ifdef __BIG_ENDIAN__
 #define GL_INT8_REV     GL_UNSIGNED_INT_8_8_8_8
@@ -764,10 +766,418 @@ bool quarter_pixel(const GLvoid *src[16],
     #undef write_each
 }
 
-bool pixel_convert(const GLvoid *src, GLvoid **dst,
+// Fast paths for the common conversions: one row converter per (format, type) pair,
+// picked from pixel_kernels[] by pixel_convert. Everything else goes through remap_pixel.
+typedef void (*pixel_row_t)(const GLubyte *src, GLubyte *dst, GLuint width);
+
+typedef struct {
+    GLenum src_format, src_type;
+    GLenum dst_format, dst_type;
+    pixel_row_t row;
+} pixel_kernel_t;
+
+#if (defined(__SSE2__) || defined(__ARM_NEON)) && !defined(__BIG_ENDIAN__)
+#define PIXEL_SIMD
+#if defined(__SSE2__)
+#include <emmintrin.h>
+typedef __m128i pvec_t;
+#define V_LOAD(p)       _mm_loadu_si128((const __m128i*)(p))
+#define V_STORE(p, v)   _mm_storeu_si128((__m128i*)(p), v)
+#define V_SET(x)        _mm_set1_epi32(x)
+#define V_AND(a, b)     _mm_and_si128(a, b)
+#define V_OR(a, b)      _mm_or_si128(a, b)
+#define V_ADD(a, b)     _mm_add_epi32(a, b)
+#define V_SHL(a, n)     _mm_slli_epi32(a, n)
+#define V_SHR(a, n)     _mm_srli_epi32(a, n)
+// 2x 4 x 32bits (values < 0x10000) -> 8 x 16bits
+#define V_STORE16(p, a, b) _mm_storeu_si128((__m128i*)(p), _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16)))
+#else
+#include <arm_neon.h>
+typedef uint32x4_t pvec_t;
+#define V_LOAD(p)       vreinterpretq_u32_u8(vld1q_u8((const uint8_t*)(p)))
+#define V_STORE(p, v)   vst1q_u8((uint8_t*)(p), vreinterpretq_u8_u32(v))
+#define V_SET(x)        vdupq_n_u32(x)
+#define V_AND(a, b)     vandq_u32(a, b)
+#define V_OR(a, b)      vorrq_u32(a, b)
+#define V_ADD(a, b)     vaddq_u32(a, b)
+#define V_SHL(a, n)     vshlq_n_u32(a, n)
+#define V_SHR(a, n)     vshrq_n_u32(a, n)
+#define V_STORE16(p, a, b) vst1q_u8((uint8_t*)(p), vreinterpretq_u8_u16(vcombine_u16(vmovn_u32(a), vmovn_u32(b))))
+#endif
+
+// the 32bits kernels work on 4 pixels (one little endian GLuint each) per vector
+static inline pvec_t v_swap_rb(pvec_t p) {
+    return V_OR(V_AND(p, V_SET(0xff00ff00)), V_OR(V_AND(V_SHR(p, 16), V_SET(0xff)), V_SHL(V_AND(p, V_SET(0xff)), 16)));
+}
+static inline pvec_t v_to565(pvec_t p) {
+    return V_OR(V_SHL(V_AND(p, V_SET(0xf8)), 8), V_OR(V_SHR(V_AND(p, V_SET(0xfc00)), 5), V_SHR(V_AND(p, V_SET(0xf80000)), 19)));
+}
+static inline pvec_t v_to5551(pvec_t p) {
+    // (a+255)>>8 is 1 for any non 0 alpha
+    return V_OR(V_OR(V_SHL(V_AND(p, V_SET(0xf8)), 8), V_SHR(V_AND(p, V_SET(0xf800)), 5)),
+                V_OR(V_SHR(V_AND(p, V_SET(0xf80000)), 18), V_SHR(V_ADD(V_SHR(p, 24), V_SET(255)), 8)));
+}
+static inline pvec_t v_to4444(pvec_t p) {
+    return V_OR(V_OR(V_SHR(p, 28), V_AND(V_SHR(p, 16), V_SET(0xf0))),
+                V_OR(V_SHR(V_AND(p, V_SET(0xf000)), 4), V_SHL(V_AND(p, V_SET(0xf0)), 8)));
+}
+static inline pvec_t v_reverse(pvec_t p) {
+#if defined(__SSE2__)
+    return V_OR(V_OR(V_SHR(p, 24), V_AND(V_SHR(p, 8), V_SET(0xff00))),
+                V_OR(V_AND(V_SHL(p, 8), V_SET(0xff0000)), V_SHL(p, 24)));
+#else
+    return vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(p)));
+#endif
+}
+
+// 4 bytes -> 4 bytes, 4 pixels at a time. Returns the number of pixels done
+#define SIMD_ROW32(NAME, OP) \
+static GLuint NAME(const GLubyte *src, GLubyte *dst, GLuint width) { \
+    GLuint j = 0; \
+    for (; j+4 <= width; j+=4, src+=16, dst+=16) \
+        V_STORE(dst, OP(V_LOAD(src))); \
+    return j; \
+}
+// 4 bytes -> 2 bytes, 8 pixels at a time
+#define SIMD_ROW16(NAME, OP) \
+static GLuint NAME(const GLubyte *src, GLubyte *dst, GLuint width) { \
+    GLuint j = 0; \
+    for (; j+8 <= width; j+=8, src+=32, dst+=16) \
+        V_STORE16(dst, OP(V_LOAD(src)), OP(V_LOAD(src+16))); \
+    return j; \
+}
+#define v_bgra_to565(p)     v_to565(v_swap_rb(p))
+#define v_bgra_to5551(p)    v_to5551(v_swap_rb(p))
+#define v_bgra_to4444(p)    v_to4444(v_swap_rb(p))
+SIMD_ROW32(simd_swap_rb, v_swap_rb)
+SIMD_ROW32(simd_reverse, v_reverse)
+SIMD_ROW16(simd_rgba_to565, v_to565)
+SIMD_ROW16(simd_bgra_to565, v_bgra_to565)
+SIMD_ROW16(simd_rgba_to5551, v_to5551)
+SIMD_ROW16(simd_bgra_to5551, v_bgra_to5551)
+SIMD_ROW16(simd_rgba_to4444, v_to4444)
+SIMD_ROW16(simd_bgra_to4444, v_bgra_to4444)
+#undef v_bgra_to565
+#undef v_bgra_to5551
+#undef v_bgra_to4444
+#undef SIMD_ROW32
+#undef SIMD_ROW16
+
+// 1555 (REV) -> 5551 is a 16bits rotation, 8 pixels at a time
+static GLuint simd_rotate16(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    for (; j+8 <= width; j+=8, src+=16, dst+=16) {
+#if defined(__SSE2__)
+        __m128i v = _mm_loadu_si128((const __m128i*)src);
+        _mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_srli_epi16(v, 15), _mm_slli_epi16(v, 1)));
+#else
+        uint16x8_t v = vld1q_u16((const uint16_t*)src);
+        vst1q_u16((uint16_t*)dst, vorrq_u16(vshrq_n_u16(v, 15), vshlq_n_u16(v, 1)));
+#endif
+    }
+    return j;
+}
+
+// L -> RGBA, 16 pixels at a time
+static GLuint simd_l_to_rgba(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+#if defined(__SSE2__)
+    const __m128i ff = _mm_set1_epi8(-1);
+    for (; j+16 <= width; j+=16, src+=16, dst+=64) {
+        __m128i l = _mm_loadu_si128((const __m128i*)src);
+        __m128i ll = _mm_unpacklo_epi8(l, l), la = _mm_unpacklo_epi8(l, ff);
+        _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(ll, la));
+        _mm_storeu_si128((__m128i*)(dst+16), _mm_unpackhi_epi16(ll, la));
+        ll = _mm_unpackhi_epi8(l, l); la = _mm_unpackhi_epi8(l, ff);
+        _mm_storeu_si128((__m128i*)(dst+32), _mm_unpacklo_epi16(ll, la));
+        _mm_storeu_si128((__m128i*)(dst+48), _mm_unpackhi_epi16(ll, la));
+    }
+#else
+    uint8x16x4_t v;
+    v.val[3] = vdupq_n_u8(255);
+    for (; j+16 <= width; j+=16, src+=16, dst+=64) {
+        v.val[0] = v.val[1] = v.val[2] = vld1q_u8(src);
+        vst4q_u8(dst, v);
+    }
+#endif
+    return j;
+}
+#endif // PIXEL_SIMD
+
+// SIMD_PREFIX(fn, src_size, dst_size): let the SIMD kernel fn do the beginning of the row
+#ifdef PIXEL_SIMD
+#define SIMD_PREFIX(fn, ss, ds) \
+    GLuint j = fn(src, dst, width); \
+    src += j*(ss); dst += j*(ds);
+#else
+#define SIMD_PREFIX(fn, ss, ds) \
+    GLuint j = 0;
+#endif
+#define ROW_LOOP(ss, ds) for (; j < width; ++j, src += (ss), dst += (ds))
+
+// BGRA <-> RGBA
+static void row_swap_rb(const GLubyte *src, GLubyte *dst, GLuint width) {
+    SIMD_PREFIX(simd_swap_rb, 4, 4)
+    ROW_LOOP(4, 4) {
+        const GLuint tmp = *(const GLuint*)src;
+        #ifdef __BIG_ENDIAN__
+        *(GLuint*)dst = (tmp&0x00ff00ff) | ((tmp&0x0000ff00)<<16) | ((tmp&0xff000000)>>16);
+        #else
+        *(GLuint*)dst = (tmp&0xff00ff00) | ((tmp&0x00ff0000)>>16) | ((tmp&0x000000ff)<<16);
+        #endif
+    }
+}
+// GL_UNSIGNED_INT_8_8_8_8 <-> GL_UNSIGNED_INT_8_8_8_8_REV
+static void row_reverse(const GLubyte *src, GLubyte *dst, GLuint width) {
+    SIMD_PREFIX(simd_reverse, 4, 4)
+    ROW_LOOP(4, 4) {
+        dst[0] = src[3]; dst[1] = src[2]; dst[2] = src[1]; dst[3] = src[0];
+    }
+}
+// BGRA1555 -> RGBA5551
+static void row_1555rev_to_5551(const GLubyte *src, GLubyte *dst, GLuint width) {
+    SIMD_PREFIX(simd_rotate16, 2, 2)
+    ROW_LOOP(2, 2) {
+        // invert 1555/BGRA to 5551/RGBA (0x1f / 0x3e0 / 7c00)
+        const GLushort tmp = *(const GLushort*)src;
+        *(GLushort*)dst = ((tmp&0x8000)>>15) | ((tmp&0x7fff)<<1);
+    }
+}
+// L -> RGBA
+static void row_l_to_rgba(const GLubyte *src, GLubyte *dst, GLuint width) {
+    SIMD_PREFIX(simd_l_to_rgba, 1, 4)
+    ROW_LOOP(1, 4) {
+        #ifdef __BIG_ENDIAN__
+        dst[1] = dst[2] = dst[3] = *src;
+        dst[0] = 255;
+        #else
+        dst[0] = dst[1] = dst[2] = *src;
+        dst[3] = 255;
+        #endif
+    }
+}
+// L -> RGB
+static void row_l_to_rgb(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(1, 3)
+        dst[0] = dst[1] = dst[2] = *src;
+}
+// RGBA / BGRA -> LA
+#ifdef __BIG_ENDIAN__
+#define LUM(R, G, B) (((int)src[3-(R)])*77 + ((int)src[3-(G)])*151 + ((int)src[3-(B)])*28)
+#define ALPHA_BYTE 0
+#else
+#define LUM(R, G, B) (((int)src[R])*77 + ((int)src[G])*151 + ((int)src[B])*28)
+#define ALPHA_BYTE 3
+#endif
+static void row_rgba_to_la(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(4, 2)
+        *(GLushort*)dst = (LUM(0, 1, 2)&0xff00)>>8 | (src[ALPHA_BYTE]<<8);
+}
+static void row_bgra_to_la(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(4, 2)
+        *(GLushort*)dst = (LUM(2, 1, 0)&0xff00)>>8 | (src[ALPHA_BYTE]<<8);
+}
+// RGB(A) / BGR(A) -> L
+static void row_rgba_to_l(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(4, 1)
+        *dst = LUM(0, 1, 2)>>8;
+}
+static void row_rgb_to_l(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(3, 1)
+        *dst = LUM(0, 1, 2)>>8;
+}
+static void row_bgra_to_l(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(4, 1)
+        *dst = LUM(2, 1, 0)>>8;
+}
+static void row_bgr_to_l(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(3, 1)
+        *dst = LUM(2, 1, 0)>>8;
+}
+#undef LUM
+#undef ALPHA_BYTE
+// BGR(A) -> RGB, BGR -> RGBA, RGBA -> RGB
+static void row_bgr_to_rgb(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(3, 3) {
+        dst[0] = src[2]; dst[1] = src[1]; dst[2] = src[0];
+    }
+}
+static void row_bgra_to_rgb(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(4, 3) {
+        dst[0] = src[2]; dst[1] = src[1]; dst[2] = src[0];
+    }
+}
+static void row_bgr_to_rgba(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(3, 4) {
+        dst[0] = src[2]; dst[1] = src[1]; dst[2] = src[0]; dst[3] = 255;
+    }
+}
+static void row_rgba_to_rgb(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(4, 3) {
+        dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2];
+    }
+}
+// RGB(A) / BGR(A) -> RGB565, RGBA / BGRA -> RGBA5551 and RGBA4444 (R, G, B are the byte index of each component)
+#define PACK565(R, G, B)  (((GLushort)(src[B]&0xf8)>>3) | ((GLushort)(src[G]&0xfc)<<3) | ((GLushort)(src[R]&0xf8)<<8))
+#define PACK5551(R, G, B) (((GLushort)(src[B]&0xf8)>>2) | ((GLushort)(src[G]&0xf8)<<3) | ((GLushort)(src[R]&0xf8)<<8) | (src[3]?1:0))
+#define PACK4444(R, G, B) (((GLushort)(src[3]&0xf0)>>4) | ((GLushort)(src[B]&0xf0)) | ((GLushort)(src[G]&0xf0)<<4) | ((GLushort)(src[R]&0xf0)<<8))
+static void row_rgba_to_565(const GLubyte *src, GLubyte *dst, GLuint width) {
+    SIMD_PREFIX(simd_rgba_to565, 4, 2)
+    ROW_LOOP(4, 2)
+        *(GLushort*)dst = PACK565(0, 1, 2);
+}
+static void row_bgra_to_565(const GLubyte *src, GLubyte *dst, GLuint width) {
+    SIMD_PREFIX(simd_bgra_to565, 4, 2)
+    ROW_LOOP(4, 2)
+        *(GLushort*)dst = PACK565(2, 1, 0);
+}
+static void row_rgb_to_565(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(3, 2)
+        *(GLushort*)dst = PACK565(0, 1, 2);
+}
+static void row_bgr_to_565(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(3, 2)
+        *(GLushort*)dst = PACK565(2, 1, 0);
+}
+static void row_rgba_to_5551(const GLubyte *src, GLubyte *dst, GLuint width) {
+    SIMD_PREFIX(simd_rgba_to5551, 4, 2)
+    ROW_LOOP(4, 2)
+        *(GLushort*)dst = PACK5551(0, 1, 2);
+}
+static void row_bgra_to_5551(const GLubyte *src, GLubyte *dst, GLuint width) {
+    SIMD_PREFIX(simd_bgra_to5551, 4, 2)
+    ROW_LOOP(4, 2)
+        *(GLushort*)dst = PACK5551(2, 1, 0);
+}
+static void row_rgba_to_4444(const GLubyte *src, GLubyte *dst, GLuint width) {
+    SIMD_PREFIX(simd_rgba_to4444, 4, 2)
+    ROW_LOOP(4, 2)
+        *(GLushort*)dst = PACK4444(0, 1, 2);
+}
+static void row_bgra_to_4444(const GLubyte *src, GLubyte *dst, GLuint width) {
+    SIMD_PREFIX(simd_bgra_to4444, 4, 2)
+    ROW_LOOP(4, 2)
+        *(GLushort*)dst = PACK4444(2, 1, 0);
+}
+#undef PACK565
+#undef PACK5551
+#undef PACK4444
+// BGRA4444 (REV) -> RGBA
+static void row_4444rev_to_rgba(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(2, 4) {
+        const GLushort pix = *(const GLushort*)src;
+        dst[3] = ((pix>>12)&0x0f)<<4;
+        dst[2] = ((pix>>8)&0x0f)<<4;
+        dst[1] = ((pix>>4)&0x0f)<<4;
+        dst[0] = ((pix)&0x0f)<<4;
+    }
+}
+// RGBA5551 -> RGBA
+static void row_5551_to_rgba(const GLubyte *src, GLubyte *dst, GLuint width) {
+    GLuint j = 0;
+    ROW_LOOP(2, 4) {
+        const GLushort pix = *(const GLushort*)src;
+        dst[0] = ((pix>>11)&0x1f)<<3;
+        dst[1] = ((pix>>6)&0x1f)<<3;
+        dst[2] = ((pix>>1)&0x1f)<<3;
+        dst[3] = ((pix)&0x01)?255:0;
+    }
+}
+#undef SIMD_PREFIX
+#undef ROW_LOOP
+
+// GL_INT8_REV is already translated to GL_UNSIGNED_BYTE when the table is searched
+static const pixel_kernel_t pixel_kernels[] = {
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE, row_swap_rb},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_BGRA, GL_UNSIGNED_BYTE, row_swap_rb},
+    {GL_RGBA, GL_INT8, GL_RGBA, GL_UNSIGNED_BYTE, row_reverse},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_INT8, row_reverse},
+    {GL_BGRA, GL_INT8, GL_BGRA, GL_UNSIGNED_BYTE, row_reverse},
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_BGRA, GL_INT8, row_reverse},
+    {GL_BGRA, GL_UNSIGNED_SHORT_1_5_5_5_REV, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, row_1555rev_to_5551},
+    {GL_LUMINANCE, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE, row_l_to_rgba},
+    {GL_LUMINANCE, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_BYTE, row_l_to_rgb},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, row_rgba_to_la},
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, row_bgra_to_la},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_LUMINANCE, GL_UNSIGNED_BYTE, row_rgba_to_l},
+    {GL_RGB, GL_UNSIGNED_BYTE, GL_LUMINANCE, GL_UNSIGNED_BYTE, row_rgb_to_l},
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_LUMINANCE, GL_UNSIGNED_BYTE, row_bgra_to_l},
+    {GL_BGR, GL_UNSIGNED_BYTE, GL_LUMINANCE, GL_UNSIGNED_BYTE, row_bgr_to_l},
+    {GL_BGR, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_BYTE, row_bgr_to_rgb},
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_BYTE, row_bgra_to_rgb},
+    {GL_BGR, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE, row_bgr_to_rgba},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_BYTE, row_rgba_to_rgb},
+    {GL_RGB, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, row_rgb_to_565},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, row_rgba_to_565},
+    {GL_BGR, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, row_bgr_to_565},
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, row_bgra_to_565},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, row_rgba_to_5551},
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, row_bgra_to_5551},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, row_rgba_to_4444},
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, row_bgra_to_4444},
+    {GL_BGRA, GL_UNSIGNED_SHORT_4_4_4_4_REV, GL_RGBA, GL_UNSIGNED_BYTE, row_4444rev_to_rgba},
+    {GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, GL_RGBA, GL_UNSIGNED_BYTE, row_5551_to_rgba},
+};
+
+static pixel_row_t pixel_find_kernel(GLenum src_format, GLenum src_type, GLenum dst_format, GLenum dst_type) {
+    for (int i = 0; i < sizeof(pixel_kernels)/sizeof(pixel_kernels[0]); ++i) {
+        const pixel_kernel_t *k = &pixel_kernels[i];
+        if (k->src_type == src_type && k->dst_type == dst_type && k->src_format == src_format && k->dst_format == dst_format)
+            return k->row;
+    }
+    return NULL;
+}
+
+// a conversion job, split in bands of rows by texthreads_run
+typedef struct {
+    uintptr_t   src, dst;
+    GLuint      src_pitch, dst_pitch;
+    GLuint      width;
+    pixel_row_t row;
+    // generic path only
+    const colorlayout_t *src_color, *dst_color;
+    GLenum      src_type, dst_type;
+    GLsizei     src_stride, dst_stride;
+} pixel_job_t;
+
+static void convert_rows_kernel(void *arg, int first, int last) {
+    const pixel_job_t *job = (const pixel_job_t*)arg;
+    for (int i = first; i < last; i++)
+        job->row((const GLubyte*)(job->src+(uintptr_t)i*job->src_pitch), (GLubyte*)(job->dst+(uintptr_t)i*job->dst_pitch), job->width);
+}
+
+static void convert_rows_generic(void *arg, int first, int last) {
+    const pixel_job_t *job = (const pixel_job_t*)arg;
+    for (int i = first; i < last; i++) {
+        uintptr_t src_pos = job->src+(uintptr_t)i*job->src_pitch;
+        uintptr_t dst_pos = job->dst+(uintptr_t)i*job->dst_pitch;
+        for (int j = 0; j < job->width; j++) {
+            remap_pixel((const GLvoid *)src_pos, (GLvoid *)dst_pos,
+                            job->src_color, job->src_type, job->dst_color, job->dst_type);
+            src_pos += job->src_stride;
+            dst_pos += job->dst_stride;
+        }
+    }
+}
+
+static bool pixel_convert_internal(const GLvoid *src, GLvoid **dst,
                    GLuint width, GLuint height,
                    GLenum src_format, GLenum src_type,
-                   GLenum dst_format, GLenum dst_type, GLuint stride, GLuint align) {
+                   GLenum dst_format, GLenum dst_type, GLuint stride, GLuint align, int generic, int stats) {
     const colorlayout_t *src_color, *dst_color;
     GLuint pixels = width * height;
     if(src_type==GL_INT8_REV) src_type=GL_UNSIGNED_BYTE;
@@ -791,6 +1201,8 @@ bool pixel_convert(const GLvoid *src, GLvoid **dst,
         }
         if (*dst == NULL)        // alloc dst only if dst==NULL
             *dst = malloc(dst_size);
+        if (stats)
+            STATS_ADD(pixel_bytes, dst_size);
         if (stride)	// for in-place conversion
 			for (int yy=0; yy<height; yy++)
 				memcpy((char*)(*dst)+yy*dst_width2, (char*)src+yy*src_width, src_width);
@@ -809,348 +1221,15 @@ bool pixel_convert(const GLvoid *src, GLvoid **dst,
     GLsizei dst_stride = pixel_sizeof(dst_format, dst_type);
     if (*dst == src || *dst == NULL)
         *dst = malloc(dst_size);
+    if (stats)
+        STATS_ADD(pixel_bytes, dst_size);
     uintptr_t src_pos = widthalign((uintptr_t)src, align);
     uintptr_t dst_pos = widthalign((uintptr_t)*dst, align);
-    // fast optimized loop for common conversion cases first...
-    // TODO: Rewrite that with some Macro, it's obviously doable to simplify the reading (and writing) of all this
-    // simple BGRA <-> RGBA / UNSIGNED_BYTE 
-    if ((((src_format == GL_BGRA) && (dst_format == GL_RGBA)) || ((src_format == GL_RGBA) && (dst_format == GL_BGRA))) 
-        && (dst_type == GL_UNSIGNED_BYTE) && ((src_type == GL_UNSIGNED_BYTE))) {
-        GLuint tmp;
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				tmp = *(const GLuint*)src_pos;
-                #ifdef __BIG_ENDIAN__
-                *(GLuint*)dst_pos = (tmp&0x00ff00ff) | ((tmp&0x0000ff00)<<16) | ((tmp&0xff000000)>>16);
-                #else
-				*(GLuint*)dst_pos = (tmp&0xff00ff00) | ((tmp&0x00ff0000)>>16) | ((tmp&0x000000ff)<<16);
-                #endif
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // RGBA or BGRA with GL_INT_8_8_8_8 <-> GL_INT_8_8_8_8_REV
-    if((src_format==dst_format) && (src_format==GL_RGBA || src_format==GL_BGRA) && ((src_type==GL_INT8 && dst_type==GL_INT8_REV) || (src_type==GL_INT8_REV && dst_type==GL_INT8))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				((char*)dst_pos)[0] = ((char*)src_pos)[3];
-				((char*)dst_pos)[1] = ((char*)src_pos)[2];
-				((char*)dst_pos)[2] = ((char*)src_pos)[1];
-                ((char*)dst_pos)[3] = ((char*)src_pos)[0];
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    #ifdef __BIG_ENDIAN__
-    // RGBA or BGRA with GL_UNSIGNED_INT_8_8_8_8_REV <-> GL_UNSIGNED_BYTE
-    if((src_format==dst_format) && (src_format==GL_RGBA || src_format==GL_BGRA) && ((src_type==GL_UNSIGNED_INT_8_8_8_8_REV && dst_type==GL_UNSIGNED_BYTE) || (src_type==GL_UNSIGNED_BYTE && dst_type==GL_UNSIGNED_INT_8_8_8_8_REV))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				((char*)dst_pos)[0] = ((char*)src_pos)[3];
-				((char*)dst_pos)[1] = ((char*)src_pos)[2];
-				((char*)dst_pos)[2] = ((char*)src_pos)[1];
-                ((char*)dst_pos)[3] = ((char*)src_pos)[0];
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    #endif
-    // BGRA1555 -> RGBA5551
-    if ((src_format == GL_BGRA) && (dst_format == GL_RGBA) && (dst_type == GL_UNSIGNED_SHORT_5_5_5_1) && (src_type == GL_UNSIGNED_SHORT_1_5_5_5_REV)) {
-      GLushort tmp;
-      for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-          // invert 1555/BGRA to 5551/RGBA (0x1f / 0x3e0 / 7c00)
-          tmp=*(GLushort*)src_pos;
-          *(GLushort*)dst_pos = ((tmp&0x8000)>>15) | ((tmp&0x7fff)<<1);
-          src_pos += src_stride;
-          dst_pos += dst_stride;
-        }
-        dst_pos += dst_width;
-        src_pos += src_widthadj;
-      }
-      return true;
-    }
-    // L -> RGBA
-    if ((src_format == GL_LUMINANCE) && (dst_format == GL_RGBA) && (dst_type == GL_UNSIGNED_BYTE) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				//tmp = *(const GLuint*)src_pos;
-                unsigned char* byte_dst = (unsigned char*)dst_pos;
-                #ifdef __BIG_ENDIAN__
-                byte_dst[1] = byte_dst[2] = byte_dst[3] = *(GLubyte*)src_pos;
-                byte_dst[0] = 255;
-                #else
-                byte_dst[0] = byte_dst[1] = byte_dst[2] = *(GLubyte*)src_pos;
-                byte_dst[3] = 255;
-                #endif
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // L -> RGB
-    if ((src_format == GL_LUMINANCE) && (dst_format == GL_RGB) && (dst_type == GL_UNSIGNED_BYTE) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				//tmp = *(const GLuint*)src_pos;
-                unsigned char* byte_dst = (unsigned char*)dst_pos;
-                byte_dst[0] = byte_dst[1] = byte_dst[2] = *(GLubyte*)src_pos;
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // RGBA -> LA
-    if ((src_format == GL_RGBA) && (dst_format == GL_LUMINANCE_ALPHA) && (dst_type == GL_UNSIGNED_BYTE) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				//tmp = *(const GLuint*)src_pos;
-                unsigned char* byte_src = (unsigned char*)src_pos;
-                #ifdef __BIG_ENDIAN__
-                *(GLushort*)dst_pos = ((((int)byte_src[3])*77 + ((int)byte_src[2])*151 + ((int)byte_src[1])*28)&0xff00)>>8 | (byte_src[0]<<8);
-                #else
-                *(GLushort*)dst_pos = ((((int)byte_src[0])*77 + ((int)byte_src[1])*151 + ((int)byte_src[2])*28)&0xff00)>>8 | (byte_src[3]<<8);
-                #endif
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // BGRA -> LA
-    if ((src_format == GL_BGRA) && (dst_format == GL_LUMINANCE_ALPHA) && (dst_type == GL_UNSIGNED_BYTE) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				//tmp = *(const GLuint*)src_pos;
-                unsigned char* byte_src = (unsigned char*)src_pos;
-                #ifdef __BIG_ENDIAN__
-                *(GLushort*)dst_pos = ((((int)byte_src[1])*77 + ((int)byte_src[2])*151 + ((int)byte_src[3])*28)&0xff00)>>8 | (byte_src[0]<<8);
-                #else
-                *(GLushort*)dst_pos = ((((int)byte_src[2])*77 + ((int)byte_src[1])*151 + ((int)byte_src[0])*28)&0xff00)>>8 | (byte_src[3]<<8);
-                #endif
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // RGB(A) -> L
-    if (((src_format == GL_RGBA)||(src_format == GL_RGB)) && (dst_format == GL_LUMINANCE) && (dst_type == GL_UNSIGNED_BYTE) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				//tmp = *(const GLuint*)src_pos;
-                unsigned char* byte_src = (unsigned char*)src_pos;
-                #ifdef __BIG_ENDIAN__
-                *(unsigned char*)dst_pos = (((int)byte_src[3])*77 + ((int)byte_src[2])*151 + ((int)byte_src[1])*28)>>8;
-                #else
-                *(unsigned char*)dst_pos = (((int)byte_src[0])*77 + ((int)byte_src[1])*151 + ((int)byte_src[2])*28)>>8;
-                #endif
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // BGR(A) -> L
-    if (((src_format == GL_BGRA)||(src_format == GL_BGR)) && (dst_format == GL_LUMINANCE) && (dst_type == GL_UNSIGNED_BYTE) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				//tmp = *(const GLuint*)src_pos;
-                unsigned char* byte_src = (unsigned char*)src_pos;
-                #ifdef __BIG_ENDIAN__
-                *(unsigned char*)dst_pos = (((int)byte_src[1])*77 + ((int)byte_src[2])*151 + ((int)byte_src[3])*28)>>8;
-                #else
-                *(unsigned char*)dst_pos = (((int)byte_src[2])*77 + ((int)byte_src[1])*151 + ((int)byte_src[0])*28)>>8;
-                #endif
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // BGR(A) -> RGB
-    if (((src_format == GL_BGR)||(src_format == GL_BGRA)) && (dst_format == GL_RGB) && (dst_type == GL_UNSIGNED_BYTE) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				((char*)dst_pos)[0] = ((char*)src_pos)[2];
-				((char*)dst_pos)[1] = ((char*)src_pos)[1];
-				((char*)dst_pos)[2] = ((char*)src_pos)[0];
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // BGR -> RGBA
-    if (((src_format == GL_BGR)) && (dst_format == GL_RGBA) && (dst_type == GL_UNSIGNED_BYTE) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				((unsigned char*)dst_pos)[0] = ((unsigned char*)src_pos)[2];
-				((unsigned char*)dst_pos)[1] = ((unsigned char*)src_pos)[1];
-				((unsigned char*)dst_pos)[2] = ((unsigned char*)src_pos)[0];
-                ((unsigned char*)dst_pos)[3] = 255;
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // RGBA -> RGB
-    if ((src_format == GL_RGBA) && (dst_format == GL_RGB) && (dst_type == GL_UNSIGNED_BYTE) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				((char*)dst_pos)[0] = ((char*)src_pos)[0];
-				((char*)dst_pos)[1] = ((char*)src_pos)[1];
-				((char*)dst_pos)[2] = ((char*)src_pos)[2];
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // RGB(A) -> RGB565
-    if (((src_format == GL_RGB)||(src_format == GL_RGBA)) && (dst_format == GL_RGB) && (dst_type == GL_UNSIGNED_SHORT_5_6_5) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				*(GLushort*)dst_pos = ((GLushort)(((char*)src_pos)[2]&0xf8)>>(3)) | ((GLushort)(((char*)src_pos)[1]&0xfc)<<(5-2)) | ((GLushort)(((char*)src_pos)[0]&0xf8)<<(11-3));
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // BGR(A) -> RGB565
-    if (((src_format == GL_BGR) || (src_format == GL_BGRA)) && (dst_format == GL_RGB) && (dst_type == GL_UNSIGNED_SHORT_5_6_5) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				*(GLushort*)dst_pos = ((GLushort)(((char*)src_pos)[0]&0xf8)>>(3)) | ((GLushort)(((char*)src_pos)[1]&0xfc)<<(5-2)) | ((GLushort)(((char*)src_pos)[2]&0xf8)<<(11-3));
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // RGBA -> RGBA5551
-    if ((src_format == GL_RGBA) && (dst_format == GL_RGBA) && (dst_type == GL_UNSIGNED_SHORT_5_5_5_1) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				*(GLushort*)dst_pos = ((GLushort)(((char*)src_pos)[2]&0xf8)>>(3-1)) | ((GLushort)(((char*)src_pos)[1]&0xf8)<<(5-2)) | ((GLushort)(((char*)src_pos)[0]&0xf8)<<(10-2)) | ((GLushort)(((char*)src_pos)[3])?1:0);
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // BGRA -> RGBA5551
-    if ((src_format == GL_BGRA) && (dst_format == GL_RGBA) && (dst_type == GL_UNSIGNED_SHORT_5_5_5_1) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				*(GLushort*)dst_pos = ((GLushort)(((char*)src_pos)[0]&0xf8)>>(3-1)) | ((GLushort)(((char*)src_pos)[1]&0xf8)<<(5-2)) | ((GLushort)(((char*)src_pos)[2]&0xf8)<<(10-2)) | ((GLushort)(((char*)src_pos)[3])?1:0);
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // RGBA -> RGBA4444
-    if ((src_format == GL_RGBA) && (dst_format == GL_RGBA) && (dst_type == GL_UNSIGNED_SHORT_4_4_4_4) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				*(GLushort*)dst_pos = ((GLushort)(((char*)src_pos)[3]&0xf0))>>(4) | ((GLushort)(((char*)src_pos)[2]&0xf0)) | ((GLushort)(((char*)src_pos)[1]&0xf0))<<(4) | ((GLushort)(((char*)src_pos)[0]&0xf0))<<(8);
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // BGRA -> RGBA4444
-    if ((src_format == GL_BGRA) && (dst_format == GL_RGBA) && (dst_type == GL_UNSIGNED_SHORT_4_4_4_4) && ((src_type == GL_UNSIGNED_BYTE))) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-				*(GLushort*)dst_pos = ((GLushort)(((char*)src_pos)[3]&0xf0)>>(4)) | ((GLushort)(((char*)src_pos)[0]&0xf0)) | ((GLushort)(((char*)src_pos)[1]&0xf0)<<(4)) | ((GLushort)(((char*)src_pos)[2]&0xf0)<<(8));
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // BGRA4444 -> RGBA 
-    if ((src_format == GL_BGRA) && (dst_format == GL_RGBA) && (dst_type == GL_UNSIGNED_BYTE) && (src_type == GL_UNSIGNED_SHORT_4_4_4_4_REV)) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-                const GLushort pix = *(GLushort*)src_pos;
-                ((char*)dst_pos)[3] = ((pix>>12)&0x0f)<<4;
-                ((char*)dst_pos)[2] = ((pix>>8)&0x0f)<<4;
-                ((char*)dst_pos)[1] = ((pix>>4)&0x0f)<<4;
-                ((char*)dst_pos)[0] = ((pix)&0x0f)<<4;  
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
-        return true;
-    }
-    // RGBA5551 -> RGBA
-    if ((src_format == GL_RGBA) && (dst_format == GL_RGBA) && (dst_type == GL_UNSIGNED_BYTE) && (src_type == GL_UNSIGNED_SHORT_5_5_5_1)) {
-        for (int i = 0; i < height; i++) {
-			for (int j = 0; j < width; j++) {
-                const GLushort pix = *(GLushort*)src_pos;
-                ((unsigned char*)dst_pos)[0] = ((pix>>11)&0x1f)<<3;
-                ((unsigned char*)dst_pos)[1] = ((pix>>6)&0x1f)<<3;
-                ((unsigned char*)dst_pos)[2] = ((pix>>1)&0x1f)<<3;
-                ((unsigned char*)dst_pos)[3] = ((pix)&0x01)?255:0;  
-				src_pos += src_stride;
-				dst_pos += dst_stride;
-			}
-			dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
+    // fast optimized row converters for common conversion cases first...
+    pixel_job_t job = {src_pos, dst_pos, src_width, dst_width2, width};
+    job.row = generic?NULL:pixel_find_kernel(src_format, src_type, dst_format, dst_type);
+    if (job.row) {
+        texthreads_run(height, dst_size, convert_rows_kernel, &job);
         return true;
     }
 	if (! remap_pixel((const GLvoid *)src_pos, (GLvoid *)dst_pos,
@@ -1182,20 +1261,40 @@ bool pixel_convert(const GLvoid *src, GLvoid **dst,
             src_pos += src_widthadj;
         }
     } else {
-        for (int i = 0; i < height; i++) {
-            for (int j = 0; j < width; j++) {
-                remap_pixel((const GLvoid *)src_pos, (GLvoid *)dst_pos,
-                                src_color, src_type, dst_color, dst_type);
-                src_pos += src_stride;
-                dst_pos += dst_stride;
-            }
-            dst_pos += dst_width;
-            src_pos += src_widthadj;
-        }
+        job.src_color = src_color;
+        job.dst_color = dst_color;
+        job.src_type = src_type;
+        job.dst_type = dst_type;
+        job.src_stride = src_stride;
+        job.dst_stride = dst_stride;
+        texthreads_run(height, dst_size, convert_rows_generic, &job);
     }
 	return true;
 }
 
+bool pixel_convert(const GLvoid *src, GLvoid **dst,
+                   GLuint width, GLuint height,
+                   GLenum src_format, GLenum src_type,
+                   GLenum dst_format, GLenum dst_type, GLuint stride, GLuint align) {
+    return pixel_convert_internal(src, dst, width, height, src_format, src_type, dst_format, dst_type, stride, align, 0, 1);
+}
+
+bool pixel_convert_nostats(const GLvoid *src, GLvoid **dst,
+                   GLuint width, GLuint height,
+                   GLenum src_format, GLenum src_type,
+                   GLenum dst_format, GLenum dst_type, GLuint align) {
+    return pixel_convert_internal(src, dst, width, height, src_format, src_type, dst_format, dst_type, 0, align, 0, 0);
+}
+
+#ifdef PIXEL_BENCH
+GLboolean APIENTRY_GL4ES pixel_convert_bench(const GLvoid *src, GLvoid **dst,
+                   GLuint width, GLuint height,
+                   GLenum src_format, GLenum src_type,
+                   GLenum dst_format, GLenum dst_type, GLint generic) {
+    return pixel_convert_internal(src, dst, width, height, src_format, src_type, dst_format, dst_type, 0, 1, generic, 1);
+}
+#endif
+
 bool pixel_transform(const GLvoid *src, GLvoid **dst,
                    GLuint width, GLuint height,
                    GLenum src_format, GLenum src_type,
@@ -1227,6 +1326,76 @@ bool pixel_transform(const GLvoid *src, GLvoid **dst,
     return false;
 }
 
+// a scaling job, split in bands of destination rows by texthreads_run
+typedef struct {
+    uintptr_t   src, dst;
+    GLuint      width, height, new_width;
+    GLuint      pixel_size;
+    GLfloat     ratiox, ratioy;             // pixel_scale
+    const colorlayout_t *src_color;
+    GLenum      type;
+    int         dx, mx, dy, my;             // pixel_halfscale
+    const int   *dxs, *dys;                 // pixel_quarterscale
+} scale_job_t;
+
+static void scale_rows(void *arg, int first, int last) {
+    const scale_job_t *job = (const scale_job_t*)arg;
+    const GLuint pixel_size = job->pixel_size;
+    uintptr_t pos = job->dst + (uintptr_t)first*job->new_width*pixel_size;
+    for (int y = first; y < last; y++) {
+        int oldy = y*job->ratioy; if(oldy>=job->height) oldy=job->height-1;
+        for (int x = 0; x < job->new_width; x++) {
+            int oldx = x*job->ratiox; if(oldx>=job->width) oldx=job->width-1;
+            uintptr_t pixel = job->src + (oldx +
+                          oldy * job->width) * pixel_size;
+            memcpy((GLvoid *)pos, (GLvoid *)pixel, pixel_size);
+            pos += pixel_size;
+        }
+    }
+}
+
+static void halfscale_rows(void *arg, int first, int last) {
+    const scale_job_t *job = (const scale_job_t*)arg;
+    const GLuint pixel_size = job->pixel_size, width = job->width;
+    const int dx = job->dx, mx = job->mx, dy = job->dy, my = job->my;
+    const uintptr_t src = job->src;
+    uintptr_t pos = job->dst + (uintptr_t)first*job->new_width*pixel_size;
+    uintptr_t pix0, pix1, pix2, pix3;
+    for (int y = first; y < last; y++) {
+        for (int x = 0; x < job->new_width; x++) {
+            pix0 = src + ((x * mx) +
+                          (y * my) * width) * pixel_size;
+            pix1 = src + ((x * mx + dx) +
+                          (y * my) * width) * pixel_size;
+            pix2 = src + ((x * mx) +
+                          (y * my + dy) * width) * pixel_size;
+            pix3 = src + ((x * mx + dx) +
+                          (y * my + dy) * width) * pixel_size;
+            half_pixel((GLvoid *)pix0, (GLvoid *)pix1, (GLvoid *)pix2, (GLvoid *)pix3, (GLvoid *)pos, job->src_color, job->type);
+            pos += pixel_size;
+        }
+    }
+}
+
+static void quarterscale_rows(void *arg, int first, int last) {
+    const scale_job_t *job = (const scale_job_t*)arg;
+    const GLuint pixel_size = job->pixel_size, width = job->width;
+    uintptr_t pos = job->dst + (uintptr_t)first*job->new_width*pixel_size;
+    uintptr_t pix[16];
+    for (int y = first; y < last; y++) {
+        for (int x = 0; x < job->new_width; x++) {
+            for (int dx=0; dx<4; dx++) {
+                for (int dy=0; dy<4; dy++) {
+                    pix[dx+dy*4] = job->src + ((x * 4 + job->dxs[dx]) +
+                                          (y * 4 + job->dys[dy]) * width) * pixel_size;
+                }
+            }
+            quarter_pixel((const GLvoid **)pix, (GLvoid *)pos, job->src_color, job->type);
+            pos += pixel_size;
+        }
+    }
+}
+
 bool pixel_scale(const GLvoid *old, GLvoid **new,
                  GLuint width, GLuint height,
                  GLuint new_width, GLuint new_height,
@@ -1237,22 +1406,13 @@ bool pixel_scale(const GLvoid *old, GLvoid **new,
     ratioy = ((float)height)/new_height;
     //printf("scaling %ux%u -> %ux%u (%f/%f)\n", width, height, new_width, new_height, ratiox, ratioy);
     GLvoid *dst;
-    uintptr_t src, pos, pixel;
 
     pixel_size = pixel_sizeof(format, type);
     dst = malloc(pixel_size * new_width * new_height);
-    src = (uintptr_t)old;
-    pos = (uintptr_t)dst;
-    for (int y = 0; y < new_height; y++) {
-        int oldy = y*ratioy; if(oldy>=height) oldy=height-1;
-        for (int x = 0; x < new_width; x++) {
-            int oldx = x*ratiox; if(oldx>=width) oldx=width-1;
-            pixel = src + (oldx +
-                          oldy * width) * pixel_size;
-            memcpy((GLvoid *)pos, (GLvoid *)pixel, pixel_size);
-            pos += pixel_size;
-        }
-    }
+    scale_job_t job = {(uintptr_t)old, (uintptr_t)dst, width, height, new_width, pixel_size};
+    job.ratiox = ratiox;
+    job.ratioy = ratioy;
+    texthreads_run(new_height, pixel_size * new_width * new_height, scale_rows, &job);
     *new = dst;
     return true;
 }
@@ -1275,7 +1435,7 @@ bool pixel_halfscale(const GLvoid *old, GLvoid **new,
     const colorlayout_t *src_color;
     src_color = get_color_map(format);
     GLvoid *dst;
-    uintptr_t src, pos, pix0, pix1, pix2, pix3;
+    uintptr_t src, pos, pix0;
 
     pixel_size = pixel_sizeof(format, type);
     dst = malloc(pixel_size * new_width * new_height);
@@ -1303,20 +1463,12 @@ bool pixel_halfscale(const GLvoid *old, GLvoid **new,
         *new = dst;
         return 1;
     }
-    for (int y = 0; y < new_height; y++) {
-        for (int x = 0; x < new_width; x++) {
-            pix0 = src + ((x * mx) +
-                          (y * my) * width) * pixel_size;
-            pix1 = src + ((x * mx + dx) +
-                          (y * my) * width) * pixel_size;
-            pix2 = src + ((x * mx) +
-                          (y * my + dy) * width) * pixel_size;
-            pix3 = src + ((x * mx + dx) +
-                          (y * my + dy) * width) * pixel_size;
-            half_pixel((GLvoid *)pix0, (GLvoid *)pix1, (GLvoid *)pix2, (GLvoid *)pix3, (GLvoid *)pos, src_color, type);
-            pos += pixel_size;
-        }
-    }
+    scale_job_t job = {src, pos, width, height, new_width, pixel_size};
+    job.src_color = src_color;
+    job.type = type;
+    job.dx = dx; job.mx = mx;
+    job.dy = dy; job.my = my;
+    texthreads_run(new_height, pixel_size * new_width * new_height, halfscale_rows, &job);
     *new = dst;
     return 1;
 }
@@ -1406,18 +1558,12 @@ bool pixel_quarterscale(const GLvoid *old, GLvoid **new,
         *new = dst;
         return 1;
     }
-    for (int y = 0; y < new_height; y++) {
-        for (int x = 0; x < new_width; x++) {
-            for (int dx=0; dx<4; dx++) {
-                for (int dy=0; dy<4; dy++) {
-                    pix[dx+dy*4] = src + ((x * 4 + dxs[dx]) +
-                                          (y * 4 + dys[dy]) * width) * pixel_size;
-                }
-            }
-            quarter_pixel((const GLvoid **)pix, (GLvoid *)pos, src_color, type);
-            pos += pixel_size;
-        }
-    }
+    scale_job_t job = {src, pos, width, height, new_width, pixel_size};
+    job.src_color = src_color;
+    job.type = type;
+    job.dxs = dxs;
+    job.dys = dys;
+    texthreads_run(new_height, pixel_size * new_width * new_height, quarterscale_rows, &job);
     *new = dst;
     return true;
 }
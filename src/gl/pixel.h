@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include "gles.h"
+#include "attributes.h"
 
 typedef struct {
     GLenum type;
@@ -20,6 +21,17 @@ bool pixel_convert(const GLvoid *src, GLvoid **dst,
                    GLuint width, GLuint height,
                    GLenum src_format, GLenum src_type,
                    GLenum dst_format, GLenum dst_type, GLuint stride, GLuint align);
+// pixel_convert without updating the stats counters, for the LIBGL_TEXASYNC worker thread
+bool pixel_convert_nostats(const GLvoid *src, GLvoid **dst,
+                   GLuint width, GLuint height,
+                   GLenum src_format, GLenum src_type,
+                   GLenum dst_format, GLenum dst_type, GLuint align);
+
+#ifdef PIXEL_BENCH
+// exported, for gl4es_bench (PIXEL_BENCH builds only): pixel_convert (align 1), generic!=0 skips the fast paths and always uses remap_pixel
+NonAliasExportDecl(GLboolean,pixel_convert_bench,(const GLvoid *src, GLvoid **dst, GLuint width, GLuint height,
+                   GLenum src_format, GLenum src_type, GLenum dst_format, GLenum dst_type, GLint generic));
+#endif
 
 bool pixel_transform(const GLvoid *src, GLvoid **dst,
                    GLuint width, GLuint height,
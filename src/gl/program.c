@@ -5,8 +5,10 @@
 #include "../glx/hardext.h"
 #include "debug.h"
 #include "fpe.h"
+#include "fpe_cache.h"
 #include "gl4es.h"
 #include "glstate.h"
+#include "init.h"
 #include "loader.h"
 #include "shaderconv.h"
 #include "fpe_shader.h"
@@ -157,9 +159,12 @@ void deleteProgram(program_t *glprogram, khint_t k_program) {
         kh_destroy(uniformlist, glprogram->uniform);
         glprogram->uniform = NULL;
     }
+    free(glprogram->uniform_loc);
+    free(glprogram->synced);
     // clean cache
     if(glprogram->cache.cache)
         free(glprogram->cache.cache);
+    free(glprogram->cache.gens);
     // clean fpe cache if it exist
     if(glprogram->fpe_cache)
         fpe_disposeCache((fpe_cache_t*)glprogram->fpe_cache, 1);
@@ -521,9 +526,18 @@ static void clear_program(program_t *glprogram)
             kh_del(uniformlist, glprogram->uniform, k);
         )
     }
+    free(glprogram->uniform_loc);
+    glprogram->uniform_loc = NULL;
+    glprogram->uniform_loc_size = 0;
+    free(glprogram->synced);
+    glprogram->synced = NULL;
+    glprogram->synced_size = 0;
+    glprogram->synced_gen = 0;
     glprogram->cache.size = 0;  // reset cache buffer
 }
 
+#define MAX_UNIFORM_LOC 4096
+
 static void fill_program(program_t *glprogram)
 {
     LOAD_GLES(glGetError);
@@ -597,12 +611,26 @@ static void fill_program(program_t *glprogram)
         DBG(else printf("LIBGL: Warning, getting Uniform #%d info failed with %s\n", i, PrintEnum(e2));)
     }
     free(name);
-    // reset uniform cache
-    if(glprogram->cache.cap < uniform_cache) {
-        glprogram->cache.cap=uniform_cache;
-        glprogram->cache.cache = malloc(glprogram->cache.cap);
+    // table of the uniforms by location, if they are dense enough
+    free(glprogram->uniform_loc);
+    glprogram->uniform_loc = NULL;
+    glprogram->uniform_loc_size = 0;
+    {
+        int max_loc = -1;
+        uniform_t *m;
+        kh_foreach_value(uniforms, m,
+            if((int)m->id>max_loc) max_loc = m->id;
+        )
+        if(max_loc>=0 && max_loc<MAX_UNIFORM_LOC) {
+            glprogram->uniform_loc_size = max_loc+1;
+            glprogram->uniform_loc = (uniform_t**)calloc(glprogram->uniform_loc_size, sizeof(uniform_t*));
+            kh_foreach_value(uniforms, m,
+                glprogram->uniform_loc[m->id] = m;
+            )
+        }
     }
-    memset(glprogram->cache.cache, 0, glprogram->cache.cap);
+    // reset uniform cache
+    uniformcache_reset(&glprogram->cache, uniform_cache);
     //Maybe Sampler uniform should not be initialized to 0, but to -1, to be sure the value is initialized?
     if(glprogram->uniform) {
         uniform_t *m;
@@ -727,13 +755,67 @@ void APIENTRY_GL4ES gl4es_glProgramBinary(GLuint program, GLenum binaryFormat, c
         errorShim(GL_INVALID_OPERATION);
 }
 
-void APIENTRY_GL4ES gl4es_glLinkProgram(GLuint program) {
-    DBG(printf("glLinkProgram(%d)\n", program);)
-    FLUSH_BEGINEND;
+// key of a program in the PSA: the sources of its (single) vertex and fragment shaders,
+// the attrib locations and the configuration of gl4es that changes the conversion
+static int program_psakey(program_t *glprogram, uint32_t *glsl)
+{
+    memset(glsl, 0, 3*sizeof(uint32_t));
+    shader_t *vert = NULL, *frag = NULL;
+    for (int i=0; i<glprogram->attach_size; i++) {
+        shader_t *glshader = getShader(glprogram->attach[i]);
+        if(!glshader || !glshader->hash || glshader->old)
+            return 0;
+        shader_t **which = (glshader->type==GL_VERTEX_SHADER)?&vert:&frag;
+        if(*which)
+            return 0;
+        *which = glshader;
+    }
+    if(!vert || !frag)
+        return 0;
+    // only what changes the converted (or default) shaders, not the whole config
+    const int conf[] = {
+        glstate->glsl->es2,
+        globals4es.comments, globals4es.dbgshaderconv, globals4es.nointovlhack,
+        globals4es.notexarray, globals4es.shadernogles, globals4es.normalize,
+        hardext.maxtex, hardext.maxlights, hardext.maxplanes, hardext.maxvattrib,
+        hardext.maxvarying, hardext.maxdrawbuffers, hardext.highp, hardext.fragdepth,
+        hardext.derivatives, hardext.shaderlod, hardext.cubelod,
+        hardext.glsl120, hardext.glsl300es, hardext.glsl310es
+    };
+    uint32_t h = fpe_HashPSA(conf, sizeof(conf), 0);
+    h = fpe_HashPSA(&vert->hash, sizeof(vert->hash), h);
+    h = fpe_HashPSA(&frag->hash, sizeof(frag->hash), h);
+    // attrib locations, the order of the hashmap doesn't matter
+    uint32_t attribs = 0;
+    attribloc_t *al;
+    kh_foreach_value(glprogram->attribloc, al,
+        attribs += fpe_HashPSA(al->name, strlen(al->name), fpe_HashPSA(&al->index, sizeof(al->index), 0));
+    );
+    glsl[0] = fpe_HashPSA(&attribs, sizeof(attribs), h);
+    glsl[1] = vert->hash;
+    glsl[2] = frag->hash;
+    return 1;
+}
+
+void gl4es_linkProgram(GLuint program, int use_psa) {
     CHECK_PROGRAM(void, program)
     noerrorShim();
 
+    uint32_t glsl[3] = {0};
+    if(use_psa && hardext.prgbin_n>0)
+        program_psakey(glprogram, glsl);
+    memcpy(glprogram->psa_glsl, glsl, sizeof(glsl));
+    if(fpe_GetGLSLProgramPSA(glprogram->id, glsl, NULL)) {
+        DBG(printf(" loaded from PSA\n");)
+        noerrorShim();
+        return;
+    }
+
     clear_program(glprogram);
+    // the shaders have to be compiled after all
+    for (int i=0; i<glprogram->attach_size; i++) {
+        realizeShader(getShader(glprogram->attach[i]));
+    }
 
     // check if attached shaders are compatible in term of varying...
     shaderconv_need_t needs = {0};
@@ -801,13 +883,19 @@ void APIENTRY_GL4ES gl4es_glLinkProgram(GLuint program) {
             errorShim(err);
             return;
         }
-        
+        fpe_AddGLSLProgramPSA(glprogram->id, glsl, NULL);
     } else {
         noerrorShim();
     }
     glprogram->linked = 1;
 }
 
+void APIENTRY_GL4ES gl4es_glLinkProgram(GLuint program) {
+    DBG(printf("glLinkProgram(%d)\n", program);)
+    FLUSH_BEGINEND;
+    gl4es_linkProgram(program, 1);
+}
+
 void APIENTRY_GL4ES gl4es_glUseProgram(GLuint program) {
     DBG(printf("glUseProgram(%d) old=%d\n", program, glstate->glsl->program);)
     PUSH_IF_COMPILING(glUseProgram);
@@ -117,10 +117,14 @@ typedef struct {
 
 KHASH_MAP_DECLARE_INT(uniformlist, uniform_t *);
 
+#define UNIFORM_BLOCK   16  // granularity of the change tracking of the uniform cache
+
 typedef struct {
     void*           cache;  // buffer of the uniform size
     int             cap;    // capacity of the cache
     int             size;   // next available free space in the cache
+    uint64_t        gen;    // generation of the last change of the cache (64bits, never wraps)
+    uint64_t*       gens;   // generation of the last change of each UNIFORM_BLOCK bytes of the cache
 } uniformcache_t;
 
 typedef struct {
@@ -187,6 +191,15 @@ typedef struct {
     GLint       scale;
 } builtin_fog_t;
 
+// generations of the matrices last sent to the builtin matrix uniforms (0 = not sent yet)
+typedef struct {
+    uint64_t mvp[2];        // projection and modelview
+    uint64_t mv;
+    uint64_t p;
+    uint64_t n;
+    uint64_t t[MAX_TEX];
+} builtin_matgen_t;
+
 // this need to be as texture_enabled_t, but with 0 as nothing
 typedef enum {
     TU_NONE = 0,
@@ -220,14 +233,21 @@ typedef struct {
     int             va_size[MAX_VATTRIB];
     khash_t(attribloclist)     *attribloc;
     khash_t(uniformlist) *uniform;
+    uniform_t       **uniform_loc;      // uniforms indexed by location (NULL if the locations are too sparse)
+    int             uniform_loc_size;
     int             num_uniform;
     uniformcache_t  cache;
+    // fpe custom program: the uniforms that come from the father program
+    uniform_t       **synced;
+    int             synced_size;
+    uint64_t        synced_gen;         // generation of the father cache at the last sync
     // builtin attrib
     int                             has_builtin_attrib;
     GLint                           builtin_attrib[ATT_MAX];
     // builtin uniform
     int                             has_builtin_matrix;
     GLint                           builtin_matrix[MAT_MAX];
+    builtin_matgen_t                builtin_matgen;
     int                             has_builtin_light;
     builtin_lightsource_t           builtin_lights[MAX_LIGHT];
     builtin_lightmodel_t            builtin_lightmodel;
@@ -276,6 +296,8 @@ typedef struct {
     GLint                           samplersCube[MAX_TEX];
     // that will be an fpe_cache_t*
     void*                           fpe_cache;
+    // key of the program in the PSA (0 if not cached)
+    uint32_t                        psa_glsl[3];
 } program_t;
 
 KHASH_MAP_DECLARE_INT(programlist, program_t *);
@@ -296,6 +318,7 @@ void APIENTRY_GL4ES gl4es_glGetProgramiv(GLuint program, GLenum pname, GLint *pa
 GLint APIENTRY_GL4ES gl4es_glGetUniformLocation(GLuint program, const GLchar *name);
 GLboolean APIENTRY_GL4ES gl4es_glIsProgram(GLuint program);
 void APIENTRY_GL4ES gl4es_glLinkProgram(GLuint program);
+void gl4es_linkProgram(GLuint program, int use_psa);    // internal
 void APIENTRY_GL4ES gl4es_glUseProgram(GLuint program);
 void APIENTRY_GL4ES gl4es_glValidateProgram(GLuint program);
 
@@ -329,6 +352,18 @@ int gl4es_getProgramBinary(GLuint program, int *length, GLenum *format, void** b
             gles_glUseProgram(prg);         \
     }
 
+static inline uniform_t* getUniform(program_t *glprogram, GLint location) {
+    if(glprogram->uniform_loc)
+        return (location>=0 && location<glprogram->uniform_loc_size)?glprogram->uniform_loc[location]:NULL;
+    khint_t k = kh_get(uniformlist, glprogram->uniform, location);
+    return (k!=kh_end(glprogram->uniform))?kh_value(glprogram->uniform, k):NULL;
+}
+// (re)allocate the cache for size bytes, all flagged changed
+void uniformcache_reset(uniformcache_t *cache, int size);
+void uniformcache_touch(uniformcache_t *cache, int offs, int size);
+// 1 if some of the bytes changed after generation gen
+int uniformcache_changed(const uniformcache_t *cache, int offs, int size, uint64_t gen);
+
 void GoUniformfv(program_t *glprogram, GLint location, int size, int count, const GLfloat *value);
 void GoUniformiv(program_t *glprogram, GLint location, int size, int count, const GLint *value);
 void GoUniformMatrix2fv(program_t *glprogram, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value);
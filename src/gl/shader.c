@@ -7,6 +7,7 @@
 #include "glstate.h"
 #include "loader.h"
 #include "shaderconv.h"
+#include "fpe_cache.h"
 
 //#define DEBUG
 #ifdef DEBUG
@@ -115,12 +116,7 @@ void APIENTRY_GL4ES gl4es_glDeleteShader(GLuint shader) {
     }
 }
 
-void APIENTRY_GL4ES gl4es_glCompileShader(GLuint shader) {
-    DBG(printf("glCompileShader(%d)\n", shader);)
-    // look for the shader
-    CHECK_SHADER(void, shader)
-
-    glshader->compiled = 1;
+static void compileShader(shader_t *glshader) {
     LOAD_GLES2(glCompileShader);
     if(gles_glCompileShader) {
         gles_glCompileShader(glshader->id);
@@ -144,6 +140,42 @@ void APIENTRY_GL4ES gl4es_glCompileShader(GLuint shader) {
         noerrorShim();
 }
 
+void APIENTRY_GL4ES gl4es_glCompileShader(GLuint shader) {
+    DBG(printf("glCompileShader(%d)\n", shader);)
+    // look for the shader
+    CHECK_SHADER(void, shader)
+
+    glshader->compiled = 1;
+    if(glshader->deferred) {
+        noerrorShim();
+        return; // will be compiled if the program is not in the PSA
+    }
+    compileShader(glshader);
+}
+
+static void convertShader(shader_t *glshader) {
+    LOAD_GLES2(glShaderSource);
+    // adapt shader if needed (i.e. not an es2 context and shader is not #version 100)
+    if(glshader->converted)
+        free(glshader->converted);
+    if(glstate->glsl->es2 && !strncmp(glshader->source, "#version 100", 12))
+        glshader->converted = strdup(glshader->source);
+    else
+        glshader->converted = ConvertShader(glshader->source, glshader->type==GL_VERTEX_SHADER?1:0, &glshader->need);
+    // send source to GLES2 hardware if any
+    gles_glShaderSource(glshader->id, 1, (const GLchar * const*)((glshader->converted)?(&glshader->converted):(&glshader->source)), NULL);
+}
+
+void realizeShader(shader_t *glshader) {
+    if(!glshader || !glshader->deferred)
+        return;
+    DBG(printf("realizeShader(%d)\n", glshader->id);)
+    glshader->deferred = 0;
+    convertShader(glshader);
+    if(glshader->compiled)
+        compileShader(glshader);
+}
+
 void APIENTRY_GL4ES gl4es_glShaderSource(GLuint shader, GLsizei count, const GLchar * const *string, const GLint *length) {
     DBG(printf("glShaderSource(%d, %d, %p, %p)\n", shader, count, string, length);)
     // sanity check
@@ -169,15 +201,16 @@ void APIENTRY_GL4ES gl4es_glShaderSource(GLuint shader, GLsizei count, const GLc
         for (int i=0; i<count; i++)
             strcat(glshader->source, string[i]);
     }
+    glshader->hash = fpe_HashPSA(glshader->source, l, fpe_HashPSA(&glshader->type, sizeof(glshader->type), 0));
     LOAD_GLES2(glShaderSource);
     if (gles_glShaderSource) {
-        // adapt shader if needed (i.e. not an es2 context and shader is not #version 100)
-        if(glstate->glsl->es2 && !strncmp(glshader->source, "#version 100", 12))
-            glshader->converted = strdup(glshader->source);
-        else
-            glshader->converted = ConvertShader(glshader->source, glshader->type==GL_VERTEX_SHADER?1:0, &glshader->need);
-        // send source to GLES2 hardware if any
-        gles_glShaderSource(shader, 1, (const GLchar * const*)((glshader->converted)?(&glshader->converted):(&glshader->source)), NULL);
+        // a shader of a program from the PSA: wait for the link to know if it's needed
+        glshader->deferred = fpe_HasShaderPSA(glshader->hash);
+        if(glshader->deferred) {
+            noerrorShim();
+            return;
+        }
+        convertShader(glshader);
         errorGL();
     } else
         noerrorShim();
@@ -298,6 +331,8 @@ void APIENTRY_GL4ES gl4es_glGetShaderInfoLog(GLuint shader, GLsizei maxLength, G
         return;
     }
     LOAD_GLES2(glGetShaderInfoLog);
+    // the PSA only knows the hash of the source, the real log needs the real compile
+    realizeShader(glshader);
     if(gles_glGetShaderInfoLog) {
         gles_glGetShaderInfoLog(glshader->id, maxLength, length, infoLog);
         errorGL();
@@ -321,6 +356,7 @@ void APIENTRY_GL4ES gl4es_glGetShaderiv(GLuint shader, GLenum pname, GLint *para
             *params = (glshader->deleted)?GL_TRUE:GL_FALSE;
             break;
         case GL_COMPILE_STATUS:
+            realizeShader(glshader);    // a PSA hit doesn't prove that this source compiles
             if(gles_glGetShaderiv) {
                 gles_glGetShaderiv(glshader->id, pname, params);
                 errorGL();
@@ -329,6 +365,7 @@ void APIENTRY_GL4ES gl4es_glGetShaderiv(GLuint shader, GLenum pname, GLint *para
             }
             break;
         case GL_INFO_LOG_LENGTH:
+            realizeShader(glshader);
             if(gles_glGetShaderiv) {
                 gles_glGetShaderiv(glshader->id, pname, params);
                 errorGL();
@@ -33,6 +33,8 @@ struct shader_s {
     struct oldprogram_s   *old;     // in case the shader is an old ARB ASM-like program
     char*           source; // original source of the shader (or converted if coming from "old")
     char*           converted;  // converted source (or null if nothing)
+    uint32_t        hash;   // hash of the type and source, to find the shader in the PSA
+    int             deferred;   // conversion and compile postponed: the program may come from the PSA
     // shaderconv
     shaderconv_need_t  need;    // the varying need / provide of the shader
 }; // shader_t defined in oldprogram.h
@@ -54,6 +56,7 @@ void APIENTRY_GL4ES gl4es_glReleaseShaderCompiler(void);
 void accumShaderNeeds(GLuint shader, shaderconv_need_t *need);
 int isShaderCompatible(GLuint shader, shaderconv_need_t *need);
 void redoShader(GLuint shader, shaderconv_need_t *need);
+void realizeShader(struct shader_s *glshader);    // convert and compile a deferred shader
 struct shader_s*getShader(GLuint shader);
 
 #define CHECK_SHADER(type, shader) \
@@ -111,6 +111,9 @@ typedef struct {
 
 typedef struct {
     renderlist_t *active;
+    renderlist_t *pool;     // freed renderlist_t, reused by alloc_renderlist
+    int pool_len;
+    int pool_low;           // lowest pool_len since the last trim_renderlist_pool
     GLboolean compiling;
     GLboolean pending;
     GLboolean begin;
@@ -211,6 +214,9 @@ typedef struct {
 	int		top;
     int     identity;
 	GLfloat	*stack;
+	uint64_t gen;			// generation of the top matrix, changes each time it is modified (64bits, never wraps)
+	uint64_t inv_gen;		// generation of the top matrix inv is the inverse of
+	GLfloat	inv[16];
 } matrixstack_t;
 
 typedef struct glsl_s {
@@ -0,0 +1,68 @@
+#include "stats.h"
+
+#include <string.h>
+#include "attributes.h"
+#include "fpe.h"
+#include "init.h"
+#include "list.h"
+#include "logs.h"
+
+stats4es_t stats4es = {0};
+
+#define STATS_FIELDS(_) \
+    _(frames) _(draws) _(renderlists) _(merged) _(fpe_lookups) _(fpe_programs) \
+    _(uniforms_uploaded) _(uniforms_skipped) _(pixel_bytes) _(array_bytes) _(tex_uploads)
+
+static void stats_add(gl4es_stats_t *dst, const gl4es_stats_t *src) {
+    #define GO(A) dst->A += src->A;
+    STATS_FIELDS(GO)
+    #undef GO
+}
+
+static void stats_print(const char *what, const gl4es_stats_t *s, unsigned long long frames) {
+    if(!frames) frames = 1;
+    #define AVG(A) (double)s->A/frames
+    LOGD("%s: draws=%.1f lists=%.1f merged=%.1f fpe=%.1f(%.1f built) uniforms=%.1f(%.1f skipped) pixels=%.0fB arrays=%.0fB tex=%.1f\n",
+        what, AVG(draws), AVG(renderlists), AVG(merged), AVG(fpe_lookups), AVG(fpe_programs),
+        AVG(uniforms_uploaded), AVG(uniforms_skipped), AVG(pixel_bytes), AVG(array_bytes), AVG(tex_uploads));
+    #undef AVG
+}
+
+void stats_endframe() {
+    stats4es.cur.frames = 1;
+    stats_add(&stats4es.total, &stats4es.cur);
+    stats4es.last = stats4es.cur;
+    if(globals4es.stats) {
+        stats_add(&stats4es.sum, &stats4es.cur);
+        if(++stats4es.sumframes >= globals4es.stats) {
+            stats_print((stats4es.sumframes>1)?"stats (per frame)":"stats", &stats4es.sum, stats4es.sumframes);
+            memset(&stats4es.sum, 0, sizeof(stats4es.sum));
+            stats4es.sumframes = 0;
+        }
+    }
+    memset(&stats4es.cur, 0, sizeof(stats4es.cur));
+}
+
+void stats_print_total() {
+    LOGD("%llu frames\n", stats4es.total.frames);
+    stats_print("stats (per frame)", &stats4es.total, stats4es.total.frames);
+}
+
+EXPORT
+void gl4es_getStats(gl4es_stats_t *last_frame, gl4es_stats_t *total) {
+    if(last_frame)
+        *last_frame = stats4es.last;
+    if(total) {
+        // include the frame in progress
+        *total = stats4es.total;
+        stats_add(total, &stats4es.cur);
+    }
+}
+
+// end of frame work, shared by all the SwapBuffers paths
+EXPORT
+void gl4es_statsEndFrame() {
+    stats_endframe();
+    fpe_Prelink();
+    trim_renderlist_pool();
+}
@@ -0,0 +1,26 @@
+#ifndef _GL4ES_STATS_H_
+#define _GL4ES_STATS_H_
+
+#include <gl4esinit.h>
+
+// Per-frame counters of the hot paths. They are plain increments, so they stay active
+// in all builds, LIBGL_STATS only prints them at SwapBuffers time.
+
+typedef struct _stats4es {
+    gl4es_stats_t cur;      // current frame
+    gl4es_stats_t last;     // last ended frame
+    gl4es_stats_t total;    // all ended frames
+    gl4es_stats_t sum;      // frames since the last print (LIBGL_STATS)
+    int           sumframes;
+} stats4es_t;
+
+extern stats4es_t stats4es;
+
+#define STATS_INC(A)    ++stats4es.cur.A
+#define STATS_ADD(A, N) stats4es.cur.A += (N)
+
+// end of frame: update last / total and print the counters if asked
+void stats_endframe();
+void stats_print_total();
+
+#endif // _GL4ES_STATS_H_
@@ -0,0 +1,276 @@
+#include "texasync.h"
+
+#include "../glx/hardext.h"
+#include "debug.h"
+#include "enum_info.h"
+#include "gl4es.h"
+#include "glstate.h"
+#include "init.h"
+#include "loader.h"
+#include "logs.h"
+#include "pixel.h"
+#include "stats.h"
+
+#define TEXASYNC_MINBYTES   (16*1024)   // smaller uploads are converted right away
+
+int texasync_pending = 0;
+
+#if defined(_WIN32) || defined(AMIGAOS4)
+// no background thread on those platforms, uploads are always synchronous
+void texasync_init() {
+    if(globals4es.texasync) {
+        SHUT_LOGD("LIBGL_TEXASYNC not supported on this platform\n");
+        globals4es.texasync = 0;
+    }
+}
+void texasync_shutdown() {
+}
+int texasync_subimage(gltexture_t *bound, GLenum rtarget, GLint level, GLint xoffset, GLint yoffset,
+                      GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *data) {
+    return 0;
+}
+void texasync_commit(gltexture_t *tex) {
+}
+void texasync_discard(gltexture_t *tex) {
+}
+void texasync_realize() {
+}
+#else
+#include <pthread.h>
+
+typedef enum {
+    JOB_QUEUED = 0,
+    JOB_RUNNING,
+    JOB_DONE
+} texasync_state_t;
+
+struct texasync_s {
+    texasync_t  *next;          // next pending upload of the same texture
+    texasync_t  *qnext;         // next job in the worker queue
+    volatile texasync_state_t state;
+    // the upload
+    GLint       level, xoffset, yoffset;
+    GLsizei     width, height;
+    GLuint      align;
+    // the conversion
+    GLvoid      *src;           // private copy of the application data
+    GLvoid      *pixels;        // converted data
+    GLenum      format, type;   // of src, then of pixels once converted
+    GLenum      inter_format, inter_type;
+    GLenum      dst_format, dst_type;
+};
+
+static pthread_t        worker;
+static int              running = 0;
+static int              quit = 0;
+static pthread_mutex_t  mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   wakeup = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t   done = PTHREAD_COND_INITIALIZER;
+static texasync_t       *queue_head = NULL, *queue_tail = NULL;
+
+// same conversions as the synchronous glTexSubImage2D path
+static void texasync_convert(texasync_t *job) {
+    GLvoid *src = job->src;
+    GLvoid *pixels = src;
+    if (!pixel_convert_nostats(src, &pixels, job->width, job->height, job->format, job->type,
+                       job->inter_format, job->inter_type, job->align)) {
+        printf("LIBGL: Error in pixel_convert while glTexSubImage2D\n");
+    } else {
+        job->format = job->inter_format;
+        job->type = job->inter_type;
+        if (job->inter_format!=job->dst_format || job->inter_type!=job->dst_type) {
+            GLvoid *pix2 = pixels;
+            if (!pixel_convert_nostats(pixels, &pix2, job->width, job->height, job->format, job->type,
+                               job->dst_format, job->dst_type, job->align)) {
+                printf("LIBGL: Error in pixel_convert while glTexSubImage2D\n");
+            }
+            if (pix2!=pixels && pixels!=src)
+                free(pixels);
+            pixels = pix2;
+            job->format = job->dst_format;
+            job->type = job->dst_type;
+        }
+    }
+    if (pixels!=src)
+        free(src);
+    job->src = NULL;
+    job->pixels = pixels;
+}
+
+static void* texasync_worker(void *unused) {
+    pthread_mutex_lock(&mutex);
+    while(1) {
+        while(!quit && !queue_head)
+            pthread_cond_wait(&wakeup, &mutex);
+        if(quit)
+            break;
+        texasync_t *job = queue_head;
+        queue_head = job->qnext;
+        if(!queue_head)
+            queue_tail = NULL;
+        job->state = JOB_RUNNING;
+        pthread_mutex_unlock(&mutex);
+        texasync_convert(job);
+        pthread_mutex_lock(&mutex);
+        job->state = JOB_DONE;
+        pthread_cond_broadcast(&done);
+    }
+    pthread_mutex_unlock(&mutex);
+    return NULL;
+}
+
+void texasync_init() {
+    if(!globals4es.texasync || running)
+        return;
+    if(pthread_create(&worker, NULL, texasync_worker, NULL)) {
+        SHUT_LOGD("Cannot start the asynchronous texture thread\n");
+        globals4es.texasync = 0;
+        return;
+    }
+    running = 1;
+}
+
+void texasync_shutdown() {
+    if(!running)
+        return;
+    pthread_mutex_lock(&mutex);
+    quit = 1;
+    pthread_cond_broadcast(&wakeup);
+    pthread_mutex_unlock(&mutex);
+    pthread_join(worker, NULL);
+    running = 0;
+}
+
+// make sure the conversion of job is done: if the worker didn't start it yet, do it here
+static void texasync_wait(texasync_t *job) {
+    pthread_mutex_lock(&mutex);
+    if(job->state==JOB_QUEUED) {
+        texasync_t **p = &queue_head, *prev = NULL;
+        while(*p!=job) {
+            prev = *p;
+            p = &(*p)->qnext;
+        }
+        *p = job->qnext;
+        if(queue_tail==job)
+            queue_tail = prev;
+        job->state = JOB_RUNNING;
+        pthread_mutex_unlock(&mutex);
+        texasync_convert(job);
+        job->state = JOB_DONE;
+        return;
+    }
+    while(job->state!=JOB_DONE)
+        pthread_cond_wait(&done, &mutex);
+    pthread_mutex_unlock(&mutex);
+}
+
+int texasync_subimage(gltexture_t *bound, GLenum rtarget, GLint level, GLint xoffset, GLint yoffset,
+                      GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *data) {
+    // only the simple case: one conversion, then one glTexSubImage2D of level 0
+    if (!running || !data || level || rtarget!=GL_TEXTURE_2D
+     || (glstate->texture.unpack_row_length && glstate->texture.unpack_row_length!=width)
+     || glstate->texture.unpack_skip_pixels || glstate->texture.unpack_skip_rows
+     || bound->shrink || bound->useratio || bound->streamed || bound->binded_fbo
+     || bound->mipmap_need || bound->mipmap_auto
+     || globals4es.texdump || globals4es.texcopydata || format==GL_COLOR_INDEX
+     || (format==bound->inter_format && type==bound->inter_type))   // nothing to convert
+        return 0;
+    const GLuint align = glstate->texture.unpack_align;
+    if (((uintptr_t)data)&(align-1))
+        return 0;
+    const GLuint src_line = width * pixel_sizeof(format, type);
+    const GLuint src_size = (height-1) * widthalign(src_line, align) + src_line;
+    const GLuint dst_size = height * widthalign(width * pixel_sizeof(bound->format, bound->type), align);
+    if (!src_line || dst_size<TEXASYNC_MINBYTES)
+        return 0;
+    // the worker doesn't touch the counters, count the converted bytes here, on the GL thread
+    STATS_ADD(pixel_bytes, height * widthalign(width * pixel_sizeof(bound->inter_format, bound->inter_type), align));
+    if (bound->inter_format!=bound->format || bound->inter_type!=bound->type)
+        STATS_ADD(pixel_bytes, dst_size);
+
+    texasync_t *job = (texasync_t*)calloc(1, sizeof(texasync_t));
+    job->level = level;
+    job->xoffset = xoffset;
+    job->yoffset = yoffset;
+    job->width = width;
+    job->height = height;
+    job->align = align;
+    job->format = format;
+    job->type = type;
+    job->inter_format = bound->inter_format;
+    job->inter_type = bound->inter_type;
+    job->dst_format = bound->format;
+    job->dst_type = bound->type;
+    // the application can reuse its buffer as soon as we return
+    job->src = malloc(src_size);
+    memcpy(job->src, data, src_size);
+    // keep the uploads of a texture in order
+    texasync_t **last = (texasync_t**)&bound->async;
+    while(*last)
+        last = &(*last)->next;
+    *last = job;
+    ++texasync_pending;
+
+    pthread_mutex_lock(&mutex);
+    if(queue_tail)
+        queue_tail->qnext = job;
+    else
+        queue_head = job;
+    queue_tail = job;
+    pthread_cond_signal(&wakeup);
+    pthread_mutex_unlock(&mutex);
+    return 1;
+}
+
+void texasync_commit(gltexture_t *tex) {
+    LOAD_GLES(glBindTexture);
+    LOAD_GLES(glPixelStorei);
+    LOAD_GLES(glTexSubImage2D);
+    texasync_t *job = (texasync_t*)tex->async;
+    if(!job)
+        return;
+    tex->async = NULL;
+    // upload on the current TMU, without changing what it has bound
+    const GLuint oldtex = glstate->actual_tex2d[glstate->gleshard->active];
+    if (oldtex!=tex->glname)
+        gles_glBindTexture(GL_TEXTURE_2D, tex->glname);
+    while(job) {
+        texasync_wait(job);
+        if (job->align!=glstate->texture.unpack_align)
+            gles_glPixelStorei(GL_UNPACK_ALIGNMENT, job->align);
+        gles_glTexSubImage2D(GL_TEXTURE_2D, job->level, job->xoffset, job->yoffset,
+                             job->width, job->height, job->format, job->type, job->pixels);
+        if (job->align!=glstate->texture.unpack_align)
+            gles_glPixelStorei(GL_UNPACK_ALIGNMENT, glstate->texture.unpack_align);
+        texasync_t *next = job->next;
+        free(job->pixels);
+        free(job);
+        --texasync_pending;
+        job = next;
+    }
+    if (oldtex!=tex->glname)
+        gles_glBindTexture(GL_TEXTURE_2D, oldtex);
+}
+
+void texasync_discard(gltexture_t *tex) {
+    texasync_t *job = (texasync_t*)tex->async;
+    tex->async = NULL;
+    while(job) {
+        texasync_wait(job);
+        texasync_t *next = job->next;
+        free(job->pixels);
+        free(job);
+        --texasync_pending;
+        job = next;
+    }
+}
+
+void texasync_realize() {
+    if(!texasync_pending)
+        return;
+    static const int targets[] = {ENABLED_TEX1D, ENABLED_TEX2D, ENABLED_TEXTURE_RECTANGLE};
+    for (int i=0; i<hardext.maxtex; ++i)
+        for (int j=0; j<sizeof(targets)/sizeof(targets[0]); ++j)
+            texasync_sync(glstate->texture.bound[i][targets[j]]);
+}
+#endif
@@ -0,0 +1,33 @@
+#ifndef _GL4ES_TEXASYNC_H_
+#define _GL4ES_TEXASYNC_H_
+
+#include "texture.h"
+
+// Asynchronous texture uploads (LIBGL_TEXASYNC): the pixel conversion of a glTexSubImage2D
+// (or of a glTexImage2D that only replaces the content of a texture) is done on a background
+// thread, and the GLES upload is committed the first time the texture is needed: when a
+// draw samples it (realize_textures), or before any other operation on the texture.
+
+typedef struct texasync_s texasync_t;
+
+extern int texasync_pending;    // number of uploads not committed yet
+
+void texasync_init();
+void texasync_shutdown();
+
+// queue the upload if it can be done asynchronously, returns 0 if the caller must do it now
+int texasync_subimage(gltexture_t *bound, GLenum rtarget, GLint level, GLint xoffset, GLint yoffset,
+                      GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *data);
+// wait for the pending uploads of tex, and send them to GLES
+void texasync_commit(gltexture_t *tex);
+// drop the pending uploads of tex (the texture is deleted)
+void texasync_discard(gltexture_t *tex);
+// commit the pending uploads of all bound textures (before a draw)
+void texasync_realize();
+
+static inline void texasync_sync(gltexture_t *tex) {
+    if(tex && tex->async)
+        texasync_commit(tex);
+}
+
+#endif // _GL4ES_TEXASYNC_H_
@@ -586,6 +586,7 @@ void APIENTRY_GL4ES gl4es_glTexEnvf(GLenum target, GLenum pname, GLfloat param)
             return;
     }
     errorGL();
+    glstate->fpe_dirty = 1;
     if(hardext.esversion==1) {
         LOAD_GLES2(glTexEnvf);
         realize_active();
@@ -0,0 +1,147 @@
+#include "texthreads.h"
+
+#include <stdlib.h>
+#include "debug.h"
+#include "logs.h"
+
+#if defined(_WIN32) || defined(AMIGAOS4)
+// no worker threads on those platforms, everything runs on the calling thread
+void texthreads_init(int threads) {
+    if(threads>1)
+        SHUT_LOGD("LIBGL_TEXTHREADS not supported on this platform\n");
+}
+void texthreads_shutdown() {
+}
+void texthreads_run(int rows, unsigned int bytes, texthreads_fn fn, void *arg) {
+    fn(arg, 0, rows);
+}
+#else
+#include <pthread.h>
+
+#define TEXTHREADS_MAX      16
+#define TEXTHREADS_MINBYTES (256*1024)  // smaller jobs are not worth waking the workers
+#define TEXTHREADS_MINROWS  8           // minimum rows per band
+
+typedef struct {
+    int             nthreads;           // workers, the calling thread is not counted
+    pthread_t       threads[TEXTHREADS_MAX];
+    pthread_mutex_t busy;               // one job at a time
+    pthread_mutex_t mutex;
+    pthread_cond_t  start;
+    pthread_cond_t  done;
+    unsigned int    generation;         // incremented for each new job
+    int             quit;
+    // current job
+    texthreads_fn   fn;
+    void            *arg;
+    int             rows;
+    int             bandsize;
+    int             nbands;
+    int             nextband;           // next band to process (atomic)
+    int             remaining;          // bands not finished yet (protected by mutex)
+    int             active;             // workers inside texthreads_work (protected by mutex)
+} texthreads_t;
+
+static texthreads_t pool = {0};
+
+// process bands of the current job until there is none left, returns the number of bands done
+static int texthreads_work() {
+    int band, done = 0;
+    while((band=__sync_fetch_and_add(&pool.nextband, 1)) < pool.nbands) {
+        int first = band*pool.bandsize;
+        int last = first+pool.bandsize;
+        if(last>pool.rows) last = pool.rows;
+        pool.fn(pool.arg, first, last);
+        ++done;
+    }
+    return done;
+}
+
+static void* texthreads_worker(void *unused) {
+    unsigned int generation = 0;
+    pthread_mutex_lock(&pool.mutex);
+    while(1) {
+        while(!pool.quit && pool.generation==generation)
+            pthread_cond_wait(&pool.start, &pool.mutex);
+        if(pool.quit)
+            break;
+        generation = pool.generation;
+        ++pool.active;
+        pthread_mutex_unlock(&pool.mutex);
+        int done = texthreads_work();
+        pthread_mutex_lock(&pool.mutex);
+        pool.remaining -= done;
+        --pool.active;
+        if(!pool.remaining || !pool.active)
+            pthread_cond_signal(&pool.done);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+    return NULL;
+}
+
+void texthreads_init(int threads) {
+    if(pool.nthreads || threads<2)
+        return;
+    if(threads>TEXTHREADS_MAX+1)
+        threads = TEXTHREADS_MAX+1;
+    pthread_mutex_init(&pool.busy, NULL);
+    pthread_mutex_init(&pool.mutex, NULL);
+    pthread_cond_init(&pool.start, NULL);
+    pthread_cond_init(&pool.done, NULL);
+    // the calling thread does its share of the work
+    for (int i=0; i<threads-1; ++i) {
+        if(pthread_create(&pool.threads[pool.nthreads], NULL, texthreads_worker, NULL))
+            break;
+        ++pool.nthreads;
+    }
+    SHUT_LOGD("Using %d threads for texture conversions\n", pool.nthreads+1);
+}
+
+void texthreads_shutdown() {
+    if(!pool.nthreads)
+        return;
+    pthread_mutex_lock(&pool.mutex);
+    pool.quit = 1;
+    pthread_cond_broadcast(&pool.start);
+    pthread_mutex_unlock(&pool.mutex);
+    for (int i=0; i<pool.nthreads; ++i)
+        pthread_join(pool.threads[i], NULL);
+    pool.nthreads = 0;
+}
+
+void texthreads_run(int rows, unsigned int bytes, texthreads_fn fn, void *arg) {
+    if(!pool.nthreads || bytes<TEXTHREADS_MINBYTES || rows<2*TEXTHREADS_MINROWS
+     || pthread_mutex_trylock(&pool.busy)) {
+        fn(arg, 0, rows);
+        return;
+    }
+    // a few bands per thread, so a slow thread doesn't hold everyone
+    int nbands = (pool.nthreads+1)*4;
+    int bandsize = (rows+nbands-1)/nbands;
+    if(bandsize<TEXTHREADS_MINROWS)
+        bandsize = TEXTHREADS_MINROWS;
+    pthread_mutex_lock(&pool.mutex);
+    // a late worker may still be looking at the previous job
+    while(pool.active)
+        pthread_cond_wait(&pool.done, &pool.mutex);
+    pool.fn = fn;
+    pool.arg = arg;
+    pool.rows = rows;
+    pool.bandsize = bandsize;
+    pool.nbands = (rows+bandsize-1)/bandsize;
+    pool.nextband = 0;
+    pool.remaining = pool.nbands;
+    ++pool.generation;
+    pthread_cond_broadcast(&pool.start);
+    pthread_mutex_unlock(&pool.mutex);
+
+    int done = texthreads_work();
+
+    pthread_mutex_lock(&pool.mutex);
+    pool.remaining -= done;
+    while(pool.remaining)
+        pthread_cond_wait(&pool.done, &pool.mutex);
+    pthread_mutex_unlock(&pool.mutex);
+    pthread_mutex_unlock(&pool.busy);
+}
+#endif
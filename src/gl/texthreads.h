@@ -0,0 +1,18 @@
+#ifndef _GL4ES_TEXTHREADS_H_
+#define _GL4ES_TEXTHREADS_H_
+
+// Small worker pool for the CPU side texture conversions (LIBGL_TEXTHREADS).
+// A job is a number of rows, split in bands processed by the workers and the calling
+// thread. Each row is written by exactly one band, so the result is the same as
+// the single threaded loop.
+
+typedef void (*texthreads_fn)(void *arg, int first, int last);   // process rows [first, last)
+
+void texthreads_init(int threads);
+void texthreads_shutdown();
+
+// run fn on rows [0, rows). "bytes" is the size of the job output: small jobs,
+// or jobs asked while the pool is busy, are run directly on the calling thread
+void texthreads_run(int rows, unsigned int bytes, texthreads_fn fn, void *arg);
+
+#endif // _GL4ES_TEXTHREADS_H_
@@ -15,6 +15,8 @@
 #include "matrix.h"
 #include "pixel.h"
 #include "raster.h"
+#include "stats.h"
+#include "texasync.h"
 
 //#define DEBUG
 #ifdef DEBUG
@@ -945,6 +947,8 @@ void APIENTRY_GL4ES gl4es_glTexImage2D(GLenum target, GLint level, GLint interna
     } else {
         PUSH_IF_COMPILING(glTexImage2D);
     }
+    if(data || glstate->vao->unpack)
+        STATS_INC(tex_uploads);
 
 #ifdef __BIG_ENDIAN__
     if(type==GL_UNSIGNED_INT_8_8_8_8)
@@ -1093,9 +1097,23 @@ void APIENTRY_GL4ES gl4es_glTexImage2D(GLenum target, GLint level, GLint interna
     }
     if(level>0 && (bound->npot && globals4es.forcenpot))
         return;         // no mipmap...
+    // same image specified again: only the content changes, so it can be an asynchronous update
+    if (level==0 && bound->valid && !bound->compressed && width==bound->width && height==bound->height
+     && bound->nwidth==width && bound->nheight==height && internalformat==bound->wanted_internal
+     && format==bound->src_format && type==bound->src_type
+     && texasync_subimage(bound, rtarget, 0, 0, 0, width, height, format, type, datab)) {
+        if(glstate->bound_changed<glstate->texture.active+1)
+            glstate->bound_changed = glstate->texture.active+1;
+        return;
+    }
+    texasync_sync(bound);
     if (level==0 || !bound->valid) {
         bound->wanted_internal = internalformat;    // save it before transformation
     }
+    if (level==0) {
+        bound->src_format = format;
+        bound->src_type = type;
+    }
     GLenum new_format = swizzle_internalformat((GLenum *) &internalformat, format, type);
     if (level==0 || !bound->valid) {
         bound->orig_internal = internalformat;
@@ -1545,6 +1563,7 @@ void APIENTRY_GL4ES gl4es_glTexSubImage2D(GLenum target, GLint level, GLint xoff
         PUSH_IF_COMPILING(glTexSubImage2D);
     }
     realize_bound(glstate->texture.active, target);
+    STATS_INC(tex_uploads);
 
 #ifdef __BIG_ENDIAN__
     if(type==GL_UNSIGNED_INT_8_8_8_8)
@@ -1582,6 +1601,10 @@ void APIENTRY_GL4ES gl4es_glTexSubImage2D(GLenum target, GLint level, GLint xoff
     if(level && bound->mipmap_auto)
         return;
 
+    if (texasync_subimage(bound, rtarget, level, xoffset, yoffset, width, height, format, type, datab))
+        return;
+    texasync_sync(bound);   // keep the uploads in order
+
     if ((glstate->texture.unpack_row_length && glstate->texture.unpack_row_length != width) || glstate->texture.unpack_skip_pixels || glstate->texture.unpack_skip_rows) {
         int imgWidth, pixelSize, dstWidth;
         pixelSize = pixel_sizeof(format, type);
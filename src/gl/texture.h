@@ -131,6 +131,7 @@ typedef struct {
     GLenum  format;
     GLenum  type;
     GLenum  wanted_internal;
+    GLenum  src_format, src_type;   // format / type of the last level 0 glTexImage2D
     GLenum  orig_internal;
     GLenum  internalformat;
     GLenum  inter_format, inter_type;
@@ -156,6 +157,7 @@ typedef struct {
     glsampler_t sampler;    // internal sampler if not superseded by glBindSampler
     glsampler_t actual;     // actual sampler
     float fbtex_ratio; // Lower rendering resolution
+    struct texasync_s *async;   // pending asynchronous uploads (LIBGL_TEXASYNC)
 } gltexture_t;
 
 KHASH_MAP_DECLARE_INT(tex, gltexture_t *);
@@ -15,6 +15,7 @@
 #include "matrix.h"
 #include "pixel.h"
 #include "raster.h"
+#include "texasync.h"
 
 KHASH_MAP_IMPL_INT(tex, gltexture_t *);
 
@@ -191,7 +192,11 @@ void APIENTRY_GL4ES gl4es_glBindTexture(GLenum target, GLuint texture) {
         if (glstate->texture.bound[glstate->texture.active][itarget] == tex)
             return;
         
-        FLUSH_BEGINEND;
+        if (itarget==ENABLED_TEX2D) {
+            FLUSH_BEGINEND_2D;
+        } else {
+            FLUSH_BEGINEND;
+        }
         tex_changed = glstate->texture.active+1;
         glstate->texture.bound[glstate->texture.active][itarget] = tex;
 
@@ -397,6 +402,7 @@ void APIENTRY_GL4ES gl4es_glDeleteTextures(GLsizei n, const GLuint *textures) {
                     if(found)
                         glstate->bound_changed = a+1;
                 }
+                texasync_discard(tex);
                 gles_glDeleteTextures(1, &tex->glname);
                 // check if renderbuffer where associeted
                 if(tex->binded_fbo) {
@@ -859,6 +865,7 @@ void realize_textures(int drawing) {
 #else
     DBG(printf("realize_textures(%d), glstate->bound_changed=%d, glstate->enable.texture[0]=%X glsate->actual_tex2d[0]=%u\n", drawing, glstate->bound_changed, glstate->enable.texture[0], glstate->actual_tex2d[0]);)
 #endif
+    texasync_realize();
     for (int i=0; i<glstate->bound_changed; i++) {
         // get highest priority texture unit
         int tmp = glstate->enable.texture[glstate->texture.active];
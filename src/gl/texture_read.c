@@ -15,6 +15,7 @@
 #include "matrix.h"
 #include "pixel.h"
 #include "raster.h"
+#include "texasync.h"
 
 //#define DEBUG
 #ifdef DEBUG
@@ -40,6 +41,7 @@ void APIENTRY_GL4ES gl4es_glCopyTexImage2D(GLenum target,  GLint level,  GLenum
 
     // actually bound if targeting shared TEX2D
     realize_bound(glstate->texture.active, target);
+    texasync_sync(glstate->texture.bound[glstate->texture.active][itarget]);
 
     if (globals4es.skiptexcopies) {
         DBG(printf("glCopyTexImage2D skipped.\n"));
@@ -115,6 +117,7 @@ void APIENTRY_GL4ES gl4es_glCopyTexSubImage2D(GLenum target, GLint level, GLint
     LOAD_GLES(glCopyTexSubImage2D);
     errorGL();
     realize_bound(glstate->texture.active, target);
+    texasync_sync(glstate->texture.bound[glstate->texture.active][itarget]);
     
     // "Unmap" if buffer mapped...
     glbuffer_t *pack = glstate->vao->pack;
@@ -218,6 +221,7 @@ void APIENTRY_GL4ES gl4es_glGetTexImage(GLenum target, GLint level, GLenum forma
     const GLuint itarget = what_target(target);    
 
     realize_bound(glstate->texture.active, target);
+    texasync_sync(glstate->texture.bound[glstate->texture.active][itarget]);
        
     gltexture_t* bound = glstate->texture.bound[glstate->texture.active][itarget];
     int width = bound->width;
@@ -5,6 +5,7 @@
 #include "glstate.h"
 #include "loader.h"
 #include "matvec.h"
+#include "stats.h"
 
 //#define DEBUG
 #ifdef DEBUG
@@ -13,6 +14,36 @@
 #define DBG(a)
 #endif
 
+static uint64_t uniform_generation = 0;
+
+void uniformcache_reset(uniformcache_t *cache, int size)
+{
+    if(cache->cap < size) {
+        cache->cap = size;
+        cache->cache = realloc(cache->cache, cache->cap);
+        cache->gens = (uint64_t*)realloc(cache->gens, ((cache->cap+UNIFORM_BLOCK-1)/UNIFORM_BLOCK)*sizeof(uint64_t));
+    }
+    memset(cache->cache, 0, cache->cap);
+    uniformcache_touch(cache, 0, cache->cap);
+}
+
+void uniformcache_touch(uniformcache_t *cache, int offs, int size)
+{
+    if(size<=0)
+        return;
+    cache->gen = ++uniform_generation;
+    for (int i=offs/UNIFORM_BLOCK; i<=(offs+size-1)/UNIFORM_BLOCK; ++i)
+        cache->gens[i] = cache->gen;
+}
+
+int uniformcache_changed(const uniformcache_t *cache, int offs, int size, uint64_t gen)
+{
+    for (int i=offs/UNIFORM_BLOCK; i<=(offs+size-1)/UNIFORM_BLOCK; ++i)
+        if(cache->gens[i]>gen)
+            return 1;
+    return 0;
+}
+
 int uniformsize(GLenum type) {
     #define GO(T, t, s) \
         case T: return sizeof(t)*s
@@ -110,11 +141,8 @@ void APIENTRY_GL4ES gl4es_glGetUniformfv(GLuint program, GLint location, GLfloat
     FLUSH_BEGINEND;
     CHECK_PROGRAM(void, program);
 
-    khint_t k;
-    uniform_t *gluniform = NULL;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if(k!=kh_end(glprogram->uniform)) {
-        gluniform = kh_value(glprogram->uniform, k);
+    uniform_t *gluniform = getUniform(glprogram, location);
+    if(gluniform) {
         uintptr_t offs = gluniform->cache_offs;
         int size = gluniform->cache_size;
         if(is_uniform_float(gluniform->type)) {
@@ -137,11 +165,8 @@ void APIENTRY_GL4ES gl4es_glGetUniformiv(GLuint program, GLint location, GLint *
     FLUSH_BEGINEND;
     CHECK_PROGRAM(void, program);
 
-    khint_t k;
-    uniform_t *gluniform = NULL;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if(k!=kh_end(glprogram->uniform)) {
-        gluniform = kh_value(glprogram->uniform, k);
+    uniform_t *gluniform = getUniform(glprogram, location);
+    if(gluniform) {
         uintptr_t offs = gluniform->cache_offs;
         int size = gluniform->cache_size;
         if(is_uniform_int(gluniform->type)) {
@@ -172,14 +197,11 @@ void GoUniformfv(program_t *glprogram, GLint location, int size, int count, cons
         return;
     }
 
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    uniform_t *m = getUniform(glprogram, location);
+    if (!m) {
         errorShim(GL_INVALID_OPERATION);
         return;
     }
-    m = kh_value(glprogram->uniform, k);
     if(size != n_uniform(m->type) || !is_uniform_float(m->type) || count>m->size) {
         errorShim(GL_INVALID_OPERATION);
         return;
@@ -188,10 +210,13 @@ void GoUniformfv(program_t *glprogram, GLint location, int size, int count, cons
     int rsize = sizeof(GLfloat)*size*count;
     if (memcmp((char*)glprogram->cache.cache + m->cache_offs, value, rsize)==0) {
         noerrorShim();
+        STATS_INC(uniforms_skipped);
         return; // nothing to do, same value already there
     }
     // update uniform
+    STATS_INC(uniforms_uploaded);
     memcpy((char*)glprogram->cache.cache + m->cache_offs, value, rsize);
+    uniformcache_touch(&glprogram->cache, m->cache_offs, rsize);
     LOAD_GLES2(glUniform1fv);
     LOAD_GLES2(glUniform2fv);
     LOAD_GLES2(glUniform3fv);
@@ -219,14 +244,11 @@ void GoUniformiv(program_t *glprogram, GLint location, int size, int count, cons
         return;
     }
 
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    uniform_t *m = getUniform(glprogram, location);
+    if (!m) {
         errorShim(GL_INVALID_OPERATION);
         return;
     }
-    m = kh_value(glprogram->uniform, k);
     if(size != n_uniform(m->type) || !is_uniform_int(m->type)  || count>m->size) {
         errorShim(GL_INVALID_OPERATION);
         return;
@@ -235,11 +257,14 @@ void GoUniformiv(program_t *glprogram, GLint location, int size, int count, cons
     int rsize = sizeof(GLint)*size*count;
     if (memcmp((char*)glprogram->cache.cache + m->cache_offs, value, rsize)==0) {
         noerrorShim();
+        STATS_INC(uniforms_skipped);
         return; // nothing to do, same value already there
     }
     DBG(printf("Uniform updated, cache=%p(%d/%d), offset=%p, size=%d\n", glprogram->cache.cache, glprogram->cache.size, glprogram->cache.cap, (void*)m->cache_offs, rsize);)
     // update uniform
+    STATS_INC(uniforms_uploaded);
     memcpy((char*)glprogram->cache.cache + m->cache_offs, value, rsize);
+    uniformcache_touch(&glprogram->cache, m->cache_offs, rsize);
     LOAD_GLES2(glUniform1iv);
     LOAD_GLES2(glUniform2iv);
     LOAD_GLES2(glUniform3iv);
@@ -531,14 +556,11 @@ void GoUniformMatrix2fv(program_t *glprogram, GLint location, GLsizei count, GLb
         errorShim(GL_INVALID_VALUE);
         return;
     }
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    uniform_t *m = getUniform(glprogram, location);
+    if (!m) {
         errorShim(GL_INVALID_OPERATION);
         return;
     }
-    m = kh_value(glprogram->uniform, k);
     if(m->type!=GL_FLOAT_MAT2  || count>m->size) {
         errorShim(GL_INVALID_OPERATION);
         return;
@@ -558,10 +580,13 @@ void GoUniformMatrix2fv(program_t *glprogram, GLint location, GLsizei count, GLb
     int rsize = sizeof(GLfloat)*2*2*count;
     if (memcmp((char*)glprogram->cache.cache + m->cache_offs, v, rsize)==0) {
         noerrorShim();
+        STATS_INC(uniforms_skipped);
         return; // nothing to do, same value already there
     }
     // update uniform
+    STATS_INC(uniforms_uploaded);
     memcpy((char*)glprogram->cache.cache + m->cache_offs, v, rsize);
+    uniformcache_touch(&glprogram->cache, m->cache_offs, rsize);
     LOAD_GLES2(glUniformMatrix2fv);
     if (gles_glUniformMatrix2fv) {
         gles_glUniformMatrix2fv(m->id, count, GL_FALSE, v);
@@ -597,14 +622,11 @@ void GoUniformMatrix3fv(program_t *glprogram, GLint location, GLsizei count, GLb
         errorShim(GL_INVALID_VALUE);
         return;
     }
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    uniform_t *m = getUniform(glprogram, location);
+    if (!m) {
         errorShim(GL_INVALID_OPERATION);
         return;
     }
-    m = kh_value(glprogram->uniform, k);
     if(m->type!=GL_FLOAT_MAT3  || count>m->size) {
         errorShim(GL_INVALID_OPERATION);
         return;
@@ -624,10 +646,13 @@ void GoUniformMatrix3fv(program_t *glprogram, GLint location, GLsizei count, GLb
     int rsize = sizeof(GLfloat)*3*3*count;
     if (memcmp((char*)glprogram->cache.cache + m->cache_offs, v, rsize)==0) {
         noerrorShim();
+        STATS_INC(uniforms_skipped);
         return; // nothing to do, same value already there
     }
     // update uniform
+    STATS_INC(uniforms_uploaded);
     memcpy((char*)glprogram->cache.cache + m->cache_offs, v, rsize);
+    uniformcache_touch(&glprogram->cache, m->cache_offs, rsize);
     LOAD_GLES2(glUniformMatrix3fv);
     if (gles_glUniformMatrix3fv) {
         gles_glUniformMatrix3fv(m->id, count, GL_FALSE, v);
@@ -661,14 +686,11 @@ void GoUniformMatrix4fv(program_t *glprogram, GLint location, GLsizei count, GLb
         errorShim(GL_INVALID_VALUE);
         return;
     }
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    uniform_t *m = getUniform(glprogram, location);
+    if (!m) {
         errorShim(GL_INVALID_OPERATION);
         return;
     }
-    m = kh_value(glprogram->uniform, k);
     if(m->type!=GL_FLOAT_MAT4  || count>m->size) {
         errorShim(GL_INVALID_OPERATION);
         return;
@@ -686,10 +708,13 @@ void GoUniformMatrix4fv(program_t *glprogram, GLint location, GLsizei count, GLb
     int rsize = sizeof(GLfloat)*4*4*count;
     if (memcmp((char*)glprogram->cache.cache + m->cache_offs, v, rsize)==0) {
         noerrorShim();
+        STATS_INC(uniforms_skipped);
         return; // nothing to do, same value already there
     }
     // update uniform
+    STATS_INC(uniforms_uploaded);
     memcpy((char*)glprogram->cache.cache + m->cache_offs, v, rsize);
+    uniformcache_touch(&glprogram->cache, m->cache_offs, rsize);
     LOAD_GLES2(glUniformMatrix4fv);
     if (gles_glUniformMatrix4fv) {
         gles_glUniformMatrix4fv(m->id, count, GL_FALSE, v);
@@ -707,13 +732,10 @@ int GetUniformi(program_t *glprogram, GLint location)
         return 0;
     }
 
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    uniform_t *m = getUniform(glprogram, location);
+    if (!m) {
         return 0;
     }
-    m = kh_value(glprogram->uniform, k);
 
     // ok, grab the value in the cache
     GLint ret;
@@ -728,13 +750,10 @@ const char* GetUniformName(program_t *glprogram, GLint location)
         return 0;
     }
 
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    uniform_t *m = getUniform(glprogram, location);
+    if (!m) {
         return 0;
     }
-    m = kh_value(glprogram->uniform, k);
 
     // ok, grab the value in the cache
     return m->name;
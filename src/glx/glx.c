@@ -32,6 +32,7 @@
 #ifdef PANDORA
 #include "../gl/pixel.h"
 #endif
+#include "../gl/stats.h"
 #include "glx_gbm.h"
 #include "hardext.h"
 #include "streaming.h"
@@ -1629,6 +1630,9 @@ void gl4es_glXSwapBuffers(Display *display,
         }
         last_frame = now;
     }
+    if(PBuffer==0) {
+        gl4es_statsEndFrame();
+    }
     if (globals4es.usefbo && PBuffer==0) {
         bindMainFBO();
     }